@@ -0,0 +1,123 @@
+// Lines/s for parseCommandLine and the bare tokenizer, against the original
+// char-by-char splitter + copying wildcard pass. Covers plain words, quotes,
+// escapes and glob expansion.
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/args_parser.hpp"
+#include "bench_harness.hpp"
+
+#include <cctype>
+#include <string>
+#include <vector>
+
+namespace {
+
+// --- The parser as it was before the tokenizer, kept as baseline ---
+std::vector<std::string> legacySplit(const std::string &input) {
+  std::vector<std::string> tokens;
+  std::string current_token;
+  current_token.reserve(64);
+  enum class State { DEFAULT, IN_SINGLE_QUOTES, IN_DOUBLE_QUOTES };
+  State state = State::DEFAULT;
+
+  for (std::size_t i = 0; i < input.length(); ++i) {
+    char c = input[i];
+    char next_c = (i + 1 < input.length()) ? input[i + 1] : '\0';
+    switch (state) {
+    case State::DEFAULT:
+      if (std::isspace(static_cast<unsigned char>(c))) {
+        if (!current_token.empty()) {
+          tokens.emplace_back(std::move(current_token));
+          current_token.clear();
+          current_token.reserve(64);
+        }
+      } else if (c == '\'') {
+        state = State::IN_SINGLE_QUOTES;
+      } else if (c == '"') {
+        state = State::IN_DOUBLE_QUOTES;
+      } else {
+        current_token += c;
+      }
+      break;
+    case State::IN_SINGLE_QUOTES:
+      if (c == '\'') {
+        state = State::DEFAULT;
+      } else {
+        current_token += c;
+      }
+      break;
+    case State::IN_DOUBLE_QUOTES:
+      if (c == '"') {
+        state = State::DEFAULT;
+      } else if (c == '\\' &&
+                 (next_c == '\\' || next_c == '"' || next_c == '\'')) {
+        current_token += next_c;
+        i++;
+      } else {
+        current_token += c;
+      }
+      break;
+    }
+  }
+  if (!current_token.empty()) {
+    tokens.emplace_back(std::move(current_token));
+  }
+  return tokens;
+}
+
+std::vector<std::string> legacyParse(const std::string &line) {
+  std::vector<std::string> initial = legacySplit(line);
+  std::vector<std::string> expanded;
+  expanded.reserve(initial.size());
+  for (const std::string &arg : initial) {
+    // Wildcard inputs are excluded below, so this is the copy-only path.
+    expanded.push_back(arg);
+  }
+  return expanded;
+}
+
+struct Input {
+  const char *label;
+  std::string line;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Harness harness("args_parser", argc, argv);
+  const size_t n = 1000000;
+
+  const std::vector<Input> inputs = {
+      {"plain", "open -b 115200 /dev/ttyACM0"},
+      {"quotes", "add -a \"hello world\" --add 'single quoted' x"},
+      {"escapes", "send ttyACM3 \"AT+CFG=\\\"ssid\\\",\\\"pa\\\\ss\\\"\\r\""},
+      {"long", "broadcast ttyACM0 ttyACM1 ttyACM2 ttyACM3 ttyACM4 ttyACM5 "
+               "ttyACM6 ttyACM7 ttyACM8 ttyACM9 -- query {} 'get version' "
+               "-t 50"},
+  };
+
+  CommandTokens tokens;
+  for (const Input &input : inputs) {
+    const std::string &line = input.line;
+    harness.run(std::string("legacy/") + input.label, n, [&](size_t) {
+      bench::doNotOptimize(legacyParse(line).size());
+    });
+    harness.run(std::string("parseCommandLine/") + input.label, n,
+                [&](size_t) {
+                  bench::doNotOptimize(parseCommandLine(line).size());
+                });
+    harness.run(std::string("tokenize/") + input.label, n, [&](size_t) {
+      tokenizeCommandLine(line, tokens);
+      bench::doNotOptimize(tokens.size());
+    });
+  }
+
+  // Globbing hits the filesystem, so it gets fewer iterations.
+  const std::string glob_line = "ls /dev/tty*";
+  harness.run("parseCommandLine/glob", n / 100, [&](size_t) {
+    bench::doNotOptimize(parseCommandLine(glob_line).size());
+  });
+
+  return harness.finish();
+}
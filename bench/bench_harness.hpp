@@ -0,0 +1,242 @@
+// Minimal benchmark harness shared by every bench/*.cpp.
+//
+// Each benchmark binary creates one Harness, times its cases through run()
+// (or measures them itself and hands the numbers to record()), and returns
+// finish(). Results are printed as a table and, with --json <file>, written
+// as JSON so runs from different releases can be diffed by tools.
+//
+// Common options:
+//   --json <file>     also write results as JSON ("-" for stdout)
+//   --filter <text>   only run cases whose name contains <text>
+//   --scale <factor>  multiply every iteration count (e.g. 0.1 for a smoke run)
+//   --repeat <n>      timed repetitions per case, the fastest is kept (def. 3)
+
+#ifndef BENCH_HARNESS_HPP
+#define BENCH_HARNESS_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the compiler from discarding a value computed only for timing.
+template <typename T> inline void doNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Extra named numbers attached to a result, e.g. {"p99_ns", 1234}.
+using Metrics = std::vector<std::pair<std::string, double>>;
+
+struct Result {
+  std::string name;
+  size_t iterations = 0;
+  double seconds = 0;        // fastest repetition
+  double median_seconds = 0; // median repetition
+  size_t bytes_per_op = 0;
+  Metrics metrics;
+
+  double nsPerOp() const {
+    return iterations ? seconds * 1e9 / static_cast<double>(iterations) : 0;
+  }
+  double opsPerSec() const {
+    return seconds > 0 ? static_cast<double>(iterations) / seconds : 0;
+  }
+  double bytesPerSec() const { return opsPerSec() * bytes_per_op; }
+};
+
+class Harness {
+public:
+  Harness(const char *suite, int argc, char **argv) : suite_(suite) {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+      if (arg == "--json" && value) {
+        json_path_ = value;
+      } else if (arg == "--filter" && value) {
+        filter_ = value;
+      } else if (arg == "--scale" && value) {
+        scale_ = std::strtod(value, nullptr);
+      } else if (arg == "--repeat" && value) {
+        repeat_ = std::max(1, std::atoi(value));
+      } else {
+        std::fprintf(stderr,
+                     "usage: %s [--json <file>] [--filter <text>] "
+                     "[--scale <factor>] [--repeat <n>]\n",
+                     argv[0]);
+        std::exit(2);
+      }
+      i++;
+    }
+    // With JSON on stdout the table moves to stderr.
+    table_ = json_path_ == "-" ? stderr : stdout;
+    std::fprintf(table_, "== %s ==\n", suite_);
+    std::fprintf(table_, "%-40s %12s %12s %14s %12s\n", "case", "iterations",
+                 "ns/op", "ops/s", "MB/s");
+  }
+
+  /** @brief Applies --scale to an iteration count (at least 1). */
+  size_t scaled(size_t iterations) const {
+    double n = static_cast<double>(iterations) * scale_;
+    return n < 1 ? 1 : static_cast<size_t>(n);
+  }
+
+  bool enabled(const std::string &name) const {
+    return filter_.empty() || name.find(filter_) != std::string::npos;
+  }
+
+  /**
+   * @brief Times body(i) for i in [0, iterations), --repeat times, after a
+   *        short warm-up. iterations is scaled by --scale.
+   */
+  template <typename F>
+  void run(const std::string &name, size_t iterations, F &&body,
+           size_t bytes_per_op = 0) {
+    if (!enabled(name)) {
+      return;
+    }
+    iterations = scaled(iterations);
+
+    for (size_t i = 0; i < iterations / 10; i++) {
+      body(i);
+    }
+
+    std::vector<double> times;
+    for (int r = 0; r < repeat_; r++) {
+      auto start = Clock::now();
+      for (size_t i = 0; i < iterations; i++) {
+        body(i);
+      }
+      times.push_back(secondsSince(start));
+    }
+    std::sort(times.begin(), times.end());
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.seconds = times.front();
+    result.median_seconds = times[times.size() / 2];
+    result.bytes_per_op = bytes_per_op;
+    add(std::move(result));
+  }
+
+  /**
+   * @brief Records a case the benchmark timed itself (threads, flushes, ...).
+   *        Skipped cases (see enabled()) should not be measured at all.
+   */
+  void record(const std::string &name, size_t iterations, double seconds,
+              size_t bytes_per_op = 0, Metrics metrics = {}) {
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.seconds = seconds;
+    result.median_seconds = seconds;
+    result.bytes_per_op = bytes_per_op;
+    result.metrics = std::move(metrics);
+    add(std::move(result));
+  }
+
+  /** @brief Writes the JSON file if requested; returns main()'s status. */
+  int finish() const {
+    if (json_path_.empty()) {
+      return 0;
+    }
+    FILE *out =
+        json_path_ == "-" ? stdout : std::fopen(json_path_.c_str(), "w");
+    if (out == nullptr) {
+      std::fprintf(stderr, "cannot write %s: %s\n", json_path_.c_str(),
+                   std::strerror(errno));
+      return 1;
+    }
+    writeJson(out);
+    if (out != stdout) {
+      std::fclose(out);
+    }
+    return 0;
+  }
+
+private:
+  const char *suite_;
+  std::string json_path_;
+  std::string filter_;
+  double scale_ = 1.0;
+  int repeat_ = 3;
+  FILE *table_ = stdout;
+  std::vector<Result> results_;
+
+  void add(Result result) {
+    std::fprintf(table_, "%-40s %12zu %12.1f %14.0f ", result.name.c_str(),
+                 result.iterations, result.nsPerOp(), result.opsPerSec());
+    if (result.bytes_per_op) {
+      std::fprintf(table_, "%12.1f", result.bytesPerSec() / 1e6);
+    } else {
+      std::fprintf(table_, "%12s", "-");
+    }
+    for (const auto &metric : result.metrics) {
+      std::fprintf(table_, "  %s=%.0f", metric.first.c_str(), metric.second);
+    }
+    std::fprintf(table_, "\n");
+    std::fflush(table_);
+    results_.push_back(std::move(result));
+  }
+
+  static void writeString(FILE *out, const std::string &text) {
+    std::fputc('"', out);
+    for (char c : text) {
+      if (c == '"' || c == '\\') {
+        std::fputc('\\', out);
+      }
+      std::fputc(c, out);
+    }
+    std::fputc('"', out);
+  }
+
+  void writeJson(FILE *out) const {
+    std::fprintf(out, "{\n  \"suite\": ");
+    writeString(out, suite_);
+    std::fprintf(out, ",\n  \"timestamp\": %lld,\n  \"compiler\": ",
+                 static_cast<long long>(std::time(nullptr)));
+    writeString(out, __VERSION__);
+    std::fprintf(out, ",\n  \"scale\": %g,\n  \"repeat\": %d,\n"
+                      "  \"results\": [",
+                 scale_, repeat_);
+    for (size_t i = 0; i < results_.size(); i++) {
+      const Result &r = results_[i];
+      std::fprintf(out, "%s\n    {\"name\": ", i ? "," : "");
+      writeString(out, r.name);
+      std::fprintf(out,
+                   ", \"iterations\": %zu, \"seconds\": %.9g, "
+                   "\"median_seconds\": %.9g, \"ns_per_op\": %.6g, "
+                   "\"ops_per_sec\": %.6g",
+                   r.iterations, r.seconds, r.median_seconds, r.nsPerOp(),
+                   r.opsPerSec());
+      if (r.bytes_per_op) {
+        std::fprintf(out, ", \"bytes_per_sec\": %.6g", r.bytesPerSec());
+      }
+      for (const auto &metric : r.metrics) {
+        std::fprintf(out, ", ");
+        writeString(out, metric.first);
+        std::fprintf(out, ": %.6g", metric.second);
+      }
+      std::fprintf(out, "}");
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+  }
+};
+
+} // namespace bench
+
+#endif // BENCH_HARNESS_HPP
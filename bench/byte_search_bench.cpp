@@ -0,0 +1,120 @@
+// Pattern search throughput for `cgrep`.
+//
+// literal/*: one Searcher::scan() over a 4 MiB random buffer holding a
+// 14-byte needle every 64 KiB, at every scan level the CPU supports.
+// record/*: the same bytes scanned as 64-byte capture records, one scan()
+// call each; one op is one record.
+// regex/*: a log-like text scanned with a regex that starts with literal
+// text (prefixed), merely contains some (filtered), or has none (lines).
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/byte_search.hpp"
+#include "bench_harness.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t BUFFER = 4u << 20;
+const size_t NEEDLE_SPACING = 64 * 1024;
+const size_t RECORD = 64;
+const size_t TEXT_LINES = 20000;
+const char NEEDLE[] = "FIRMWARE_PANIC";
+
+std::vector<uint8_t> randomBuffer() {
+  std::mt19937 rng(42);
+  std::vector<uint8_t> buffer(BUFFER);
+  for (uint8_t &byte : buffer) {
+    byte = static_cast<uint8_t>(rng());
+  }
+  for (size_t at = NEEDLE_SPACING / 2; at + sizeof(NEEDLE) < BUFFER;
+       at += NEEDLE_SPACING) {
+    std::copy(NEEDLE, NEEDLE + sizeof(NEEDLE) - 1, buffer.begin() + at);
+  }
+  return buffer;
+}
+
+std::vector<uint8_t> logText() {
+  std::mt19937 rng(7);
+  const char *levels[] = {"INFO", "WARN", "ERROR"};
+  std::string text;
+  char line[96];
+  for (size_t i = 0; i < TEXT_LINES; i++) {
+    std::snprintf(line, sizeof(line), "%zu ts=%zu level=%s msg=temp %u\n", i,
+                  i * 7, levels[rng() % 3], static_cast<unsigned>(rng() % 100));
+    text += line;
+  }
+  return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+void benchLiteral(bench::Harness &harness,
+                  const std::vector<uint8_t> &buffer) {
+  byte_search::Searcher searcher;
+  std::string error;
+  searcher.compileLiteral(
+      std::vector<uint8_t>(NEEDLE, NEEDLE + sizeof(NEEDLE) - 1), error);
+  size_t found = 0;
+  byte_search::Searcher::Sink sink = [&found](size_t, size_t) { found++; };
+
+  for (byte_search::ScanLevel level :
+       {byte_search::ScanLevel::SCALAR, byte_search::ScanLevel::SSE2,
+        byte_search::ScanLevel::AVX2}) {
+    if (!byte_search::setScanLevel(level)) {
+      continue;
+    }
+    std::string suffix = byte_search::scanLevelName(level);
+    harness.run("literal/" + suffix + "/4MiB", 40,
+                [&](size_t) {
+                  bench::doNotOptimize(searcher.scan(
+                      buffer.data(), buffer.size(), buffer.size(), sink));
+                },
+                BUFFER);
+    harness.run("record/" + suffix + "/64B", BUFFER / RECORD,
+                [&](size_t i) {
+                  const uint8_t *record = buffer.data() + i * RECORD;
+                  bench::doNotOptimize(
+                      searcher.scan(record, RECORD, RECORD, sink));
+                },
+                RECORD);
+  }
+  byte_search::setScanLevel(byte_search::bestScanLevel());
+  bench::doNotOptimize(found);
+}
+
+void benchRegex(bench::Harness &harness, const std::vector<uint8_t> &text,
+                const std::string &name, const std::string &expression) {
+  byte_search::Searcher searcher;
+  std::string error;
+  if (!searcher.compileRegex(expression, error)) {
+    std::fprintf(stderr, "%s: %s\n", expression.c_str(), error.c_str());
+    return;
+  }
+  size_t found = 0;
+  byte_search::Searcher::Sink sink = [&found](size_t, size_t) { found++; };
+  harness.run("regex/" + name, 5,
+              [&](size_t) {
+                bench::doNotOptimize(
+                    searcher.scan(text.data(), text.size(), text.size(), sink));
+              },
+              text.size());
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Harness harness("byte_search", argc, argv);
+  std::fprintf(stderr, "scan level: %s\n",
+               byte_search::scanLevelName(byte_search::bestScanLevel()));
+
+  benchLiteral(harness, randomBuffer());
+  std::vector<uint8_t> text = logText();
+  benchRegex(harness, text, "prefixed", "level=ERROR msg=temp 9[0-9]");
+  benchRegex(harness, text, "filtered", "[0-9]+ ts=[0-9]+ level=WARN");
+  benchRegex(harness, text, "lines", "[0-9]{3} level");
+  return harness.finish();
+}
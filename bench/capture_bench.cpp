@@ -0,0 +1,83 @@
+// Cost of capturing port traffic: capture::Writer::append() as the I/O
+// thread calls it for 30 ports, with the writer thread streaming blocks
+// to a scratch file, then Reader::seek() into the result.
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/capture_file.hpp"
+#include "bench_harness.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+const size_t PORTS = 30;
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Harness harness("capture", argc, argv);
+  std::string path = "/tmp/uconnux-capture-bench." +
+                     std::to_string(getpid()) + ".ucap";
+
+  std::vector<std::string> names;
+  for (size_t i = 0; i < PORTS; i++) {
+    names.push_back("ttyUSB" + std::to_string(i));
+  }
+  std::vector<uint8_t> payload(4096, 0x5A);
+
+  for (size_t chunk : {size_t(64), size_t(4096)}) {
+    std::string name = "append/30-ports/" + std::to_string(chunk) + "B";
+    // The 64-byte capture doubles as the file "seek" searches.
+    if (!harness.enabled(name) && !(chunk == 64 && harness.enabled("seek"))) {
+      continue;
+    }
+    capture::Writer writer;
+    std::string error;
+    if (!writer.open(path, error)) {
+      std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+      return 1;
+    }
+    size_t n = harness.scaled(chunk == 64 ? 4000000 : 200000);
+    // Simulated clock, 1 us per chunk, from the writer's own origin.
+    uint64_t now = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+    auto start = bench::Clock::now();
+    for (size_t i = 0; i < n; i++) {
+      now += 1000;
+      writer.append(names[i % PORTS], i & 1 ? capture::TX : capture::RX,
+                    payload.data(), chunk, now);
+    }
+    // Until the last byte is on disk, as `capture stop` waits.
+    bool closed = writer.close(error);
+    if (!harness.enabled(name)) {
+      continue;
+    }
+    harness.record(name, n, bench::secondsSince(start), chunk,
+                   {{"closed", closed ? 1.0 : 0.0},
+                    {"peak_blocks",
+                     static_cast<double>(
+                         writer.stats().peak_queued_blocks)}});
+  }
+
+  capture::Reader reader;
+  std::string error;
+  if (harness.enabled("seek") && reader.open(path, error) &&
+      reader.endNs() > 0) {
+    std::mt19937_64 rng(5);
+    std::uniform_int_distribution<uint64_t> when(0, reader.endNs());
+    harness.run("seek", 200000, [&](size_t) {
+      bench::doNotOptimize(reader.seek(when(rng)));
+    });
+  }
+  std::remove(path.c_str());
+  return harness.finish();
+}
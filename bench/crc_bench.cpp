@@ -0,0 +1,60 @@
+// Checksum throughput for every CRC algorithm on every engine the CPU
+// supports: the bitwise reference, slice-by-8 tables and the hardware path
+// (PCLMULQDQ folding for CRC-32, the crc32 instruction for CRC-32C).
+//
+// Cases cover a 64 KiB block (bulk file/flash data) and a 64 byte block
+// (a typical serial frame). Read the MB/s column as GB/s * 1000.
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/crc.hpp"
+#include "bench_harness.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+  bench::Harness harness("crc", argc, argv);
+
+  std::vector<uint8_t> data(64 * 1024);
+  std::mt19937 rng(7);
+  for (uint8_t &byte : data) {
+    byte = static_cast<uint8_t>(rng());
+  }
+
+  std::string failure;
+  if (!crc::selfTest(failure)) {
+    std::fprintf(stderr, "self-test failed: %s\n", failure.c_str());
+    return 1;
+  }
+
+  for (size_t block : {size_t(64), data.size()}) {
+    for (size_t a = 0; a < crc::ALGORITHM_COUNT; a++) {
+      crc::Algorithm algorithm = static_cast<crc::Algorithm>(a);
+      for (crc::Engine engine : {crc::Engine::BITWISE, crc::Engine::SLICE8,
+                                 crc::Engine::HARDWARE}) {
+        if (!crc::setEngine(engine) || crc::engineFor(algorithm) != engine) {
+          continue;
+        }
+        // The bitwise engine is ~100x slower; keep its runs short.
+        size_t bytes_per_run = engine == crc::Engine::BITWISE ? 16 << 20
+                                                              : 1024 << 20;
+        std::string name = std::string(crc::algorithmName(algorithm)) + "/" +
+                           crc::engineName(engine) + "/" +
+                           std::to_string(block) + "B";
+        harness.run(name, bytes_per_run / block,
+                    [&](size_t i) {
+                      size_t offset = (i * block) % data.size();
+                      bench::doNotOptimize(
+                          crc::compute(algorithm, data.data() + offset, block));
+                    },
+                    block);
+      }
+    }
+  }
+  crc::setEngine(crc::bestEngine());
+  return harness.finish();
+}
@@ -0,0 +1,77 @@
+// Command dispatch: CommandRegistry::executeCommand against the std::map
+// lookup it replaced, for registries of 8, 64 and 512 commands, plus the
+// whole parseCommandLine + executeCommand path for one scripted line.
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/args_parser.hpp"
+#include "../include/command_registry.hpp"
+#include "../include/icommand.hpp"
+#include "bench_harness.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+class NopCommand : public ICommand {
+private:
+  std::string name_;
+
+public:
+  explicit NopCommand(std::string name) : name_(std::move(name)) {}
+  std::string getName() const override { return name_; }
+  std::string getDescription() const override { return "no-op"; }
+  int execute(const std::vector<std::string> &arguments) override {
+    return static_cast<int>(arguments.size()) - 1;
+  }
+};
+
+// Realistic-looking names with shared prefixes, like a grown CLI would have.
+std::string commandName(size_t i) {
+  static const char *const STEMS[] = {"port", "flash", "send", "query",
+                                      "trace", "stats", "capture", "replay"};
+  return std::string(STEMS[i % 8]) + (i < 8 ? "" : std::to_string(i / 8));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Harness harness("dispatch", argc, argv);
+  const size_t n = 2000000;
+
+  for (size_t count : {8, 64, 512}) {
+    CommandRegistry registry;
+    std::map<std::string, ICommand *> legacy_map;
+    std::vector<std::vector<std::string>> lines;
+    for (size_t i = 0; i < count; i++) {
+      registry.registerCommand<NopCommand>(commandName(i));
+      lines.push_back({commandName(i), "ttyACM0"});
+    }
+    for (const auto &entry : registry.getCommands()) {
+      legacy_map[entry.first] = entry.second;
+    }
+
+    std::string suffix = "/" + std::to_string(count);
+    harness.run("map_lookup" + suffix, n, [&](size_t i) {
+      const std::vector<std::string> &line = lines[i % count];
+      auto it = legacy_map.find(line[0]);
+      bench::doNotOptimize(it->second->execute(line));
+    });
+    harness.run("executeCommand" + suffix, n, [&](size_t i) {
+      bench::doNotOptimize(registry.executeCommand(lines[i % count]));
+    });
+  }
+
+  CommandRegistry registry;
+  for (size_t i = 0; i < 64; i++) {
+    registry.registerCommand<NopCommand>(commandName(i));
+  }
+  const std::string line = "query3 -t 50 ttyACM0 \"get version\"";
+  harness.run("parse+execute", n, [&](size_t) {
+    bench::doNotOptimize(registry.executeCommand(parseCommandLine(line)));
+  });
+
+  return harness.finish();
+}
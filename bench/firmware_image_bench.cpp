@@ -0,0 +1,193 @@
+// Record file loading: the hex digit decoder at every level the CPU
+// supports, and whole Intel HEX / S-record images through FirmwareImage on
+// 1, 2 and 4 threads.
+//
+// decode/*: 64 KiB of hex text to 32 KiB of bytes. MB/s counts text.
+// load/*: a generated 4 MiB image (32-byte records, ~11 MiB of text) in a
+// temporary file, read through the page cache. One op is one whole load.
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/firmware_image.hpp"
+#include "../include/hex_codec.hpp"
+#include "bench_harness.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const size_t IMAGE_BYTES = 4u << 20;
+const size_t RECORD_BYTES = 32;
+
+void appendHex(std::string &text, const uint8_t *data, size_t len) {
+  static const char DIGITS[] = "0123456789ABCDEF";
+  for (size_t i = 0; i < len; i++) {
+    text += DIGITS[data[i] >> 4];
+    text += DIGITS[data[i] & 0xF];
+  }
+}
+
+std::string intelHex(const std::vector<uint8_t> &image, uint32_t base) {
+  std::string text;
+  uint32_t upper = ~0u;
+  for (size_t i = 0; i < image.size(); i += RECORD_BYTES) {
+    uint32_t address = base + static_cast<uint32_t>(i);
+    std::vector<uint8_t> record;
+    if (address >> 16 != upper) {
+      upper = address >> 16;
+      record = {2, 0, 0, 4, static_cast<uint8_t>(upper >> 8),
+                static_cast<uint8_t>(upper)};
+      uint8_t sum = 0;
+      for (uint8_t byte : record) {
+        sum = static_cast<uint8_t>(sum + byte);
+      }
+      record.push_back(static_cast<uint8_t>(-sum));
+      text += ':';
+      appendHex(text, record.data(), record.size());
+      text += "\r\n";
+    }
+    record = {static_cast<uint8_t>(RECORD_BYTES),
+              static_cast<uint8_t>(address >> 8),
+              static_cast<uint8_t>(address), 0};
+    record.insert(record.end(), image.begin() + i,
+                  image.begin() + i + RECORD_BYTES);
+    uint8_t sum = 0;
+    for (uint8_t byte : record) {
+      sum = static_cast<uint8_t>(sum + byte);
+    }
+    record.push_back(static_cast<uint8_t>(-sum));
+    text += ':';
+    appendHex(text, record.data(), record.size());
+    text += "\r\n";
+  }
+  text += ":00000001FF\r\n";
+  return text;
+}
+
+std::string srec(const std::vector<uint8_t> &image, uint32_t base) {
+  std::string text;
+  for (size_t i = 0; i < image.size(); i += RECORD_BYTES) {
+    uint32_t address = base + static_cast<uint32_t>(i);
+    std::vector<uint8_t> record = {
+        static_cast<uint8_t>(RECORD_BYTES + 5),
+        static_cast<uint8_t>(address >> 24),
+        static_cast<uint8_t>(address >> 16),
+        static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address)};
+    record.insert(record.end(), image.begin() + i,
+                  image.begin() + i + RECORD_BYTES);
+    uint8_t sum = 0;
+    for (uint8_t byte : record) {
+      sum = static_cast<uint8_t>(sum + byte);
+    }
+    record.push_back(static_cast<uint8_t>(~sum));
+    text += "S3";
+    appendHex(text, record.data(), record.size());
+    text += '\n';
+  }
+  text += "S70500000000FA\n";
+  return text;
+}
+
+bool writeTemp(const std::string &text, const char *suffix,
+               std::string &path) {
+  char name[] = "/tmp/uconnux-bench-XXXXXX";
+  int fd = ::mkstemp(name);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = ::write(fd, text.data(), text.size()) ==
+            static_cast<ssize_t>(text.size());
+  ::close(fd);
+  path = std::string(name) + suffix;
+  ok = ok && std::rename(name, path.c_str()) == 0;
+  if (!ok) {
+    std::remove(name);
+  }
+  return ok;
+}
+
+void benchDecode(bench::Harness &harness, const std::string &text) {
+  const size_t chars = 64 * 1024;
+  std::vector<uint8_t> out(chars / 2);
+  // Pure digits: skip the record punctuation.
+  std::string digits;
+  for (char c : text) {
+    if (c != ':' && c != '\r' && c != '\n') {
+      digits += c;
+    }
+    if (digits.size() == chars) {
+      break;
+    }
+  }
+  const uint8_t *in = reinterpret_cast<const uint8_t *>(digits.data());
+
+  for (hex_codec::DecodeLevel level :
+       {hex_codec::DecodeLevel::SCALAR, hex_codec::DecodeLevel::SSE2,
+        hex_codec::DecodeLevel::AVX2}) {
+    if (!hex_codec::setDecodeLevel(level)) {
+      continue;
+    }
+    harness.run(std::string("decode/") + hex_codec::decodeLevelName(level) +
+                    "/64KiB",
+                20000,
+                [&](size_t) {
+                  bench::doNotOptimize(
+                      hex_codec::decode(in, out.size(), out.data()));
+                },
+                chars);
+  }
+  hex_codec::setDecodeLevel(hex_codec::bestDecodeLevel());
+}
+
+void benchLoad(bench::Harness &harness, const char *format,
+               const std::string &path, size_t text_bytes) {
+  for (unsigned threads : {1u, 2u, 4u}) {
+    harness.run(std::string("load/") + format + "/" + std::to_string(threads) +
+                    "t",
+                20,
+                [&](size_t) {
+                  FirmwareImage image;
+                  std::string error;
+                  if (!image.load(path, 0, error, threads)) {
+                    std::fprintf(stderr, "load failed: %s\n", error.c_str());
+                    std::exit(1);
+                  }
+                  bench::doNotOptimize(image.size());
+                },
+                text_bytes);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Harness harness("firmware_image", argc, argv);
+
+  std::vector<uint8_t> image(IMAGE_BYTES);
+  std::mt19937 rng(3);
+  for (uint8_t &byte : image) {
+    byte = static_cast<uint8_t>(rng());
+  }
+  std::string hex = intelHex(image, 0x08000000);
+  std::string s37 = srec(image, 0x08000000);
+
+  benchDecode(harness, hex);
+
+  std::string hex_path;
+  std::string srec_path;
+  if (!writeTemp(hex, ".hex", hex_path) ||
+      !writeTemp(s37, ".srec", srec_path)) {
+    std::fprintf(stderr, "cannot write temporary files\n");
+    return 1;
+  }
+  benchLoad(harness, "ihex", hex_path, hex.size());
+  benchLoad(harness, "srec", srec_path, s37.size());
+  std::remove(hex_path.c_str());
+  std::remove(srec_path.c_str());
+  return harness.finish();
+}
@@ -0,0 +1,142 @@
+// Delimiter scan and frame decode throughput for the RX framing layer.
+//
+// scan/*: findByte() over a buffer with no match, at every scan level the
+// CPU supports, against memchr().
+// decode/*: frames/s through FrameDecoder for newline, COBS and SLIP streams
+// of fixed-size frames, fed in 4 KiB chunks like RX ring spans. One op is
+// one frame.
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/frame_decoder.hpp"
+#include "bench_harness.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t SCAN_BUFFER = 64 * 1024;
+const size_t STREAM_BYTES = 1u << 20;
+const size_t CHUNK = 4096;
+
+void benchScan(bench::Harness &harness) {
+  std::vector<uint8_t> buffer(SCAN_BUFFER, 'a');
+  const uint8_t *begin = buffer.data();
+  const uint8_t *end = begin + buffer.size();
+  const size_t iterations = 20000;
+
+  for (framing::ScanLevel level :
+       {framing::ScanLevel::SCALAR, framing::ScanLevel::SSE2,
+        framing::ScanLevel::AVX2}) {
+    if (!framing::setScanLevel(level)) {
+      continue;
+    }
+    harness.run(std::string("scan/") + framing::scanLevelName(level) + "/64KiB",
+                iterations,
+                [&](size_t) {
+                  bench::doNotOptimize(framing::findByte(begin, end, 0));
+                },
+                SCAN_BUFFER);
+  }
+  framing::setScanLevel(framing::bestScanLevel());
+
+  harness.run("scan/memchr/64KiB", iterations,
+              [&](size_t) {
+                bench::doNotOptimize(std::memchr(begin, 0, SCAN_BUFFER));
+              },
+              SCAN_BUFFER);
+}
+
+// Builds a stream of whole frames of frame_size payload bytes.
+size_t buildStream(framing::Framing mode, size_t frame_size,
+                   std::vector<uint8_t> &stream) {
+  std::mt19937 rng(42);
+  std::vector<uint8_t> payload(frame_size);
+  size_t frames = 0;
+  stream.clear();
+  while (stream.size() < STREAM_BYTES) {
+    for (uint8_t &byte : payload) {
+      byte = static_cast<uint8_t>(rng());
+    }
+    switch (mode) {
+    case framing::Framing::LINE:
+      for (uint8_t &byte : payload) {
+        byte = static_cast<uint8_t>(' ' + byte % 95); // printable, no '\n'
+      }
+      stream.insert(stream.end(), payload.begin(), payload.end());
+      stream.push_back('\n');
+      break;
+    case framing::Framing::COBS:
+      framing::cobsEncode(payload.data(), payload.size(), stream);
+      break;
+    case framing::Framing::SLIP:
+      framing::slipEncode(payload.data(), payload.size(), stream);
+      break;
+    case framing::Framing::RAW:
+      break;
+    }
+    frames++;
+  }
+  return frames;
+}
+
+void benchDecode(bench::Harness &harness, framing::Framing mode,
+                 size_t frame_size) {
+  std::string name = std::string("decode/") + framing::framingName(mode) +
+                     "/" + std::to_string(frame_size) + "B";
+  if (!harness.enabled(name)) {
+    return;
+  }
+
+  std::vector<uint8_t> pristine;
+  size_t frames_per_pass = buildStream(mode, frame_size, pristine);
+  std::vector<uint8_t> work(pristine.size());
+  size_t passes = harness.scaled(20);
+
+  framing::FrameDecoder decoder(mode);
+  size_t delivered = 0;
+  double seconds = 0;
+  for (size_t pass = 0; pass < passes; pass++) {
+    // Decoding is in place, so every pass starts from a fresh copy. The copy
+    // is not timed.
+    std::memcpy(work.data(), pristine.data(), pristine.size());
+    auto start = bench::Clock::now();
+    for (size_t offset = 0; offset < work.size(); offset += CHUNK) {
+      size_t len = std::min(CHUNK, work.size() - offset);
+      decoder.feed(work.data() + offset, len,
+                   [&](const framing::FrameView &frame) {
+                     bench::doNotOptimize(frame.data);
+                     delivered++;
+                   });
+    }
+    seconds += bench::secondsSince(start);
+  }
+
+  size_t frames = frames_per_pass * passes;
+  harness.record(name, frames, seconds, pristine.size() / frames_per_pass,
+                 {{"errors", static_cast<double>(decoder.errors())},
+                  {"lost", static_cast<double>(frames - delivered)}});
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Harness harness("frame_decoder", argc, argv);
+  std::fprintf(stderr, "scan level: %s\n",
+               framing::scanLevelName(framing::bestScanLevel()));
+
+  benchScan(harness);
+  for (framing::Framing mode : {framing::Framing::LINE, framing::Framing::COBS,
+                                framing::Framing::SLIP}) {
+    for (size_t frame_size : {16, 64, 256, 1024}) {
+      benchDecode(harness, mode, frame_size);
+    }
+  }
+  return harness.finish();
+}
@@ -0,0 +1,64 @@
+// Cost of the always-on statistics: LatencyHistogram::record() from one
+// thread and from four threads hammering the same histogram (what several
+// jobs timing one port do), plus a snapshot and p50/p99/p999 query as
+// `stats` takes it once per port and refresh.
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/latency_histogram.hpp"
+#include "bench_harness.hpp"
+
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const size_t SAMPLES = 4096; // power of two
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Harness harness("latency_histogram", argc, argv);
+
+  // Round trips between 100us and 50ms, as a serial device produces.
+  std::vector<uint64_t> samples(SAMPLES);
+  std::mt19937_64 rng(3);
+  std::lognormal_distribution<double> spread(14.0, 1.0);
+  for (uint64_t &sample : samples) {
+    sample = static_cast<uint64_t>(spread(rng));
+  }
+
+  LatencyHistogram histogram;
+  harness.run("record/1-thread", 50000000, [&](size_t i) {
+    histogram.record(samples[i & (SAMPLES - 1)]);
+  });
+
+  // One op is one record() on any thread; ns/op is wall time per record.
+  const size_t THREADS = 4;
+  if (harness.enabled("record/4-threads")) {
+    size_t per_thread = harness.scaled(10000000);
+    auto start = bench::Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; t++) {
+      threads.emplace_back([&, t] {
+        for (size_t i = 0; i < per_thread; i++) {
+          histogram.record(samples[(i + t * 997) & (SAMPLES - 1)]);
+        }
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    harness.record("record/4-threads", per_thread * THREADS,
+                   bench::secondsSince(start));
+  }
+
+  harness.run("snapshot+quantiles", 20000, [&](size_t) {
+    LatencyHistogram::Snapshot snap = histogram.snapshot();
+    bench::doNotOptimize(snap.quantile(0.5) + snap.quantile(0.99) +
+                         snap.quantile(0.999));
+  });
+  return harness.finish();
+}
@@ -0,0 +1,95 @@
+// Lines/s for the Logger against the original synchronous implementation
+// (mutex + std::stringstream + std::endl per line), plus the bare formatting
+// cost of FormatBuffer versus std::stringstream. The loggers each write 10M
+// lines to /dev/null.
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/log_format.hpp"
+#include "../include/logger.hpp"
+#include "../include/theme.hpp"
+#include "bench_harness.hpp"
+
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// The Logger as it was before the async backend, kept verbatim as baseline.
+class LegacyLogger {
+private:
+  std::ostream &output_stream;
+  std::mutex log_mutex;
+
+  std::string setColor() const {
+    return std::string(term_style::THEME_INFO_LABEL);
+  }
+
+public:
+  explicit LegacyLogger(std::ostream &stream) : output_stream(stream) {}
+
+  template <typename... Args> void info(Args &&...args) {
+    std::lock_guard<std::mutex> lock(log_mutex);
+    output_stream << setColor();
+    output_stream << "▐ " << std::flush;
+    std::stringstream ss;
+    using List = int[];
+    (void)List{0, ((void)(ss << args), 0)...};
+    output_stream << ss.str();
+    output_stream << std::endl;
+  }
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Harness harness("logger", argc, argv);
+  // Lines per whole-logger run; --scale shrinks it for quick runs.
+  const size_t count = harness.scaled(10000000);
+  // The bare formatting cases are repeated, so they get fewer lines.
+  const size_t n = 2000000;
+  std::ofstream devnull("/dev/null");
+
+  harness.run("format/stringstream", n, [](size_t i) {
+    std::stringstream ss;
+    ss << "port ttyACM" << (i & 31) << " rx " << i << " bytes, " << 0.5 * i
+       << " ms";
+    bench::doNotOptimize(ss.str().size());
+  });
+
+  harness.run("format/FormatBuffer", n, [](size_t i) {
+    log_fmt::BufferLease lease;
+    log_fmt::appendAll(lease.get(), "port ttyACM", i & 31, " rx ", i,
+                       " bytes, ", 0.5 * i, " ms");
+    bench::doNotOptimize(lease.get().size());
+  });
+
+  // Whole-logger cases write to /dev/null and are timed once each.
+  if (harness.enabled("legacy Logger")) {
+    LegacyLogger legacy(devnull);
+    auto start = bench::Clock::now();
+    for (size_t i = 0; i < count; i++) {
+      legacy.info("port ttyACM", i & 31, " rx ", i, " bytes, ", 0.5 * i,
+                  " ms");
+    }
+    harness.record("legacy Logger", count, bench::secondsSince(start));
+  }
+
+  if (harness.enabled("async Logger")) {
+    Logger async_logger(devnull);
+    auto start = bench::Clock::now();
+    for (size_t i = 0; i < count; i++) {
+      async_logger.info("port ttyACM", i & 31, " rx ", i, " bytes, ", 0.5 * i,
+                        " ms");
+    }
+    double submit = bench::secondsSince(start);
+    async_logger.flush();
+    harness.record("async Logger (submit)", count, submit);
+    harness.record("async Logger (flushed)", count,
+                   bench::secondsSince(start));
+  }
+
+  return harness.finish();
+}
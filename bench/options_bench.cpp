@@ -0,0 +1,75 @@
+// Per-command-line cost of option parsing: the runtime-built OptionsParser
+// against a constexpr OptionTable, on short, long, --name=value and bundled
+// spellings.
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/args_opt.hpp"
+#include "bench_harness.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'b', "baud", ArgumentOptions::REQ_ARG, ValueType::BAUD},
+    {'p', "pty", ArgumentOptions::NO_ARG, ValueType::STRING},
+    {'t', "timeout", ArgumentOptions::REQ_ARG, ValueType::DURATION},
+    {'x', "hex", ArgumentOptions::REQ_ARG, ValueType::HEX_BYTES},
+    {'v', "verbose", ArgumentOptions::NO_ARG, ValueType::STRING},
+    {'k', "keep-going", ArgumentOptions::NO_ARG, ValueType::STRING},
+});
+
+struct Input {
+  const char *label;
+  std::vector<std::string> args;
+  bool legacy; // the old parser only understands "-x" and "--name"
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Harness harness("options", argc, argv);
+  const size_t n = 2000000;
+
+  const std::vector<Input> inputs = {
+      {"short", {"open", "-b", "115200", "-v", "/dev/ttyACM0"}, true},
+      {"long",
+       {"open", "--baud", "115200", "--timeout", "250ms", "--verbose",
+        "--keep-going", "/dev/ttyACM0"},
+       true},
+      {"equals", {"open", "--baud=115200", "--hex=de:ad:be:ef", "x"}, false},
+      {"bundled", {"open", "-vkb115200", "/dev/ttyACM0"}, false},
+  };
+
+  opt_parser::OptionsParser parser;
+  parser.addOption('b', "baud", ArgumentOptions::REQ_ARG);
+  parser.addOption('p', "pty", ArgumentOptions::NO_ARG);
+  parser.addOption('t', "timeout", ArgumentOptions::REQ_ARG);
+  parser.addOption('x', "hex", ArgumentOptions::REQ_ARG);
+  parser.addOption('v', "verbose", ArgumentOptions::NO_ARG);
+  parser.addOption('k', "keep-going", ArgumentOptions::NO_ARG);
+
+  for (const Input &input : inputs) {
+    const std::vector<std::string> &args = input.args;
+    if (input.legacy) {
+      harness.run(std::string("OptionsParser/") + input.label, n,
+                  [&](size_t) {
+                    int first = parser.parseOptionsString(args);
+                    bench::doNotOptimize(first);
+                    bench::doNotOptimize(parser.findOption('b')->get_found());
+                  });
+    }
+    harness.run(std::string("OptionTable/") + input.label, n, [&](size_t) {
+      opt_parser::ParsedOptions options = OPTIONS.parse(args);
+      bench::doNotOptimize(options.firstPositional());
+      bench::doNotOptimize(options.baud('b', 0));
+    });
+  }
+
+  return harness.finish();
+}
@@ -0,0 +1,146 @@
+// Throughput/latency microbenchmark for SpscRing against the mutex +
+// std::vector handoff it replaced on the port RX/TX paths.
+//
+// Build and run with `make bench`. Options: see bench_harness.hpp.
+
+#include "../include/spsc_ring.hpp"
+#include "bench_harness.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+size_t TOTAL_BYTES = 64u << 20; // --scale applies
+const size_t RING_SIZE = 1u << 20;
+const size_t MAX_SAMPLES = 1u << 20;
+
+uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+struct Result {
+  double seconds;
+  std::vector<uint64_t> latencies;
+};
+
+// Producer stamps each chunk with its send time; the consumer reads whole
+// chunks back and records how long each one sat in the queue.
+template <typename Push, typename Pop>
+Result runPair(size_t chunk, Push push, Pop pop) {
+  Result result;
+  result.latencies.reserve(MAX_SAMPLES);
+  size_t chunks = TOTAL_BYTES / chunk;
+
+  auto start = Clock::now();
+  std::thread producer([&]() {
+    std::vector<uint8_t> buf(chunk, 0xA5);
+    for (size_t i = 0; i < chunks; i++) {
+      uint64_t stamp = nowNs();
+      std::memcpy(buf.data(), &stamp, sizeof(stamp));
+      size_t sent = 0;
+      while (sent < chunk) {
+        size_t n = push(buf.data() + sent, chunk - sent);
+        if (n == 0) {
+          std::this_thread::yield();
+        }
+        sent += n;
+      }
+    }
+  });
+
+  std::vector<uint8_t> buf(chunk);
+  for (size_t i = 0; i < chunks; i++) {
+    size_t got = 0;
+    while (got < chunk) {
+      size_t n = pop(buf.data() + got, chunk - got);
+      if (n == 0) {
+        std::this_thread::yield();
+      }
+      got += n;
+    }
+    uint64_t stamp;
+    std::memcpy(&stamp, buf.data(), sizeof(stamp));
+    if (result.latencies.size() < MAX_SAMPLES) {
+      result.latencies.push_back(nowNs() - stamp);
+    }
+  }
+  producer.join();
+  result.seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  return result;
+}
+
+void report(bench::Harness &harness, const char *name, size_t chunk,
+            Result &result) {
+  std::vector<uint64_t> &lat = result.latencies;
+  std::sort(lat.begin(), lat.end());
+  auto pct = [&lat](double p) {
+    return lat.empty() ? 0 : lat[std::min(lat.size() - 1,
+                                          static_cast<size_t>(p * lat.size()))];
+  };
+  harness.record(std::string(name) + "/chunk" + std::to_string(chunk),
+                 TOTAL_BYTES / chunk, result.seconds, chunk,
+                 {{"p50_ns", static_cast<double>(pct(0.50))},
+                  {"p99_ns", static_cast<double>(pct(0.99))}});
+}
+
+// The pre-ring handoff: one lock per chunk, front-erase on every read.
+struct MutexVectorQueue {
+  std::mutex mutex;
+  std::vector<uint8_t> data;
+
+  size_t push(const uint8_t *src, size_t n) {
+    std::lock_guard<std::mutex> lock(mutex);
+    n = std::min(n, RING_SIZE - data.size());
+    data.insert(data.end(), src, src + n);
+    return n;
+  }
+
+  size_t pop(uint8_t *dst, size_t n) {
+    std::lock_guard<std::mutex> lock(mutex);
+    n = std::min(n, data.size());
+    std::memcpy(dst, data.data(), n);
+    data.erase(data.begin(), data.begin() + n);
+    return n;
+  }
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Harness harness("spsc_ring", argc, argv);
+  TOTAL_BYTES = harness.scaled(TOTAL_BYTES);
+
+  for (size_t chunk : {64, 512, 4096}) {
+    std::string suffix = "/chunk" + std::to_string(chunk);
+    if (harness.enabled("spsc_ring" + suffix)) {
+      std::unique_ptr<SpscRing<uint8_t, RING_SIZE>> ring(
+          new SpscRing<uint8_t, RING_SIZE>());
+      Result r = runPair(
+          chunk,
+          [&](const uint8_t *p, size_t n) { return ring->write(p, n); },
+          [&](uint8_t *p, size_t n) { return ring->read(p, n); });
+      report(harness, "spsc_ring", chunk, r);
+    }
+    if (harness.enabled("mutex_vector" + suffix)) {
+      MutexVectorQueue queue;
+      Result r = runPair(
+          chunk, [&](const uint8_t *p, size_t n) { return queue.push(p, n); },
+          [&](uint8_t *p, size_t n) { return queue.pop(p, n); });
+      report(harness, "mutex_vector", chunk, r);
+    }
+  }
+  return harness.finish();
+}
@@ -0,0 +1,41 @@
+// Cost of a trace::Span on the hot paths it wraps (executeCommand, port
+// reads and writes): with tracing off, which is what every command pays,
+// and with it on, appending to the thread's buffer.
+//
+// Options: see bench_harness.hpp.
+
+#include "../include/trace.hpp"
+#include "bench_harness.hpp"
+
+#include <algorithm>
+#include <string>
+
+int main(int argc, char **argv) {
+  bench::Harness harness("trace", argc, argv);
+  std::string port = "ttyACM0";
+
+  harness.run("span/off", 100000000, [&](size_t i) {
+    trace::Span span("port", "PortManager::write", port);
+    span.setBytes(static_cast<long>(i));
+    bench::doNotOptimize(i);
+  });
+
+  // Timed once, from a fresh start(), so no span hits a full buffer.
+  if (harness.enabled("span/on")) {
+    size_t n = std::min(harness.scaled(trace::MAX_EVENTS_PER_THREAD),
+                        trace::MAX_EVENTS_PER_THREAD);
+    trace::start();
+    auto start = bench::Clock::now();
+    for (size_t i = 0; i < n; i++) {
+      trace::Span span("port", "PortManager::write", port);
+      span.setBytes(static_cast<long>(i));
+      bench::doNotOptimize(i);
+    }
+    harness.record("span/on", n, bench::secondsSince(start));
+    size_t events;
+    size_t dropped;
+    std::string error;
+    trace::stop("/dev/null", events, dropped, error);
+  }
+  return harness.finish();
+}
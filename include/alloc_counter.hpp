@@ -0,0 +1,32 @@
+#ifndef ALLOC_COUNTER_HPP
+#define ALLOC_COUNTER_HPP
+
+#include <cstdint>
+
+/**
+ * @brief Per-thread heap counters kept by the program's replacement
+ *        operator new and delete.
+ *
+ * Every allocation through new bumps a thread-local counter: no atomics,
+ * no locks, a couple of nanoseconds on top of malloc(). Plain malloc()
+ * calls (readline, glob()) are not seen.
+ */
+namespace alloc_counter {
+
+struct Counts {
+  uint64_t allocations = 0;
+  uint64_t frees = 0;
+  uint64_t bytes = 0; // requested by the allocations
+
+  Counts since(const Counts &earlier) const {
+    return Counts{allocations - earlier.allocations, frees - earlier.frees,
+                  bytes - earlier.bytes};
+  }
+};
+
+/** @brief What the calling thread has allocated since it started. */
+Counts thisThread();
+
+} // namespace alloc_counter
+
+#endif // ALLOC_COUNTER_HPP
@@ -1,7 +1,10 @@
 #ifndef ARGS_OPT_HPP
 #define ARGS_OPT_HPP
 
+#include <chrono>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace opt_parser {
@@ -15,6 +18,7 @@ enum class ArgumentOptions {
 const int OK = 0;
 const int INVALID_OPTIONS = -1;
 const int MISSING_ARGUMENT = -2;
+const int INVALID_VALUE = -3;
 
 class Option {
 private:
@@ -30,9 +34,9 @@ public:
   void set_arg(std::string arg);
   void set_found(bool found);
   char get_letter() const;
-  std::string get_name() const;
+  const std::string &get_name() const;
   ArgumentOptions get_arg_option() const;
-  std::string get_arg() const;
+  const std::string &get_arg() const;
   bool get_found() const;
 };
 
@@ -45,10 +49,193 @@ public:
   void addOption(char letter, std::string name, ArgumentOptions arg_option);
   void addOption(char letter, ArgumentOptions arg_option);
   Option *findOption(char letter);
-  Option *findOption(std::string name);
+  Option *findOption(const std::string &name);
   int parseOptionsString(std::vector<std::string> const &args);
   const std::vector<Option> &getOptions() const;
 };
+
+/**
+ * @brief How an option's argument is validated and converted.
+ */
+enum class ValueType {
+  STRING = 0, // Taken verbatim.
+  INTEGER,    // Decimal, 0x hex or 0 octal, optionally signed.
+  BAUD,       // One of the rates serial::configure() accepts.
+  HEX_BYTES,  // "deadbeef", "de:ad:be:ef", "de ad be ef" or "0xde,0xad".
+  DURATION    // "100us", "250ms", "2s", "1.5m"; a bare number is ms.
+};
+
+/**
+ * @brief One entry of a declarative option table.
+ */
+struct OptionSpec {
+  char letter = 0;            // Short form, the key when reading results.
+  const char *name = nullptr; // Long form without "--", or nullptr.
+  ArgumentOptions arg_option = ArgumentOptions::NO_ARG;
+  ValueType type = ValueType::STRING;
+};
+
+class ParsedOptions;
+
+/**
+ * @brief A command's options, declared once as a constexpr table.
+ *
+ *   constexpr opt_parser::OptionTable OPTIONS({
+ *       {'b', "baud", ArgumentOptions::REQ_ARG, ValueType::BAUD},
+ *       {'p', "pty", ArgumentOptions::NO_ARG, ValueType::STRING},
+ *   });
+ *
+ * Short options are looked up through a direct letter table and long
+ * options through a perfect hash whose seed is searched for at compile
+ * time, so both lookups are a single probe. Duplicate letters or names are
+ * rejected at compile time.
+ *
+ * Accepted syntax: -b 9600, -b9600, bundled flags (-ap), --baud 9600,
+ * --baud=9600. Parsing stops at the first positional argument; "--" ends
+ * the options and "-" alone counts as positional.
+ */
+class OptionTable {
+public:
+  static constexpr size_t MAX_OPTIONS = 16;
+  static constexpr int NOT_FOUND = -1;
+
+  template <size_t N>
+  constexpr OptionTable(const OptionSpec (&specs)[N])
+      : specs_(), count_(N), seed_(0), letter_slots_(), name_slots_() {
+    static_assert(N > 0 && N <= MAX_OPTIONS, "unsupported option count");
+    for (size_t i = 0; i < N; i++) {
+      const OptionSpec &spec = specs[i];
+      unsigned char letter = static_cast<unsigned char>(spec.letter);
+      if (letter == 0 || letter >= LETTER_SLOTS || letter_slots_[letter] != 0) {
+        throw "option letters must be unique ASCII characters";
+      }
+      for (size_t j = 0; j < i; j++) {
+        if (spec.name != nullptr && specs[j].name != nullptr &&
+            std::string_view(spec.name) == std::string_view(specs[j].name)) {
+          throw "option names must be unique";
+        }
+      }
+      specs_[i] = spec;
+      letter_slots_[letter] = static_cast<unsigned char>(i + 1);
+    }
+    while (!placeNames()) {
+      seed_++;
+    }
+  }
+
+  size_t size() const { return count_; }
+  const OptionSpec &operator[](size_t i) const { return specs_[i]; }
+  const OptionSpec *begin() const { return specs_; }
+  const OptionSpec *end() const { return specs_ + count_; }
+
+  /** @return The option's index, or NOT_FOUND. */
+  constexpr int indexOf(char letter) const {
+    unsigned char c = static_cast<unsigned char>(letter);
+    return c < LETTER_SLOTS ? letter_slots_[c] - 1 : NOT_FOUND;
+  }
+
+  /** @return The option's index, or NOT_FOUND. */
+  constexpr int indexOf(std::string_view name) const {
+    unsigned char slot = name_slots_[hashName(name, seed_) & NAME_SLOT_MASK];
+    if (slot == 0 || std::string_view(specs_[slot - 1].name) != name) {
+      return NOT_FOUND;
+    }
+    return slot - 1;
+  }
+
+  /**
+   * @brief Parses args (args[0] is the command name) into a fresh result.
+   *
+   * The result refers to the strings in args; keep them alive while it is
+   * used.
+   */
+  ParsedOptions parse(const std::vector<std::string> &args) const;
+
+private:
+  static constexpr size_t LETTER_SLOTS = 128;
+  static constexpr size_t NAME_SLOTS = 2 * MAX_OPTIONS;
+  static constexpr uint32_t NAME_SLOT_MASK = NAME_SLOTS - 1;
+
+  OptionSpec specs_[MAX_OPTIONS];
+  size_t count_;
+  uint32_t seed_;
+  unsigned char letter_slots_[LETTER_SLOTS]; // letter -> index + 1
+  unsigned char name_slots_[NAME_SLOTS];     // hash -> index + 1
+
+  static constexpr uint32_t hashName(std::string_view name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u); // FNV-1a
+    for (char c : name) {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash ^ (hash >> 16);
+  }
+
+  constexpr bool placeNames() {
+    for (size_t slot = 0; slot < NAME_SLOTS; slot++) {
+      name_slots_[slot] = 0;
+    }
+    for (size_t i = 0; i < count_; i++) {
+      if (specs_[i].name == nullptr) {
+        continue;
+      }
+      uint32_t slot = hashName(specs_[i].name, seed_) & NAME_SLOT_MASK;
+      if (name_slots_[slot] != 0) {
+        return false;
+      }
+      name_slots_[slot] = static_cast<unsigned char>(i + 1);
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief The outcome of OptionTable::parse(), holding validated values.
+ *
+ * Values are read by option letter. Every call to parse() produces a new
+ * object, so nothing carries over from a previous command line.
+ */
+class ParsedOptions {
+public:
+  /** @return OK, INVALID_OPTIONS, MISSING_ARGUMENT or INVALID_VALUE. */
+  int error() const { return error_; }
+  bool ok() const { return error_ == OK; }
+  /** @return What went wrong, e.g. "unknown option '--foo'". */
+  const std::string &errorMessage() const { return error_message_; }
+
+  /** @return Index into args of the first positional argument. */
+  size_t firstPositional() const { return first_positional_; }
+
+  bool has(char letter) const;
+  std::string_view str(char letter, std::string_view fallback = {}) const;
+  int64_t integer(char letter, int64_t fallback = 0) const;
+  int baud(char letter, int fallback) const;
+  std::chrono::microseconds duration(char letter,
+                                     std::chrono::microseconds fallback) const;
+  std::vector<uint8_t> bytes(char letter) const;
+
+private:
+  struct Value {
+    bool found = false;
+    std::string_view text;
+    int64_t number = 0; // INTEGER, BAUD, DURATION (microseconds)
+    uint32_t bytes_offset = 0;
+    uint32_t bytes_length = 0;
+  };
+
+  const OptionTable *table_;
+  Value values_[OptionTable::MAX_OPTIONS];
+  std::vector<uint8_t> bytes_; // HEX_BYTES values, back to back
+  size_t first_positional_ = 1;
+  int error_ = OK;
+  std::string error_message_;
+
+  explicit ParsedOptions(const OptionTable &table) : table_(&table) {}
+  const Value *lookup(char letter) const;
+  bool set(int index, std::string_view text);
+
+  friend class OptionTable;
+};
+
 }; // namespace opt_parser
 
 #endif
@@ -1,8 +1,81 @@
 #ifndef ARGS_PARSER_H
 #define ARGS_PARSER_H
 
-#include <vector>
 #include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief The tokens of one command line, without per-token allocation.
+ *
+ * Plain tokens are views straight into the input line. Tokens that contain
+ * quotes or escapes are unescaped into an arena owned by this object; the
+ * arena is sized to the line up front, so views into it stay valid.
+ *
+ * Reusing one CommandTokens across lines keeps both vectors' capacity, so a
+ * steady stream of lines tokenizes without allocating. Views are valid until
+ * the next tokenizeCommandLine() call and, for plain tokens, only while the
+ * input line is alive.
+ */
+class CommandTokens {
+private:
+  std::vector<std::string_view> tokens_;
+  std::string arena_;
+
+  friend void tokenizeCommandLine(std::string_view commandLine,
+                                  CommandTokens &out);
+
+public:
+  void clear() {
+    tokens_.clear();
+    arena_.clear();
+  }
+
+  size_t size() const { return tokens_.size(); }
+  bool empty() const { return tokens_.empty(); }
+  std::string_view operator[](size_t i) const { return tokens_[i]; }
+  std::vector<std::string_view>::const_iterator begin() const {
+    return tokens_.begin();
+  }
+  std::vector<std::string_view>::const_iterator end() const {
+    return tokens_.end();
+  }
+};
+
+/**
+ * @brief Splits a command line into tokens, handling quotes and escapes.
+ *
+ * Same splitting rules as parseCommandLine(), but no wildcard expansion and
+ * no copies for tokens that need no unescaping.
+ *
+ * @param commandLine The input command line.
+ * @param out Receives the tokens; previous contents are discarded.
+ */
+void tokenizeCommandLine(std::string_view commandLine, CommandTokens &out);
+
+/**
+ * @brief Checks whether a token contains shell wildcard characters.
+ */
+bool hasWildcards(std::string_view token);
+
+/**
+ * @brief Matches a name against a wildcard pattern (*, ?, [...]) with the
+ *        rules glob() applies to file names, for patterns over other names.
+ */
+bool matchWildcard(std::string_view pattern, std::string_view name);
+
+/**
+ * @brief Copies tokens into arguments, expanding wildcards like
+ *        parseCommandLine() when expand_wildcards is set.
+ */
+std::vector<std::string> materializeTokens(const CommandTokens& tokens,
+                                           bool expand_wildcards);
+
+/**
+ * @brief Expands the wildcards of already split arguments, e.g. a command
+ *        line that was passed through verbatim and is now being run.
+ */
+std::vector<std::string> expandWildcards(const std::vector<std::string>& arguments);
 
 /**
  * @brief Parses a command-line string into arguments, handling quotes and expanding wildcards.
@@ -13,6 +86,9 @@
  * Arguments with wildcards that match no files are omitted.
  * Arguments without wildcards, or patterns that cause glob errors, are passed through literally.
  *
+ * Tokenizes with tokenizeCommandLine() into a per-thread scratch buffer, so
+ * each argument is materialized exactly once, directly into the result.
+ *
  * @param commandLine The input command line string.
  * @return A std::vector<std::string> containing the parsed and expanded arguments.
  * @throws std::bad_alloc If memory allocation fails during parsing or expansion.
@@ -0,0 +1,83 @@
+#ifndef BATCH_RUNNER_HPP
+#define BATCH_RUNNER_HPP
+
+#include <string>
+#include <vector>
+
+class CommandRegistry;
+class JobManager;
+
+// Process exit codes for non-interactive runs (shell conventions).
+const int EXIT_OK = 0;
+const int EXIT_COMMAND_FAILED = 1;
+const int EXIT_USAGE = 2;
+const int EXIT_INTERRUPTED = 130; // a command was cancelled with Ctrl+C
+const int EXIT_COMMAND_NOT_FOUND = 127;
+
+/**
+ * @brief Settings for a headless run, taken from the process arguments.
+ */
+struct BatchOptions {
+  std::vector<std::string> commands; // from -c, already split into lines
+  std::string script_path;           // positional argument, "-" for stdin
+  bool keep_going = false;           // -k: do not stop at the first failure
+  bool show_help = false;            // -h
+};
+
+/**
+ * @brief Parses the process arguments.
+ *
+ *   uconnux-cli [-k] [-c "<commands>"] [<script>|-]
+ *
+ * @return false with error filled on a usage error.
+ */
+bool parseBatchOptions(const std::vector<std::string> &argv,
+                       BatchOptions &options, std::string &error);
+
+/**
+ * @brief Splits script text into command lines.
+ *
+ * Lines end at a newline or an unquoted ';'. Blank lines and lines whose
+ * first non-blank character is '#' are dropped.
+ */
+std::vector<std::string> splitScript(const std::string &text);
+
+/**
+ * @brief Runs command lines back to back without a terminal.
+ *
+ * Each line goes through parseCommandLine() and
+ * CommandRegistry::executeCommand(), exactly like an interactive line.
+ * A line ending in '&' starts a job on jobs instead and counts as
+ * succeeded; runBatch() collects the outcome of jobs at the end. Ctrl+C
+ * cancels the running command and stops the run, even with keep_going.
+ *
+ * @return EXIT_OK, EXIT_COMMAND_FAILED, EXIT_COMMAND_NOT_FOUND or
+ *         EXIT_INTERRUPTED for the first failure, with or without
+ *         keep_going.
+ */
+int runBatchLines(CommandRegistry &registry, JobManager &jobs,
+                  const std::vector<std::string> &lines, bool keep_going,
+                  bool &exit_requested);
+
+/**
+ * @brief Streams commands from a file descriptor (script file or pipe).
+ *
+ * Commands run as soon as their line is complete, so a test rig can keep a
+ * pipe open and feed commands one at a time. Stops early, setting
+ * exit_requested, like runBatchLines().
+ */
+int runBatchStream(CommandRegistry &registry, JobManager &jobs, int fd,
+                   bool keep_going, bool &exit_requested);
+
+/**
+ * @brief Runs everything requested in options, waits for background jobs
+ *        and returns the exit code. A failed job fails the run. After
+ *        `exit`, or a failure that stops the run, jobs are not waited for;
+ *        destroying jobs cancels them.
+ */
+int runBatch(CommandRegistry &registry, JobManager &jobs,
+             const BatchOptions &options);
+
+void printUsage(const char *program);
+
+#endif // BATCH_RUNNER_HPP
@@ -0,0 +1,122 @@
+#ifndef BOOTLOADER_PROTOCOL_HPP
+#define BOOTLOADER_PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Wire format spoken by `flash` and the bootloaders it talks to.
+ *
+ * Every packet is [opcode][fields...][CRC-32 of the preceding bytes], COBS
+ * encoded and terminated by 0x00. Multi-byte fields are little endian.
+ *
+ *   HELLO   ->                                 INFO  <- base size page block
+ *   ERASE   -> addr len                        RESULT <- status 0
+ *   WRITE   -> seq:16 addr data...             ACK <- seq | NAK <- seq reason
+ *   VERIFY  -> addr len                        RESULT <- status crc32
+ *   BOOT    ->                                 RESULT <- status 0
+ *   HASH    -> addr count:16                   RESULT <- status crc32...
+ *
+ * WRITE carries its target address, so blocks may be applied in any order
+ * and a retransmitted duplicate is harmless. Every WRITE is acknowledged on
+ * its own, which lets the host keep a window of blocks in flight and resend
+ * only the ones that were lost or NAKed.
+ *
+ * HASH returns the CRC-32 of each of count pages starting at the page
+ * aligned addr, so the host can find which pages differ from an image
+ * without reading the flash back. count is at most MAX_HASH_PAGES.
+ */
+namespace bootloader {
+
+enum Opcode : uint8_t {
+  // Host to device.
+  HELLO = 0x01,
+  ERASE = 0x02,
+  WRITE = 0x03,
+  VERIFY = 0x04,
+  BOOT = 0x05,
+  HASH = 0x06,
+  // Device to host.
+  INFO = 0x81,
+  ACK = 0x82,
+  NAK = 0x83,
+  RESULT = 0x84,
+};
+
+enum Status : uint8_t {
+  STATUS_OK = 0,
+  STATUS_BAD_PACKET = 1,   // CRC mismatch or truncated fields
+  STATUS_OUT_OF_RANGE = 2, // outside the device's flash
+  STATUS_NOT_ERASED = 3,   // WRITE over data that was not erased first
+  STATUS_UNALIGNED = 4,    // ERASE not on page boundaries
+  STATUS_UNKNOWN = 5,      // opcode not supported
+};
+
+const char *statusName(uint8_t status);
+
+// Pages per HASH request; keeps a reply within one small device buffer.
+const uint16_t MAX_HASH_PAGES = 64;
+
+/**
+ * @brief What HELLO reports about the device's flash.
+ */
+struct DeviceInfo {
+  uint32_t flash_base = 0;
+  uint32_t flash_size = 0;
+  uint32_t page_size = 0; // erase granularity
+  uint16_t max_block = 0; // largest WRITE payload accepted
+};
+
+/**
+ * @brief Builds one packet and appends its wire encoding.
+ */
+class PacketWriter {
+public:
+  explicit PacketWriter(Opcode opcode);
+
+  PacketWriter &u8(uint8_t value);
+  PacketWriter &u16(uint16_t value);
+  PacketWriter &u32(uint32_t value);
+  PacketWriter &bytes(const uint8_t *data, size_t len);
+
+  /** @brief Appends CRC, COBS encoding and delimiter to wire. */
+  void finish(std::vector<uint8_t> &wire);
+
+private:
+  std::vector<uint8_t> packet_;
+};
+
+/**
+ * @brief Reads the fields of one decoded (un-COBSed) packet.
+ *
+ * valid() is false when the CRC does not match; reads past the end set
+ * truncated() and return zero.
+ */
+class PacketReader {
+public:
+  PacketReader(const uint8_t *data, size_t len);
+
+  bool valid() const { return valid_; }
+  bool truncated() const { return truncated_; }
+  uint8_t opcode() const { return opcode_; }
+
+  uint8_t u8();
+  uint16_t u16();
+  uint32_t u32();
+  /** @return The bytes left before the CRC; consumes them. */
+  const uint8_t *rest(size_t &len);
+
+private:
+  const uint8_t *pos_;
+  const uint8_t *end_;
+  uint8_t opcode_ = 0;
+  bool valid_ = false;
+  bool truncated_ = false;
+
+  bool take(size_t len);
+};
+
+} // namespace bootloader
+
+#endif // BOOTLOADER_PROTOCOL_HPP
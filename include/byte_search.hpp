@@ -0,0 +1,94 @@
+#ifndef BYTE_SEARCH_HPP
+#define BYTE_SEARCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <regex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Searching large byte buffers for a literal byte string or a
+ *        regular expression, for `cgrep`.
+ *
+ * Literals go through a vectorized filter that compares the needle's
+ * first and last byte against 16 (SSE2) or 32 (AVX2) positions at once;
+ * only positions where both agree are checked with memcmp. A regex that
+ * starts with literal text uses that text as the filter and is then
+ * tried at each candidate. One that merely contains literal text is
+ * tried on the lines holding it; one without any runs on every line.
+ */
+namespace byte_search {
+
+/**
+ * @brief Candidate filter implementations, fastest last.
+ */
+enum class ScanLevel { SCALAR = 0, SSE2, AVX2 };
+
+/** @return The best level this CPU supports (picked at startup). */
+ScanLevel bestScanLevel();
+ScanLevel scanLevel();
+/** @brief Forces a level, for benchmarks. @return false if unsupported. */
+bool setScanLevel(ScanLevel level);
+const char *scanLevelName(ScanLevel level);
+
+// A regex match never crosses a '\n' and is looked for in at most this
+// many bytes from where it starts.
+const size_t MAX_REGEX_SPAN = 4096;
+
+class Searcher {
+public:
+  // Offset (from the start of the buffer) and length of one match.
+  using Sink = std::function<void(size_t offset, size_t length)>;
+
+  /** @brief Searches for needle, which must not be empty. */
+  bool compileLiteral(std::vector<uint8_t> needle, std::string &error);
+  /** @brief Searches for an ECMAScript regular expression. */
+  bool compileRegex(const std::string &expression, std::string &error);
+
+  bool isRegex() const { return is_regex_; }
+  /**
+   * @brief The literal, or text every match of the regex contains (maybe
+   *        empty); anchored() if matches start with it.
+   */
+  const std::vector<uint8_t> &literal() const { return literal_; }
+  bool anchored() const { return anchored_; }
+
+  /**
+   * @brief How many bytes past the end of a piece a match can reach, so
+   *        pieces of one buffer can be searched separately if each may
+   *        read that far into the next.
+   */
+  size_t overlap() const;
+
+  /**
+   * @brief Reports every match that starts in [0, limit) of
+   *        data[0, size), in order. Literal matches may overlap; regex
+   *        matches on one line do not.
+   * @return The number of matches.
+   */
+  size_t scan(const uint8_t *data, size_t size, size_t limit,
+              const Sink &sink) const;
+
+private:
+  bool is_regex_ = false;
+  bool anchored_ = true;
+  std::vector<uint8_t> literal_;
+  std::regex regex_;
+
+  size_t scanLiteral(const uint8_t *data, size_t size, size_t limit,
+                     const Sink &sink) const;
+  size_t scanPrefixed(const uint8_t *data, size_t size, size_t limit,
+                      const Sink &sink) const;
+  size_t scanFiltered(const uint8_t *data, size_t size, size_t limit,
+                      const Sink &sink) const;
+  size_t scanLines(const uint8_t *data, size_t size, size_t limit,
+                   const Sink &sink) const;
+  size_t scanLine(const uint8_t *data, const uint8_t *line,
+                  const uint8_t *stop, size_t limit, const Sink &sink) const;
+};
+
+} // namespace byte_search
+
+#endif // BYTE_SEARCH_HPP
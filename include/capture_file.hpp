@@ -0,0 +1,247 @@
+#ifndef CAPTURE_FILE_HPP
+#define CAPTURE_FILE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+/**
+ * @brief The binary serial capture format written by `capture`.
+ *
+ * A capture is a FileHeader, an append-only stream of records and, once
+ * the capture is closed, a trailer: a sparse time index, the port names
+ * and a Footer at the very end of the file. Integers are little-endian;
+ * every record starts 8-byte aligned.
+ *
+ *   FileHeader | Record... | IndexEntry... | names | Footer
+ *
+ * A record is a RecordHeader followed by length payload bytes, padded to
+ * 8. RX and TX records carry port traffic; a PORT record, written the
+ * first time a port shows up, carries its name. Times are nanoseconds
+ * since the capture started and never decrease.
+ *
+ * The index holds one (time, offset) pair per INDEX_SPACING bytes of
+ * records, so a reader finds any timestamp with a binary search and a
+ * scan of at most that many bytes. A file whose writer died has no
+ * trailer; Reader rebuilds the index by scanning it.
+ */
+namespace capture {
+
+enum Direction : uint8_t {
+  RX = 0,
+  TX = 1,
+  PORT = 2, // payload is the name of the port
+};
+
+const char *directionName(Direction direction);
+
+/** @brief True if path starts with FILE_MAGIC, so tools can tell a
+ *         capture from a raw dump. */
+bool isCapture(const std::string &path);
+
+const char FILE_MAGIC[8] = {'U', 'C', 'A', 'P', 'T', 'U', 'R', 'E'};
+const char FOOTER_MAGIC[8] = {'U', 'C', 'A', 'P', 'I', 'N', 'D', 'X'};
+const uint32_t VERSION = 1;
+// Marks a record header, so the zeros after a crashed capture's last
+// record are not mistaken for one.
+const uint8_t RECORD_SYNC = 0xC5;
+const uint64_t INDEX_SPACING = 64 << 10;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;  // sizeof(FileHeader)
+  int64_t wall_start_ns; // CLOCK_REALTIME when the capture started
+  uint64_t reserved;
+};
+
+struct RecordHeader {
+  uint64_t time_ns;
+  uint16_t port;
+  uint8_t direction;
+  uint8_t sync; // RECORD_SYNC
+  uint32_t length;
+};
+
+struct IndexEntry {
+  uint64_t time_ns;
+  uint64_t offset; // of a record header, from the start of the file
+};
+
+struct Footer {
+  uint64_t index_offset; // IndexEntry[index_entries] start here
+  uint64_t index_entries;
+  uint64_t names_offset; // names_count (u16 length, bytes) pairs
+  uint64_t names_count;  // port ids are indices into the names
+  uint64_t records;      // RX and TX records
+  uint64_t end_ns;       // time of the last record
+  char magic[8];
+};
+
+static_assert(sizeof(FileHeader) == 32, "FileHeader layout");
+static_assert(sizeof(RecordHeader) == 16, "RecordHeader layout");
+static_assert(sizeof(IndexEntry) == 16, "IndexEntry layout");
+static_assert(sizeof(Footer) == 56, "Footer layout");
+
+inline size_t paddedLength(uint32_t length) {
+  return (static_cast<size_t>(length) + 7) & ~static_cast<size_t>(7);
+}
+
+/**
+ * @brief Appends records to a capture file without ever dropping them.
+ *
+ * append() copies into a large in-memory block; a background thread
+ * writes full blocks (and, once a second, the partial one) into a file
+ * preallocated PREALLOCATE bytes at a time. When the disk falls behind,
+ * more blocks are allocated rather than data dropped. append() is meant
+ * for the port I/O thread; it takes a mutex that only the writer thread
+ * (once per block) and stats() ever compete for.
+ */
+class Writer {
+public:
+  static const size_t BLOCK_SIZE = 4 << 20;
+  static const size_t SPARE_BLOCKS = 4;
+  static const uint64_t PREALLOCATE = 64 << 20;
+
+  struct Stats {
+    uint64_t records = 0;
+    uint64_t bytes = 0;   // payload bytes of RX and TX records
+    uint64_t written = 0; // file bytes on disk so far
+    size_t ports = 0;
+    size_t queued_blocks = 0;
+    size_t peak_queued_blocks = 0;
+    std::string error; // first write error, if any
+  };
+
+  Writer() = default;
+  ~Writer();
+
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+
+  /** @brief Creates (truncates) path and starts the writer thread. */
+  bool open(const std::string &path, std::string &error);
+
+  /**
+   * @brief Records one chunk of traffic.
+   * @param time_ns steady_clock time in nanoseconds since its epoch.
+   */
+  void append(const std::string &port, Direction direction,
+              const uint8_t *data, size_t length, uint64_t time_ns);
+
+  /**
+   * @brief Writes everything still buffered plus the trailer and closes
+   *        the file. No append() may run concurrently or afterwards.
+   */
+  bool close(std::string &error);
+
+  Stats stats() const;
+  const std::string &path() const { return path_; }
+
+private:
+  using Block = std::unique_ptr<uint8_t[]>;
+  struct Filled {
+    Block block;
+    size_t size;
+  };
+
+  std::string path_;
+  int fd_ = -1;
+  uint64_t origin_ns_ = 0; // steady_clock at open()
+
+  // Everything below is guarded by mutex_.
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+  Block current_;
+  size_t fill_ = 0;
+  std::deque<Filled> queue_;
+  std::vector<Block> spare_;
+  uint64_t offset_ = 0; // file offset the next byte appended lands at
+  uint64_t last_indexed_ = 0;
+  uint64_t last_ns_ = 0;
+  std::vector<IndexEntry> index_;
+  std::unordered_map<std::string, uint16_t> port_ids_;
+  std::vector<std::string> port_names_;
+  Stats stats_;
+
+  std::thread thread_;
+
+  void copyIn(const void *data, size_t length); // caller holds mutex_
+  void writerLoop();
+  bool writeAll(const uint8_t *data, size_t size, std::string &error);
+};
+
+/** @brief One decoded record; data points into the mapping. */
+struct Record {
+  uint64_t time_ns;
+  uint16_t port;
+  Direction direction;
+  const uint8_t *data;
+  uint32_t length;
+};
+
+/**
+ * @brief Read-only, memory-mapped view of a capture file.
+ *
+ * All queries are const and safe to call from many threads at once, so
+ * a search can split the records between cores.
+ */
+class Reader {
+public:
+  bool open(const std::string &path, std::string &error);
+
+  /** @brief False if the writer never closed the file (index rebuilt). */
+  bool complete() const { return complete_; }
+  int64_t wallStartNs() const { return wall_start_ns_; }
+  uint64_t endNs() const { return end_ns_; }
+  uint64_t records() const { return records_; }
+  size_t ports() const { return names_.size(); }
+  /** @brief The port's name, or "?" for an unknown id. */
+  const std::string &portName(uint16_t port) const;
+
+  /** @brief Offset of the first record. */
+  size_t begin() const { return sizeof(FileHeader); }
+  /** @brief Offset just past the last record. */
+  size_t end() const { return records_end_; }
+  const std::vector<IndexEntry> &index() const { return index_; }
+
+  /**
+   * @brief Offset of the first record at or after time_ns: a binary
+   *        search of the index, then a short scan.
+   */
+  size_t seek(uint64_t time_ns) const;
+
+  /**
+   * @brief Decodes the record at offset, PORT records included, and moves
+   *        offset past it.
+   * @return false at end() or at a damaged record.
+   */
+  bool next(size_t &offset, Record &record) const;
+
+private:
+  MappedFile file_;
+  bool complete_ = false;
+  int64_t wall_start_ns_ = 0;
+  uint64_t end_ns_ = 0;
+  uint64_t records_ = 0;
+  size_t records_end_ = 0;
+  std::vector<IndexEntry> index_;
+  std::vector<std::string> names_;
+
+  bool readTrailer();
+  void rebuild();
+};
+
+} // namespace capture
+
+#endif // CAPTURE_FILE_HPP
@@ -0,0 +1,85 @@
+#ifndef COMMAND_CONTEXT_HPP
+#define COMMAND_CONTEXT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+/**
+ * @brief A flag a running command polls to learn it should stop.
+ *
+ * cancel() is thread safe and wakes waitFor(). cancelFromSignal() is the
+ * async-signal-safe variant used by the SIGINT handler; it cannot notify,
+ * so waitFor() re-checks the flag at least every POLL.
+ */
+class CancellationToken {
+public:
+  static constexpr std::chrono::milliseconds POLL{50};
+
+  CancellationToken() = default;
+  CancellationToken(const CancellationToken &) = delete;
+  CancellationToken &operator=(const CancellationToken &) = delete;
+
+  void cancel();
+  void cancelFromSignal() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Sleeps for duration unless cancelled first.
+   * @return false if the token was (or got) cancelled.
+   */
+  bool waitFor(std::chrono::milliseconds duration) const;
+
+private:
+  std::atomic<bool> cancelled_{false};
+  mutable std::mutex mutex_;
+  mutable std::condition_variable cv_;
+
+  static_assert(std::atomic<bool>::is_always_lock_free,
+                "cancelFromSignal() must not take a lock");
+};
+
+/**
+ * @brief What a running command gets besides its arguments: the token to
+ * poll for cancellation and a sink for progress reports.
+ *
+ * The default context owns a token nobody cancels and drops progress, so
+ * callers that do not care can pass a fresh one.
+ */
+class CommandContext {
+public:
+  // Units of work done so far and the total, e.g. bytes written.
+  using ProgressSink = std::function<void(uint64_t done, uint64_t total)>;
+
+  CommandContext() : token_(&own_token_) {}
+  explicit CommandContext(CancellationToken &token,
+                          ProgressSink progress = nullptr)
+      : token_(&token), progress_(std::move(progress)) {}
+
+  CommandContext(const CommandContext &) = delete;
+  CommandContext &operator=(const CommandContext &) = delete;
+
+  CancellationToken &token() const { return *token_; }
+  // The background job running the command, or 0 in the foreground.
+  int jobId() const { return job_id_; }
+  void setJobId(int id) { job_id_ = id; }
+  bool cancelled() const { return token_->cancelled(); }
+  void progress(uint64_t done, uint64_t total) const {
+    if (progress_) {
+      progress_(done, total);
+    }
+  }
+
+private:
+  CancellationToken own_token_;
+  CancellationToken *token_;
+  ProgressSink progress_;
+  int job_id_ = 0;
+};
+
+#endif // COMMAND_CONTEXT_HPP
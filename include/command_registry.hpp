@@ -1,12 +1,14 @@
 #ifndef COMMAND_REGISTRY_HPP
 #define COMMAND_REGISTRY_HPP
 
+#include "completion_trie.hpp"
 #include "icommand.hpp" // Defines ICommand, COMMAND_SUCCESS, etc.
 #include "logger.hpp"   // Needed for logger usage within the template function
 
+#include <cstdint>
 #include <vector>
-#include <map>
 #include <string>
+#include <string_view>
 #include <memory>       // For std::unique_ptr
 #include <type_traits>  // For static_assert and std::is_base_of
 #include <utility>      // For std::forward
@@ -15,11 +17,35 @@
 // class Logger; // Not strictly needed here as logger.hpp is included for the template
 
 class CommandRegistry {
+public:
+    // Registered commands as (name, command) pairs, sorted by name
+    using CommandList = std::vector<std::pair<std::string, ICommand*>>;
+
 private:
+    // One slot of the open-addressing table used for dispatch
+    struct Slot {
+        std::string name;            // Cached at registration
+        ICommand* command = nullptr; // nullptr marks an empty slot
+        size_t hash = 0;
+        CompletionTrie option_names; // "-b", "--baud", ... for completion
+    };
+
     // Owns the command objects
     std::vector<std::unique_ptr<ICommand>> command_objects;
-    // Non-owning pointers for quick lookup by name
-    std::map<std::string, ICommand*> command_map;
+    // Non-owning pointers for quick lookup by name (linear probing,
+    // power-of-two size, kept at most half full)
+    std::vector<Slot> slots;
+    size_t slot_count = 0;
+    // The same commands in name order, for help and completion
+    CommandList sorted_commands;
+    CompletionTrie command_names;
+
+    static constexpr size_t NO_SLOT = static_cast<size_t>(-1);
+
+    static size_t hashName(std::string_view name);
+    size_t findSlot(std::string_view name, size_t hash) const;
+    void insertSlot(Slot slot);
+    void addCommand(std::string name, ICommand* command);
 
 public:
     CommandRegistry();  // Constructor declaration
@@ -51,21 +77,10 @@ public:
 
         // Create the command instance using provided constructor args
         auto command_ptr = std::make_unique<T>(std::forward<Args>(args)...);
-        std::string name = command_ptr->getName();
-
-        // Check for duplicate registration
-        if (command_map.count(name)) {
-            // Access the global logger instance (declared elsewhere, e.g., logger.cpp or main.cpp)
-            extern Logger logger;
-            logger.warn("Command '", name, "' is already registered. Overwriting previous entry.");
-            // Note: Overwriting might orphan the previous unique_ptr briefly before
-            // the new one is added. Consider explicitly removing the old one if necessary,
-            // though the current map/vector approach handles ownership correctly.
-        }
-
-        // Store the raw pointer in the map *before* moving ownership.
-        // Using operator[] handles both insertion and overwrite.
-        command_map[name] = command_ptr.get();
+
+        // The name is queried once here and cached in the lookup tables;
+        // addCommand() warns about and overwrites duplicates.
+        addCommand(command_ptr->getName(), command_ptr.get());
 
         // Transfer ownership of the command object to the vector.
         command_objects.push_back(std::move(command_ptr));
@@ -76,7 +91,7 @@ public:
      * @param name The name of the command to find.
      * @return A non-owning pointer to the command if found, nullptr otherwise.
      */
-    ICommand* findCommand(const std::string& name) const;
+    ICommand* findCommand(std::string_view name) const;
 
     /**
      * @brief Executes a command based on parsed arguments.
@@ -89,11 +104,37 @@ public:
     int executeCommand(const std::vector<std::string>& arguments);
 
     /**
-     * @brief Provides read-only access to the map of registered commands.
+     * @brief Executes a command through ICommand::run() under context, so it
+     *        can be cancelled and report progress.
+     * @return As above, or COMMAND_CANCELLED.
+     */
+    int executeCommand(const std::vector<std::string>& arguments,
+                       CommandContext& context);
+
+    /**
+     * @brief Splits a command line like parseCommandLine(), expanding
+     *        wildcards only if the named command wants them expanded.
+     * @see ICommand::expandsWildcards()
+     */
+    std::vector<std::string> parseLine(const std::string& line) const;
+
+    /**
+     * @brief Provides read-only access to the registered commands.
      * Useful for help commands or autocompletion features.
-     * @return A constant reference to the internal command map.
+     * @return A constant reference to the (name, command) list, sorted by name.
+     */
+    const CommandList& getCommands() const;
+
+    /**
+     * @brief Command names as a prefix tree, kept current by registerCommand().
+     */
+    const CompletionTrie& getCommandNames() const;
+
+    /**
+     * @brief Short and long option spellings ("-b", "--baud") of a command.
+     * @return nullptr if no such command is registered.
      */
-    const std::map<std::string, ICommand*>& getCommands() const;
+    const CompletionTrie* getOptionNames(std::string_view name) const;
 };
 
 #endif // COMMAND_REGISTRY_HPP
@@ -1,13 +1,9 @@
 #ifndef ADD_HPP
 #define ADD_HPP
 
-#include "../../include/args_opt.hpp"
 #include "../../include/icommand.hpp"
 
 class AddCommand : public ICommand {
-private:
-  opt_parser::OptionsParser parser;
-
 public:
   AddCommand();
   virtual ~AddCommand() = default;
@@ -15,6 +11,7 @@ public:
   std::string getName() const override;
   std::string getDescription() const override;
   int execute(const std::vector<std::string> &arguments) override;
+  const opt_parser::OptionTable *getOptions() const override;
 };
 
 #endif
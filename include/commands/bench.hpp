@@ -0,0 +1,25 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include "../../include/command_registry.hpp"
+#include "../../include/icommand.hpp"
+
+class BenchCommand : public CancellableCommand {
+private:
+  CommandRegistry &registry_;
+
+public:
+  explicit BenchCommand(CommandRegistry &registry);
+  virtual ~BenchCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int run(const std::vector<std::string> &arguments,
+          CommandContext &context) override;
+  const opt_parser::OptionTable *getOptions() const override;
+  ArgumentKind getArgumentKind() const override;
+  // The command line is re-parsed, wildcards included, on every run.
+  bool expandsWildcards() const override { return false; }
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef BROADCAST_HPP
+#define BROADCAST_HPP
+
+#include "../../include/command_registry.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/port_manager.hpp"
+
+class BroadcastCommand : public CancellableCommand {
+private:
+  CommandRegistry &registry_;
+  const PortManager &ports_;
+
+public:
+  BroadcastCommand(CommandRegistry &registry, const PortManager &ports);
+  virtual ~BroadcastCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int run(const std::vector<std::string> &arguments,
+          CommandContext &context) override;
+  const opt_parser::OptionTable *getOptions() const override;
+  ArgumentKind getArgumentKind() const override;
+  // The port patterns are matched against port names, not files.
+  bool expandsWildcards() const override { return false; }
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef CAPTURE_HPP
+#define CAPTURE_HPP
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include "../../include/capture_file.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/port_manager.hpp"
+
+class CaptureCommand : public ICommand {
+private:
+  PortManager &ports_;
+  // The running capture, if any; guarded by mutex_ since jobs run
+  // commands too.
+  std::mutex mutex_;
+  std::shared_ptr<capture::Writer> writer_;
+  std::chrono::steady_clock::time_point started_;
+
+public:
+  explicit CaptureCommand(PortManager &ports);
+  virtual ~CaptureCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int execute(const std::vector<std::string> &arguments) override;
+  ArgumentKind getArgumentKind() const override;
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef CGREP_HPP
+#define CGREP_HPP
+
+#include "../../include/args_opt.hpp"
+#include "../../include/icommand.hpp"
+
+class CgrepCommand : public CancellableCommand {
+public:
+  CgrepCommand() = default;
+  virtual ~CgrepCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int run(const std::vector<std::string> &arguments,
+          CommandContext &context) override;
+  const opt_parser::OptionTable *getOptions() const override;
+  ArgumentKind getArgumentKind() const override;
+  // A regex would be taken for a file pattern.
+  bool expandsWildcards() const override { return false; }
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef CLOSE_HPP
+#define CLOSE_HPP
+
+#include "../../include/icommand.hpp"
+#include "../../include/port_manager.hpp"
+
+class CloseCommand : public ICommand {
+private:
+  PortManager &ports_;
+
+public:
+  explicit CloseCommand(PortManager &ports);
+  virtual ~CloseCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int execute(const std::vector<std::string> &arguments) override;
+  const opt_parser::OptionTable *getOptions() const override;
+  ArgumentKind getArgumentKind() const override;
+};
+
+#endif
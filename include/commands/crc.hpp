@@ -0,0 +1,17 @@
+#ifndef CRC_COMMAND_HPP
+#define CRC_COMMAND_HPP
+
+#include "../../include/icommand.hpp"
+
+class CrcCommand : public ICommand {
+public:
+  CrcCommand();
+  virtual ~CrcCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int execute(const std::vector<std::string> &arguments) override;
+  const opt_parser::OptionTable *getOptions() const override;
+};
+
+#endif
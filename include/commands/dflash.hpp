@@ -0,0 +1,23 @@
+#ifndef DFLASH_HPP
+#define DFLASH_HPP
+
+#include "../../include/icommand.hpp"
+#include "../../include/port_manager.hpp"
+
+class DflashCommand : public CancellableCommand {
+private:
+  PortManager &ports_;
+
+public:
+  explicit DflashCommand(PortManager &ports);
+  virtual ~DflashCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int run(const std::vector<std::string> &arguments,
+          CommandContext &context) override;
+  const opt_parser::OptionTable *getOptions() const override;
+  ArgumentKind getArgumentKind() const override;
+};
+
+#endif
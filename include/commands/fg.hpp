@@ -0,0 +1,21 @@
+#ifndef FG_HPP
+#define FG_HPP
+
+#include "../../include/icommand.hpp"
+#include "../../include/job_manager.hpp"
+
+class FgCommand : public CancellableCommand {
+private:
+  JobManager &jobs_;
+
+public:
+  explicit FgCommand(JobManager &jobs);
+  virtual ~FgCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int run(const std::vector<std::string> &arguments,
+          CommandContext &context) override;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef FLASH_HPP
+#define FLASH_HPP
+
+#include "../../include/icommand.hpp"
+#include "../../include/port_manager.hpp"
+
+class FlashCommand : public CancellableCommand {
+private:
+  PortManager &ports_;
+
+public:
+  explicit FlashCommand(PortManager &ports);
+  virtual ~FlashCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int run(const std::vector<std::string> &arguments,
+          CommandContext &context) override;
+  const opt_parser::OptionTable *getOptions() const override;
+  ArgumentKind getArgumentKind() const override;
+};
+
+#endif
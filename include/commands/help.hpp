@@ -23,6 +23,7 @@ public:
     virtual std::string getName() const override;
     virtual std::string getDescription() const override; // Added for better help
     virtual int execute(const std::vector<std::string>& arguments) override;
+    virtual ArgumentKind getArgumentKind() const override;
 };
 
 #endif // HELP_COMMAND_HPP
@@ -0,0 +1,18 @@
+#ifndef HEXINFO_HPP
+#define HEXINFO_HPP
+
+#include "../../include/icommand.hpp"
+
+class HexinfoCommand : public ICommand {
+public:
+  HexinfoCommand();
+  virtual ~HexinfoCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int execute(const std::vector<std::string> &arguments) override;
+  const opt_parser::OptionTable *getOptions() const override;
+  ArgumentKind getArgumentKind() const override;
+};
+
+#endif
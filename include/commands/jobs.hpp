@@ -0,0 +1,20 @@
+#ifndef JOBS_HPP
+#define JOBS_HPP
+
+#include "../../include/icommand.hpp"
+#include "../../include/job_manager.hpp"
+
+class JobsCommand : public ICommand {
+private:
+  JobManager &jobs_;
+
+public:
+  explicit JobsCommand(JobManager &jobs);
+  virtual ~JobsCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int execute(const std::vector<std::string> &arguments) override;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef KILL_HPP
+#define KILL_HPP
+
+#include "../../include/icommand.hpp"
+#include "../../include/job_manager.hpp"
+
+class KillCommand : public ICommand {
+private:
+  JobManager &jobs_;
+
+public:
+  explicit KillCommand(JobManager &jobs);
+  virtual ~KillCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int execute(const std::vector<std::string> &arguments) override;
+};
+
+#endif
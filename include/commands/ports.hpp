@@ -0,0 +1,20 @@
+#ifndef PORTS_HPP
+#define PORTS_HPP
+
+#include "../../include/icommand.hpp"
+#include "../../include/port_manager.hpp"
+
+class PortsCommand : public ICommand {
+private:
+  const PortManager &ports_;
+
+public:
+  explicit PortsCommand(const PortManager &ports);
+  virtual ~PortsCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int execute(const std::vector<std::string> &arguments) override;
+};
+
+#endif
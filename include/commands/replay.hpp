@@ -0,0 +1,28 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include "../../include/args_opt.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/port_manager.hpp"
+
+class ReplayCommand : public CancellableCommand {
+private:
+  PortManager &ports_;
+
+  int record(const std::string &port, const std::string &path,
+             const opt_parser::ParsedOptions &options,
+             CommandContext &context);
+
+public:
+  explicit ReplayCommand(PortManager &ports);
+  virtual ~ReplayCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int run(const std::vector<std::string> &arguments,
+          CommandContext &context) override;
+  const opt_parser::OptionTable *getOptions() const override;
+  ArgumentKind getArgumentKind() const override;
+};
+
+#endif
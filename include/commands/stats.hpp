@@ -0,0 +1,41 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "../../include/icommand.hpp"
+#include "../../include/latency_histogram.hpp"
+#include "../../include/port_manager.hpp"
+
+class StatsCommand : public CancellableCommand {
+private:
+  // A port's counters at one point in time.
+  struct Sample {
+    std::chrono::steady_clock::time_point time;
+    PortInfo info;
+    LatencyHistogram::Snapshot round_trips;
+  };
+
+  const PortManager &ports_;
+  // What the previous `stats` saw, so rates cover the time since then.
+  std::mutex mutex_;
+  std::map<std::string, Sample> last_;
+
+public:
+  explicit StatsCommand(const PortManager &ports);
+  virtual ~StatsCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int run(const std::vector<std::string> &arguments,
+          CommandContext &context) override;
+  const opt_parser::OptionTable *getOptions() const override;
+  ArgumentKind getArgumentKind() const override;
+  // The patterns are matched against port names, not files.
+  bool expandsWildcards() const override { return false; }
+};
+
+#endif
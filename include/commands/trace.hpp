@@ -0,0 +1,28 @@
+#ifndef TRACE_COMMAND_HPP
+#define TRACE_COMMAND_HPP
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+#include "../../include/icommand.hpp"
+
+class TraceCommand : public ICommand {
+private:
+  // Set by `trace start`; guarded by mutex_ since jobs run commands too.
+  std::mutex mutex_;
+  bool running_ = false;
+  std::string path_; // from `trace start <file>`, may be empty
+  std::chrono::steady_clock::time_point started_;
+
+public:
+  TraceCommand();
+  virtual ~TraceCommand() = default;
+
+  std::string getName() const override;
+  std::string getDescription() const override;
+  int execute(const std::vector<std::string> &arguments) override;
+  ArgumentKind getArgumentKind() const override;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef COMPLETER_HPP
+#define COMPLETER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+class CommandRegistry;
+class PortManager;
+
+/**
+ * @brief Works out tab completions for a partially typed command line.
+ *
+ * The first word completes against the registry's command trie. After that,
+ * a word starting with '-' completes the command's options, the word after
+ * a baud option completes supported rates, and anything else follows the
+ * command's ArgumentKind: open ports, /dev serial devices (listed live, so
+ * a board plugged in a second ago shows up), command names or files.
+ *
+ * Independent of readline; main.cpp adapts the result.
+ */
+class Completer {
+public:
+  Completer(const CommandRegistry &registry, const PortManager &ports);
+
+  /**
+   * @param line The line up to the cursor.
+   * @param start Offset in line of the word being completed.
+   * @param matches Receives the candidates, in sorted order.
+   * @return false if the word should be completed as a file name instead.
+   */
+  bool complete(std::string_view line, size_t start,
+                std::vector<std::string> &matches) const;
+
+private:
+  const CommandRegistry &registry_;
+  const PortManager &ports_;
+
+  bool completeDevices(std::string_view word,
+                       std::vector<std::string> &matches) const;
+  void completePorts(std::string_view word,
+                     std::vector<std::string> &matches) const;
+};
+
+#endif // COMPLETER_HPP
@@ -0,0 +1,53 @@
+#ifndef COMPLETION_TRIE_HPP
+#define COMPLETION_TRIE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Prefix tree of words for tab completion.
+ *
+ * Finding the matches for a prefix costs one step per prefix character plus
+ * the size of the matching subtree, however many words are stored. Nodes
+ * live in one vector and keep their children sorted, so matches come out
+ * in lexicographic order.
+ */
+class CompletionTrie {
+public:
+  CompletionTrie();
+
+  /** @brief Adds a word; adding it again is a no-op. */
+  void insert(std::string_view word);
+
+  bool contains(std::string_view word) const;
+
+  /**
+   * @brief Appends every stored word that starts with prefix to out.
+   * @param limit Stop once out holds this many entries.
+   */
+  void complete(std::string_view prefix, std::vector<std::string> &out,
+                size_t limit = SIZE_MAX) const;
+
+  size_t size() const { return words_; }
+
+private:
+  struct Node {
+    std::vector<std::pair<char, uint32_t>> children; // sorted by char
+    bool terminal = false;
+  };
+
+  static const uint32_t NONE = UINT32_MAX;
+
+  std::vector<Node> nodes_; // nodes_[0] is the root
+  size_t words_ = 0;
+
+  uint32_t child(uint32_t node, char c) const;
+  uint32_t find(std::string_view prefix) const;
+  void collect(uint32_t node, std::string &path, std::vector<std::string> &out,
+               size_t limit) const;
+};
+
+#endif // COMPLETION_TRIE_HPP
@@ -0,0 +1,92 @@
+#ifndef CRC_HPP
+#define CRC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace crc {
+
+/**
+ * @brief Supported checksums. Check values are CRC("123456789").
+ */
+enum class Algorithm {
+  CRC16_CCITT = 0, // CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF. 0x29B1
+  CRC16_MODBUS,    // CRC-16/MODBUS: poly 0x8005 reflected, init 0xFFFF. 0x4B37
+  CRC32,           // CRC-32 (Ethernet, zlib). 0xCBF43926
+  CRC32C           // CRC-32C (Castagnoli, iSCSI). 0xE3069283
+};
+
+const size_t ALGORITHM_COUNT = 4;
+
+/** @return false if name is not one of ccitt, modbus, crc32, crc32c. */
+bool parseAlgorithm(std::string_view name, Algorithm &algorithm);
+const char *algorithmName(Algorithm algorithm);
+/** @return The checksum width in bytes (2 or 4). */
+size_t checksumSize(Algorithm algorithm);
+/** @return The algorithm's published CRC of "123456789". */
+uint32_t checkValue(Algorithm algorithm);
+
+/**
+ * @brief CRC implementations, fastest last.
+ *
+ * HARDWARE uses the SSE4.2 crc32 instruction for CRC-32C and PCLMULQDQ
+ * folding for CRC-32. The CRC-16 variants have no hardware path and run on
+ * SLICE8 instead.
+ */
+enum class Engine { BITWISE = 0, SLICE8, HARDWARE };
+
+/** @return The best engine this CPU supports (picked at startup). */
+Engine bestEngine();
+Engine engine();
+/** @brief Forces an engine, for benchmarks. @return false if unsupported. */
+bool setEngine(Engine engine);
+/** @return The engine algorithm actually runs on right now. */
+Engine engineFor(Algorithm algorithm);
+const char *engineName(Engine engine);
+
+/**
+ * @brief Incremental checksum over any number of update() calls.
+ */
+class Crc {
+public:
+  explicit Crc(Algorithm algorithm);
+
+  Algorithm algorithm() const { return algorithm_; }
+  void update(const void *data, size_t len);
+  /** @return The checksum of everything fed so far. */
+  uint32_t value() const;
+  void reset();
+
+private:
+  Algorithm algorithm_;
+  uint32_t state_;
+};
+
+/** @brief One-shot checksum of a buffer. */
+uint32_t compute(Algorithm algorithm, const void *data, size_t len);
+
+/**
+ * @brief Checks a frame whose last checksumSize() bytes are the checksum of
+ *        the bytes before them.
+ *
+ * Reflected algorithms (MODBUS, CRC-32, CRC-32C) store the checksum little
+ * endian, CRC-16/CCITT big endian, as their protocols do.
+ */
+bool verifyTrailer(Algorithm algorithm, const uint8_t *frame, size_t len);
+
+/** @brief Appends the checksum of frame to it, in verifyTrailer()'s order. */
+void appendTrailer(Algorithm algorithm, std::vector<uint8_t> &frame);
+
+/**
+ * @brief Checks every algorithm on every engine this CPU supports against the
+ *        check values and against each other on random buffers.
+ * @param failure Receives a description of the first mismatch.
+ */
+bool selfTest(std::string &failure);
+
+} // namespace crc
+
+#endif // CRC_HPP
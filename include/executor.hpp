@@ -0,0 +1,57 @@
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Work-stealing task executor.
+ *
+ * Every worker owns a deque. Tasks submitted from outside are dealt round
+ * robin; tasks submitted from a worker go to the back of its own deque and
+ * are run newest first while they are hot. An idle worker steals the
+ * oldest task from the front of another worker's deque, so one long task
+ * never strands the tasks queued behind it while others sit idle.
+ *
+ * Tasks may block (a background flash or capture does); size the executor
+ * for the number of such tasks that should run at once, not for cores.
+ */
+class Executor {
+public:
+  explicit Executor(size_t workers);
+  /** @brief Runs every queued task, then joins the workers. */
+  ~Executor();
+
+  Executor(const Executor &) = delete;
+  Executor &operator=(const Executor &) = delete;
+
+  size_t size() const { return queues_.size(); }
+  void submit(std::function<void()> task);
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> next_queue_{0};
+  std::atomic<size_t> queued_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  bool stopping_ = false;
+
+  bool popOwn(size_t self, std::function<void()> &task);
+  bool steal(size_t self, std::function<void()> &task);
+  void workerLoop(size_t self);
+};
+
+#endif // EXECUTOR_HPP
@@ -0,0 +1,70 @@
+#ifndef FIRMWARE_IMAGE_HPP
+#define FIRMWARE_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+/**
+ * @brief A contiguous run of image bytes at a target address.
+ */
+struct Segment {
+  uint32_t address;
+  const uint8_t *data;
+  size_t size;
+
+  uint32_t end() const { return address + static_cast<uint32_t>(size); }
+};
+
+enum class ImageFormat { BINARY, INTEL_HEX, SREC };
+
+const char *imageFormatName(ImageFormat format);
+
+/**
+ * @brief A firmware image as a sorted list of non-overlapping segments.
+ *
+ * Raw binaries become a single segment that points straight into the file
+ * mapping. Intel HEX and Motorola S-record files are decoded into owned
+ * buffers, one per run of contiguous records, so gaps in the address space
+ * cost nothing.
+ *
+ * Record files are split at line boundaries into one chunk per thread and
+ * the chunks are decoded in parallel. Intel HEX address records carry over
+ * between chunks, so data that precedes a chunk's first address record is
+ * kept relative and rebased once every chunk is done.
+ */
+class FirmwareImage {
+public:
+  FirmwareImage() = default;
+  FirmwareImage(const FirmwareImage &) = delete;
+  FirmwareImage &operator=(const FirmwareImage &) = delete;
+
+  /**
+   * @brief Loads path. A ".hex"/".ihex" suffix selects Intel HEX and
+   *        ".srec"/".s19"/".s28"/".s37"/".mot" S-records; anything else is
+   *        a raw binary.
+   * @param base_address Where a raw binary starts; ignored otherwise.
+   * @param threads Record decoding threads; 0 means one per CPU.
+   * @return true on success, false with error filled otherwise.
+   */
+  bool load(const std::string &path, uint32_t base_address,
+            std::string &error, unsigned threads = 0);
+
+  ImageFormat format() const { return format_; }
+  const std::vector<Segment> &segments() const { return segments_; }
+  /** @return Total payload bytes over all segments. */
+  size_t size() const;
+
+private:
+  ImageFormat format_ = ImageFormat::BINARY;
+  MappedFile file_;
+  std::vector<std::vector<uint8_t>> storage_; // decoded record data
+  std::vector<Segment> segments_;
+
+  bool parseRecords(unsigned threads, std::string &error);
+};
+
+#endif // FIRMWARE_IMAGE_HPP
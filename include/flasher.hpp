@@ -0,0 +1,172 @@
+#ifndef FLASHER_HPP
+#define FLASHER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "args_opt.hpp"
+#include "bootloader_protocol.hpp"
+#include "command_context.hpp"
+#include "firmware_image.hpp"
+#include "port_manager.hpp"
+
+struct FlashOptions {
+  size_t window = 8;     // WRITE blocks in flight
+  size_t block_size = 0; // 0 = the device's max_block
+  std::chrono::milliseconds ack_timeout{250};
+  std::chrono::milliseconds erase_timeout{10000};
+  std::chrono::milliseconds verify_timeout{1000};
+  int retries = 5; // per request or block
+  // Checked while waiting for the device; requests fail with "cancelled"
+  // soon after it fires.
+  const CancellationToken *cancel = nullptr;
+};
+
+/**
+ * @brief Option rows `flash` and `dflash` share, for their option tables.
+ */
+namespace flash_opt {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::OptionSpec;
+using opt_parser::ValueType;
+
+constexpr OptionSpec WINDOW{'w', "window", ArgumentOptions::REQ_ARG,
+                            ValueType::INTEGER};
+constexpr OptionSpec BLOCK_SIZE{'s', "block-size", ArgumentOptions::REQ_ARG,
+                                ValueType::INTEGER};
+constexpr OptionSpec ADDRESS{'a', "address", ArgumentOptions::REQ_ARG,
+                             ValueType::INTEGER};
+constexpr OptionSpec TIMEOUT{'t', "timeout", ArgumentOptions::REQ_ARG,
+                             ValueType::DURATION};
+constexpr OptionSpec RETRIES{'r', "retries", ArgumentOptions::REQ_ARG,
+                             ValueType::INTEGER};
+constexpr OptionSpec NO_VERIFY{'n', "no-verify", ArgumentOptions::NO_ARG,
+                               ValueType::STRING};
+constexpr OptionSpec GO{'g', "go", ArgumentOptions::NO_ARG,
+                        ValueType::STRING};
+
+// Sequence numbers are 16 bits; keep the window well inside half of that.
+const int64_t MAX_WINDOW = 1024;
+// Blocks never exceed the device's max_block, a 16-bit value.
+const int64_t MAX_BLOCK_SIZE = 0xFFFF;
+const int64_t MAX_RETRIES = 1000;
+
+/**
+ * @brief Fills window, block_size, retries and ack_timeout from -w, -s, -r
+ *        and -t; the rest of options is left alone. Also checks that -a,
+ *        which the caller reads itself, fits in 32 bits.
+ * @return false with error filled if a value is out of range.
+ */
+bool parse(const opt_parser::ParsedOptions &parsed, FlashOptions &options,
+           std::string &error);
+
+/**
+ * @brief Logs why a device request failed. A request cut short by Ctrl+C
+ *        or kill is a cancellation, not an error.
+ * @return COMMAND_CANCELLED or COMMAND_ERROR.
+ */
+int requestFailed(const CommandContext &context, const std::string &port,
+                  const char *what, const std::string &error);
+
+} // namespace flash_opt
+
+struct FlashStats {
+  size_t blocks = 0;
+  size_t bytes = 0;
+  size_t retransmits = 0;
+  size_t naks = 0;
+  size_t timeouts = 0;
+};
+
+/**
+ * @brief Host side of the bootloader protocol over one open port.
+ *
+ * Switches the port to COBS framing for its lifetime and restores the
+ * previous framing afterwards. Every request/response round trip is timed
+ * into the port's round_trips histogram. Not thread safe; one Flasher per
+ * port.
+ */
+class Flasher {
+public:
+  // Called with bytes acknowledged so far and the total.
+  using Progress = std::function<void(size_t done, size_t total)>;
+
+  Flasher(PortManager &ports, std::string port, FlashOptions options);
+  ~Flasher();
+
+  Flasher(const Flasher &) = delete;
+  Flasher &operator=(const Flasher &) = delete;
+
+  bool hello(bootloader::DeviceInfo &info, std::string &error);
+
+  /**
+   * @brief Erases every page the segments touch, merging adjacent pages
+   *        into one request.
+   */
+  bool erase(const std::vector<Segment> &segments,
+             const bootloader::DeviceInfo &info, std::string &error);
+
+  /**
+   * @brief Streams segments as WRITE blocks with a sliding window.
+   *
+   * Up to options.window blocks are unacknowledged at any time. The window
+   * slides past each acknowledged block. Only the blocks that need it are
+   * resent: a NAKed block at once, a block overtaken by the ACK of a later
+   * one (the link is in order, so it was lost) at once, and any other block
+   * once its ack_timeout expires. One lost packet never costs a whole
+   * window.
+   */
+  bool write(const std::vector<Segment> &segments,
+             const bootloader::DeviceInfo &info, const Progress &progress,
+             FlashStats &stats, std::string &error);
+
+  /** @brief Asks the device for the CRC-32 of a flash range. */
+  bool checksum(uint32_t address, uint32_t length, uint32_t &crc,
+                std::string &error);
+
+  /**
+   * @brief Asks the device for the CRC-32 of count pages from address,
+   *        MAX_HASH_PAGES per request. address must be page aligned.
+   */
+  bool pageHashes(uint32_t address, uint32_t count,
+                  const bootloader::DeviceInfo &info,
+                  std::vector<uint32_t> &hashes, std::string &error);
+
+  bool boot(std::string &error);
+
+private:
+  PortManager &ports_;
+  std::string port_;
+  FlashOptions options_;
+  std::shared_ptr<Port> handle_; // for round-trip timing; may be null
+  framing::Framing saved_framing_ = framing::Framing::RAW;
+  std::vector<uint8_t> wire_;
+
+  bool send(bootloader::PacketWriter &packet, std::string &error);
+  /**
+   * @brief Waits up to timeout, but no longer than a cancellation poll,
+   *        for frames from the device.
+   * @return false with error filled if the port is gone or the operation
+   *         was cancelled.
+   */
+  bool receive(const PortManager::FrameSink &sink,
+               std::chrono::milliseconds timeout, std::string &error);
+  /**
+   * @brief Sends packet and waits for a reply with the expected opcode,
+   *        resending on timeout. Stray ACK/NAKs are skipped.
+   */
+  bool transact(bootloader::PacketWriter packet, bootloader::Opcode expected,
+                std::chrono::milliseconds timeout,
+                std::vector<uint8_t> &reply, std::string &error);
+  /** @brief transact() for requests answered by RESULT; checks status. */
+  bool command(bootloader::PacketWriter packet,
+               std::chrono::milliseconds timeout, uint32_t *value,
+               std::string &error);
+};
+
+#endif // FLASHER_HPP
@@ -0,0 +1,151 @@
+#ifndef FRAME_DECODER_HPP
+#define FRAME_DECODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace framing {
+
+/**
+ * @brief How a port's byte stream is cut into frames.
+ */
+enum class Framing {
+  RAW = 0, // No framing: every chunk read is handed over as is.
+  LINE,    // Text lines ending in '\n'; a trailing '\r' is dropped.
+  COBS,    // Consistent Overhead Byte Stuffing, 0x00 terminated.
+  SLIP     // RFC 1055: 0xC0 END, 0xDB escapes.
+};
+
+/** @return false if name is not one of raw, newline, cobs, slip. */
+bool parseFraming(std::string_view name, Framing &framing);
+const char *framingName(Framing framing);
+
+/**
+ * @brief Delimiter scan implementations, fastest last.
+ */
+enum class ScanLevel { SCALAR = 0, SSE2, AVX2 };
+
+/** @return The best level this CPU supports (picked at startup). */
+ScanLevel bestScanLevel();
+ScanLevel scanLevel();
+/** @brief Forces a level, for benchmarks. @return false if unsupported. */
+bool setScanLevel(ScanLevel level);
+const char *scanLevelName(ScanLevel level);
+
+/**
+ * @brief Finds the first occurrence of value in [begin, end).
+ *
+ * Compares 16 (SSE2) or 32 (AVX2) bytes per step, depending on the CPU.
+ *
+ * @return Pointer to the byte, or end if there is none.
+ */
+const uint8_t *findByte(const uint8_t *begin, const uint8_t *end,
+                        uint8_t value);
+
+/**
+ * @brief Decodes one COBS frame (without its 0x00 delimiter) in place.
+ * @return The decoded length, or SIZE_MAX if the frame is malformed.
+ */
+size_t cobsDecode(uint8_t *data, size_t len);
+
+/** @brief Appends the COBS encoding of data plus the 0x00 delimiter. */
+void cobsEncode(const uint8_t *data, size_t len, std::vector<uint8_t> &out);
+
+/**
+ * @brief Decodes one SLIP frame (without its END byte) in place.
+ * @return The decoded length, or SIZE_MAX on a bad escape sequence.
+ */
+size_t slipDecode(uint8_t *data, size_t len);
+
+/** @brief Appends data SLIP-escaped between two END bytes. */
+void slipEncode(const uint8_t *data, size_t len, std::vector<uint8_t> &out);
+
+/**
+ * @brief A decoded frame. Only valid inside the sink call that received it.
+ */
+struct FrameView {
+  const uint8_t *data;
+  size_t size;
+};
+
+/**
+ * @brief Incremental decoder for one byte stream.
+ *
+ * feed() takes a mutable chunk of the stream, typically a span of a port's
+ * RX ring. Frames that lie entirely inside the chunk are decoded in place
+ * and handed to the sink as views into it, so the common case copies
+ * nothing. Only the unfinished frame at the end of a chunk is copied aside
+ * and completed by the next feed().
+ *
+ * Empty COBS/SLIP frames (e.g. a leading END) are skipped; empty text lines
+ * are delivered. Frames longer than max_frame and frames that fail to decode
+ * are dropped and counted.
+ */
+class FrameDecoder {
+public:
+  static const size_t DEFAULT_MAX_FRAME = 64 * 1024;
+
+  explicit FrameDecoder(Framing framing,
+                        size_t max_frame = DEFAULT_MAX_FRAME);
+
+  Framing framing() const { return framing_; }
+
+  /**
+   * @brief Decodes a chunk of the stream, calling sink(FrameView) per frame.
+   *
+   * The chunk's bytes are modified in place.
+   */
+  template <typename Sink> void feed(uint8_t *data, size_t len, Sink &&sink) {
+    if (framing_ == Framing::RAW) {
+      if (len > 0) {
+        frames_++;
+        sink(FrameView{data, len});
+      }
+      return;
+    }
+
+    const uint8_t *end = data + len;
+    uint8_t *p = data;
+    while (p < end) {
+      const uint8_t *delimiter = findByte(p, end, delimiter_);
+      if (delimiter == end) {
+        keepPartial(p, static_cast<size_t>(end - p));
+        return;
+      }
+      size_t frame_len = static_cast<size_t>(delimiter - p);
+      FrameView frame;
+      bool complete = finishFrame(p, frame_len, frame);
+      p += frame_len + 1;
+      if (complete) {
+        sink(frame);
+      }
+      partial_.clear();
+    }
+  }
+
+  /** @brief Forgets any partially received frame. */
+  void reset();
+
+  uint64_t frames() const { return frames_; }
+  uint64_t errors() const { return errors_; }
+  uint64_t overruns() const { return overruns_; }
+
+private:
+  Framing framing_;
+  uint8_t delimiter_;
+  size_t max_frame_;
+  std::vector<uint8_t> partial_; // start of a frame cut off by a chunk end
+  bool discarding_ = false;      // skipping the rest of an oversized frame
+  uint64_t frames_ = 0;
+  uint64_t errors_ = 0;
+  uint64_t overruns_ = 0;
+
+  bool finishFrame(uint8_t *data, size_t len, FrameView &frame);
+  void keepPartial(const uint8_t *data, size_t len);
+};
+
+} // namespace framing
+
+#endif // FRAME_DECODER_HPP
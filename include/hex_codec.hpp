@@ -0,0 +1,36 @@
+#ifndef HEX_CODEC_HPP
+#define HEX_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Bulk ASCII hex decoding for the Intel HEX and S-record loaders.
+ */
+namespace hex_codec {
+
+/**
+ * @brief Decode implementations, fastest last.
+ */
+enum class DecodeLevel { SCALAR = 0, SSE2, AVX2 };
+
+/** @return The best level this CPU supports (picked at startup). */
+DecodeLevel bestDecodeLevel();
+DecodeLevel decodeLevel();
+/** @brief Forces a level, for benchmarks. @return false if unsupported. */
+bool setDecodeLevel(DecodeLevel level);
+const char *decodeLevelName(DecodeLevel level);
+
+/**
+ * @brief Decodes 2 * bytes hex digits (either case) from text into out.
+ *
+ * Validates and converts 16 (SSE2) or 32 (AVX2) digits per step.
+ *
+ * @return false if any character is not a hex digit; out is then
+ *         unspecified.
+ */
+bool decode(const uint8_t *text, size_t bytes, uint8_t *out);
+
+} // namespace hex_codec
+
+#endif // HEX_CODEC_HPP
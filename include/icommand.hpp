@@ -4,11 +4,27 @@
 #include <string>
 #include <vector>
 
+#include "command_context.hpp"
+
 // Define constants for command execution results
-#define COMMAND_SUCCESS 0;
-#define COMMAND_ERROR 1;
+#define COMMAND_SUCCESS 0
+#define COMMAND_ERROR 1
 #define COMMAND_EXIT_REQUESTED -99 // Special code for exit
-#define COMMAND_NOT_FOUND -1;     // Special code if dispatcher fails
+#define COMMAND_NOT_FOUND -1      // Special code if dispatcher fails
+#define COMMAND_CANCELLED 130     // Stopped by Ctrl+C or kill (128 + SIGINT)
+
+namespace opt_parser {
+class OptionTable;
+}
+
+// What a command's positional arguments name, used by tab completion
+enum class ArgumentKind {
+  NONE,    // Free text, nothing to complete
+  FILE,    // File system paths
+  DEVICE,  // Serial device paths such as /dev/ttyACM0
+  PORT,    // Names of open ports
+  COMMAND  // Names of registered commands
+};
 
 class ICommand {
 public:
@@ -16,6 +32,38 @@ public:
   virtual std::string getDescription() const = 0;
   virtual int execute(const std::vector<std::string>& arguments) = 0;
   virtual ~ICommand() = default;
+
+  // The command's option table, or nullptr if it takes no options
+  virtual const opt_parser::OptionTable* getOptions() const { return nullptr; }
+  virtual ArgumentKind getArgumentKind() const { return ArgumentKind::NONE; }
+  // False for commands that match wildcard patterns against something other
+  // than files; their arguments then arrive unexpanded
+  virtual bool expandsWildcards() const { return true; }
+
+  // Runs the command under context's cancellation token, reporting progress
+  // to it. This is what the registry calls. The default adapts execute() for
+  // commands that finish quickly: they are only skipped if cancelled before
+  // they start, and report no progress.
+  virtual int run(const std::vector<std::string>& arguments,
+                  CommandContext& context) {
+    if (context.cancelled()) {
+      return COMMAND_CANCELLED;
+    }
+    return execute(arguments);
+  }
+};
+
+// Base for long-running commands: they implement run(), poll the token and
+// return COMMAND_CANCELLED once it fires. execute() runs them under a
+// context nobody cancels.
+class CancellableCommand : public ICommand {
+public:
+  int execute(const std::vector<std::string>& arguments) final {
+    CommandContext context;
+    return run(arguments, context);
+  }
+  int run(const std::vector<std::string>& arguments,
+          CommandContext& context) override = 0;
 };
 
 #endif
@@ -0,0 +1,47 @@
+#ifndef INTERRUPT_HPP
+#define INTERRUPT_HPP
+
+#include <functional>
+
+#include "command_context.hpp"
+
+/**
+ * @brief Ctrl+C handling: SIGINT cancels the foreground command only.
+ *
+ * The signal handler just writes a byte into a pipe; a watcher thread
+ * reads it and, with ordinary locks available, cancels the token of the
+ * current Foreground scope. With no command in the foreground it calls
+ * the idle handler instead (clear the prompt line, or terminate()).
+ * Background jobs and open ports are never touched.
+ */
+namespace interrupt {
+
+// Runs on the watcher thread for a Ctrl+C with no foreground command.
+using IdleHandler = std::function<void()>;
+
+/**
+ * @brief Installs the SIGINT handler once; later calls only swap idle.
+ * @return false if it could not be installed (Ctrl+C then ends the process).
+ */
+bool install(IdleHandler idle);
+void setIdleHandler(IdleHandler idle);
+
+/** @brief Idle handler for batch runs: dies of SIGINT as before. */
+void terminate();
+
+/** @brief Routes Ctrl+C to token for the scope's lifetime. */
+class Foreground {
+public:
+  explicit Foreground(CancellationToken &token);
+  ~Foreground();
+
+  Foreground(const Foreground &) = delete;
+  Foreground &operator=(const Foreground &) = delete;
+
+private:
+  CancellationToken *previous_;
+};
+
+} // namespace interrupt
+
+#endif // INTERRUPT_HPP
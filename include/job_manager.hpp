@@ -0,0 +1,123 @@
+#ifndef JOB_MANAGER_HPP
+#define JOB_MANAGER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "command_context.hpp"
+#include "executor.hpp"
+
+class CommandRegistry;
+
+enum class JobState { QUEUED, RUNNING, DONE, FAILED, KILLED };
+
+const char *jobStateName(JobState state);
+
+struct JobInfo {
+  int id = 0;
+  std::string line; // as typed, without the '&'
+  JobState state = JobState::QUEUED;
+  int result = 0;       // the command's return code once finished
+  double seconds = 0.0; // running time so far, or in total once finished
+  uint64_t done = 0;    // last progress report, if the command makes them
+  uint64_t total = 0;
+};
+
+/**
+ * @brief Runs command lines ending in '&' as background jobs.
+ *
+ * Jobs run on an Executor through CommandRegistry::executeCommand(), just
+ * like a foreground command, each under its own cancellation token; their
+ * output goes through the logger. Job
+ * ids count up from 1 and are never reused within a session. A finished
+ * job is announced once through the logger and stays listed until the
+ * next `jobs` or `fg` has reported it.
+ */
+class JobManager {
+public:
+  JobManager(CommandRegistry &registry, size_t workers);
+  /**
+   * @brief Drops jobs that have not started, cancels running ones and
+   *        waits for them to return.
+   */
+  ~JobManager();
+
+  JobManager(const JobManager &) = delete;
+  JobManager &operator=(const JobManager &) = delete;
+
+  /**
+   * @brief Strips a trailing '&' and surrounding blanks from line.
+   * @return true if line asked to run in the background.
+   */
+  static bool takeBackgroundMarker(std::string &line);
+
+  /** @brief Parses a job id written as 3 or %3. */
+  static bool parseJobId(const std::string &text, int &id);
+
+  /** @brief Queues arguments as a new job. @return The job id. */
+  int start(std::vector<std::string> arguments, const std::string &line);
+
+  /**
+   * @brief Every job, oldest first. Finished jobs are forgotten once
+   *        listed.
+   */
+  std::vector<JobInfo> list();
+
+  /**
+   * @brief Blocks until job id (0: the newest job other than self)
+   *        finishes. If cancel fires meanwhile, the job is killed and the
+   *        wait ends at once; info then shows the job still running unless
+   *        it had not started.
+   * @param self The waiting job's own id, or 0 in the foreground; a job
+   *        never waits for itself.
+   * @return false if there is no such job.
+   */
+  bool wait(int id, int self, const CancellationToken &cancel,
+            JobInfo &info);
+
+  /**
+   * @brief Keeps a queued job from ever starting, or cancels a running
+   *        one. Commands that cannot be cancelled run to completion.
+   * @return false with error filled if the job is unknown or finished.
+   */
+  bool kill(int id, std::string &error);
+
+  /** @brief Waits for every job. @return true if none failed. */
+  bool waitAll();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Job {
+    JobInfo info;
+    std::vector<std::string> arguments;
+    Clock::time_point started;
+    CancellationToken token;
+    std::atomic<uint64_t> done{0};
+    std::atomic<uint64_t> total{0};
+  };
+
+  CommandRegistry &registry_;
+  std::mutex mutex_;
+  std::condition_variable finished_cv_;
+  std::map<int, std::shared_ptr<Job>> jobs_;
+  int next_id_ = 1;
+  size_t unfinished_ = 0;
+  bool all_succeeded_ = true; // since the last waitAll()
+  // Last member: destroyed first, so no job outlives the state above.
+  Executor executor_;
+
+  void run(const std::shared_ptr<Job> &job);
+  JobInfo snapshot(const Job &job) const;
+  void cancelLocked(Job &job);
+};
+
+#endif // JOB_MANAGER_HPP
@@ -0,0 +1,79 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Lock-free log-linear latency histogram in the style of HDR.
+ *
+ * Values are nanoseconds. Below 32 ns every value has its own bucket;
+ * above, each power of two is split into 16 linear sub-buckets, so any
+ * value is known to within 1/16 (6.25%) over the whole 64-bit range.
+ * record() is a few shifts and one relaxed increment, cheap enough to
+ * stay on in production; any number of threads may record while others
+ * take snapshots.
+ */
+class LatencyHistogram {
+public:
+  static const int SUB_BITS = 4; // 16 sub-buckets per power of two
+  static const size_t BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+  /** @brief A consistent-enough copy of the counts, for queries. */
+  struct Snapshot {
+    std::array<uint64_t, BUCKETS> counts{};
+    uint64_t total = 0;
+    uint64_t max_ns = 0;
+
+    /**
+     * @brief The value at quantile q (0..1], e.g. 0.999 for p999, as the
+     *        middle of its bucket. 0 when empty.
+     */
+    uint64_t quantile(double q) const;
+
+    /**
+     * @brief Counts recorded since earlier was taken. max_ns becomes an
+     *        upper bound: the end of the highest bucket hit meanwhile.
+     */
+    Snapshot since(const Snapshot &earlier) const;
+  };
+
+  LatencyHistogram() = default;
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+  void record(uint64_t ns) {
+    counts_[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = max_ns_.load(std::memory_order_relaxed);
+    while (ns > max && !max_ns_.compare_exchange_weak(
+                           max, ns, std::memory_order_relaxed)) {
+    }
+  }
+  void record(std::chrono::steady_clock::duration elapsed) {
+    auto ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    record(static_cast<uint64_t>(ns < 0 ? 0 : ns));
+  }
+
+  Snapshot snapshot() const;
+
+  static size_t bucketOf(uint64_t ns) {
+    if (ns < (uint64_t{2} << SUB_BITS)) {
+      return static_cast<size_t>(ns);
+    }
+    int shift = 63 - __builtin_clzll(ns) - SUB_BITS; // keeps SUB_BITS + 1
+    return (static_cast<size_t>(shift) << SUB_BITS) +
+           static_cast<size_t>(ns >> shift);
+  }
+  /** @brief The smallest value that lands in bucket. */
+  static uint64_t bucketFloor(size_t bucket);
+
+private:
+  std::array<std::atomic<uint64_t>, BUCKETS> counts_{};
+  std::atomic<uint64_t> max_ns_{0};
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
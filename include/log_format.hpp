@@ -0,0 +1,172 @@
+#ifndef LOG_FORMAT_HPP
+#define LOG_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace log_fmt {
+
+/**
+ * @brief Append-only text buffer whose storage is reused across lines.
+ *
+ * clear() keeps the capacity, so once a thread's buffer has grown to its
+ * longest line, formatting never allocates again.
+ */
+class FormatBuffer {
+private:
+  std::string data_;
+
+public:
+  FormatBuffer() { data_.reserve(256); }
+
+  void clear() { data_.clear(); }
+  const char *data() const { return data_.data(); }
+  size_t size() const { return data_.size(); }
+
+  void append(char c) { data_.push_back(c); }
+  void append(const char *text, size_t len) { data_.append(text, len); }
+  void append(const char *text);
+  void append(const std::string &text) { data_.append(text); }
+
+  void appendUnsigned(uint64_t value);
+  void appendSigned(int64_t value);
+  void appendDouble(double value);
+  void appendHex(uint64_t value, int width);
+  void appendHexDump(const uint8_t *data, size_t len);
+};
+
+/**
+ * @brief Leases the calling thread's FormatBuffer for one log line.
+ *
+ * A line built while another is being built on the same thread (e.g. a
+ * logger_lazy() producer that logs) gets a private buffer instead.
+ */
+class BufferLease {
+private:
+  FormatBuffer *buffer_;
+  std::unique_ptr<FormatBuffer> nested_; // only allocated when re-entered
+  bool owns_thread_buffer_;
+
+public:
+  BufferLease();
+  ~BufferLease();
+  BufferLease(const BufferLease &) = delete;
+  BufferLease &operator=(const BufferLease &) = delete;
+
+  FormatBuffer &get() { return *buffer_; }
+};
+
+// --- Argument wrappers ---
+
+struct Hex {
+  uint64_t value;
+  int width;
+};
+
+struct HexDump {
+  const uint8_t *data;
+  size_t len;
+};
+
+// Produced by logger_lazy(); see logger.hpp.
+template <typename F> struct Lazy {
+  F produce;
+};
+
+/**
+ * @brief Formats an integer as 0x-prefixed, zero-padded hex.
+ * @param width Minimum number of digits (0 = as many as needed).
+ */
+template <typename T> Hex hex(T value, int width = 0) {
+  static_assert(std::is_integral<T>::value, "hex() needs an integer");
+  typedef typename std::make_unsigned<T>::type U;
+  return Hex{static_cast<uint64_t>(static_cast<U>(value)), width};
+}
+
+/**
+ * @brief Formats a byte range as a classic offset/hex/ASCII dump, 16 bytes
+ * per line, for packet logging.
+ */
+inline HexDump hexdump(const void *data, size_t len) {
+  return HexDump{static_cast<const uint8_t *>(data), len};
+}
+
+// --- append(): one overload per argument kind ---
+
+inline void append(FormatBuffer &buf, const char *text) { buf.append(text); }
+inline void append(FormatBuffer &buf, char *text) { buf.append(text); }
+inline void append(FormatBuffer &buf, const std::string &text) {
+  buf.append(text);
+}
+inline void append(FormatBuffer &buf, std::string_view text) {
+  buf.append(text.data(), text.size());
+}
+inline void append(FormatBuffer &buf, char c) { buf.append(c); }
+inline void append(FormatBuffer &buf, bool value) {
+  buf.append(value ? "1" : "0", 1);
+}
+inline void append(FormatBuffer &buf, float value) { buf.appendDouble(value); }
+inline void append(FormatBuffer &buf, double value) { buf.appendDouble(value); }
+inline void append(FormatBuffer &buf, const Hex &value) {
+  buf.appendHex(value.value, value.width);
+}
+inline void append(FormatBuffer &buf, const HexDump &dump) {
+  buf.appendHexDump(dump.data, dump.len);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                        std::is_signed<T>::value &&
+                        !std::is_same<T, char>::value>::type
+append(FormatBuffer &buf, T value) {
+  buf.appendSigned(static_cast<int64_t>(value));
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                        std::is_unsigned<T>::value &&
+                        !std::is_same<T, bool>::value>::type
+append(FormatBuffer &buf, T value) {
+  buf.appendUnsigned(static_cast<uint64_t>(value));
+}
+
+template <typename T>
+typename std::enable_if<std::is_enum<T>::value>::type
+append(FormatBuffer &buf, T value) {
+  append(buf, static_cast<typename std::underlying_type<T>::type>(value));
+}
+
+template <typename F> void append(FormatBuffer &buf, const Lazy<F> &lazy);
+
+// Fallback for anything that only knows operator<<. Costs a stream, so
+// keep it off hot paths.
+template <typename T>
+typename std::enable_if<!std::is_arithmetic<T>::value &&
+                        !std::is_enum<T>::value>::type
+append(FormatBuffer &buf, const T &value) {
+  std::ostringstream ss;
+  ss << value;
+  buf.append(ss.str());
+}
+
+template <typename F> void append(FormatBuffer &buf, const Lazy<F> &lazy) {
+  append(buf, lazy.produce());
+}
+
+/**
+ * @brief Appends every argument in order.
+ */
+template <typename... Args> void appendAll(FormatBuffer &buf, Args &&...args) {
+  using List = int[];
+  (void)List{0, ((void)append(buf, args), 0)...};
+}
+
+} // namespace log_fmt
+
+#endif // LOG_FORMAT_HPP
@@ -1,73 +1,245 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <mutex>
-#include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <utility> // For std::forward
 
+#include "log_format.hpp"
+#include "mpsc_queue.hpp"
+
 enum class LogLevel { INFO, SUCCESS, WARNING, FATAL, DEBUG };
 
+/**
+ * @brief Orders levels by importance. The enum's declaration order puts
+ * DEBUG last, so comparisons must go through this instead of the raw value.
+ */
+constexpr int logSeverity(LogLevel level) {
+  return level == LogLevel::DEBUG     ? 0
+         : level == LogLevel::INFO    ? 1
+         : level == LogLevel::SUCCESS ? 2
+         : level == LogLevel::WARNING ? 3
+                                      : 4;
+}
+
+// Least important level compiled into the binary. Calls below it become
+// empty inline functions; wrap costly argument expressions in logger_lazy()
+// so they are not evaluated either. Release builds (make RELEASE=1, which
+// defines NDEBUG) drop DEBUG; override with
+// -DLOGGER_COMPILED_MIN_LEVEL=LogLevel::WARNING etc.
+#ifndef LOGGER_COMPILED_MIN_LEVEL
+#ifdef NDEBUG
+#define LOGGER_COMPILED_MIN_LEVEL LogLevel::INFO
+#else
+#define LOGGER_COMPILED_MIN_LEVEL LogLevel::DEBUG
+#endif
+#endif
+
+/**
+ * @brief Defers building an argument until the line is known to be emitted.
+ *
+ * logger.debug("rx ", logger_lazy([&] { return checksum(buf, n); }));
+ * never calls the lambda when DEBUG is filtered out.
+ */
+template <typename F> log_fmt::Lazy<F> logger_lazy(F produce) {
+  return log_fmt::Lazy<F>{std::move(produce)};
+}
+
+/**
+ * @brief One queued log line. Short messages are stored inline so the
+ * common case never touches the heap after the queue is built.
+ */
+struct LogRecord {
+  static const size_t INLINE_SIZE = 232;
+
+  LogLevel level;
+  uint32_t length;
+  int64_t time_ns;       // wall clock, for the file sink timestamp
+  std::string *overflow; // owns the text when it does not fit inline
+  char text[INLINE_SIZE];
+};
+
 class Logger {
 private:
+  static const size_t QUEUE_SIZE = 4096;
+  // File sink rotation: uconnux.log -> uconnux.log.1 -> ... -> .N
+  static const size_t FILE_SINK_MAX_BYTES = 8 << 20;
+  static const int FILE_SINK_BACKUPS = 4;
+
   std::ostream &output_stream;
-  LogLevel min_level;
-  bool show_prefix;
-  std::mutex log_mutex;
+  std::atomic<LogLevel> min_level;
+  std::atomic<bool> show_prefix;
+  std::atomic<bool> show_color{true};
+
+  // Producers enqueue formatted records; one background writer drains them
+  // and emits each batch with a single write per sink.
+  MpscQueue<LogRecord, QUEUE_SIZE> queue;
+  std::thread writer;
+  std::mutex writer_mutex;
+  std::condition_variable writer_cv;
+  std::condition_variable flushed_cv;
+  std::atomic<bool> writer_sleeping{false};
+  std::atomic<bool> stopping{false};
+  std::atomic<size_t> written{0};
+
+  // Set by ThreadMute.
+  static inline thread_local bool thread_muted = false;
+
+  // File sink, guarded by sink_mutex (only contended on reconfiguration).
+  std::mutex sink_mutex;
+  int file_fd = -1;
+  std::string file_path;
+  size_t file_size = 0;
+
+  // Console output parked while the prompt owns the terminal, guarded by
+  // console_mutex.
+  std::mutex console_mutex;
+  bool console_held = false;
+  std::string held_console;
+  std::function<void()> console_notify;
 
   // --- DECLARATION only ---
-  std::string levelToString(LogLevel level) const;
-  std::string setColor(LogLevel level) const;
+  const char *levelToString(LogLevel level) const;
+  const char *setColor(LogLevel level) const;
+
+  void submit(LogLevel level, const char *text, size_t length);
+  void writerLoop();
+  void writeBatch(std::string &console, std::string &file);
+  void rotateFileSink();
 
 public:
   // --- DECLARATION only ---
   explicit Logger(std::ostream &stream = std::cout,
                   LogLevel level = LogLevel::INFO, bool prefix = true);
+  ~Logger();
+
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
 
   // --- DECLARATION only ---
   void setMinLevel(LogLevel level);
   void enablePrefix(bool enable);
+  void enableColor(bool enable);
 
-  // --- TEMPLATE METHODS (Must stay in header) ---
-  template <typename... Args> void log(LogLevel level, Args &&...args) {
-    std::lock_guard<std::mutex> lock(log_mutex);
-    // Basic level check (adjust based on enum values)
-    if (static_cast<int>(level) < static_cast<int>(min_level))
-      return;
+  /**
+   * @brief Mirrors every record, uncolored and timestamped, into
+   * <directory>/uconnux.log, rotating it once it grows past 8 MiB.
+   * @return false if the directory or file could not be opened.
+   */
+  bool enableFileSink(const std::string &directory);
+  void disableFileSink();
+
+  /**
+   * @brief Blocks until every record logged before the call is written.
+   *
+   * The interactive loop calls this before redrawing the prompt so command
+   * output never lands after it.
+   */
+  void flush();
 
-    output_stream << setColor(level);
+  /**
+   * @brief Parks console output instead of writing it, calling notify from
+   * the writer thread whenever more arrives.
+   *
+   * The interactive loop holds the console while readline owns the
+   * terminal, so lines from background jobs never land in the middle of
+   * the line being edited; it prints them above the prompt itself. The
+   * file sink is not affected.
+   */
+  void holdConsole(std::function<void()> notify);
+  /** @brief Moves the parked console output into text. */
+  void takeHeldConsole(std::string &text);
+  /** @brief Writes whatever is still parked and resumes direct output. */
+  void releaseConsole();
+
+  static constexpr bool isCompiledIn(LogLevel level) {
+    return logSeverity(level) >= logSeverity(LOGGER_COMPILED_MIN_LEVEL);
+  }
 
-    if (show_prefix) {
-      output_stream << "▐ " << std::flush;
-    }
+  /**
+   * @brief Drops every record logged by the constructing thread while it
+   * is alive; records from other threads are unaffected.
+   *
+   * `bench` mutes the commands it runs thousands of times so neither the
+   * console nor the log file fills with their output.
+   */
+  class ThreadMute {
+  public:
+    ThreadMute() : was_muted(thread_muted) { thread_muted = true; }
+    ~ThreadMute() { thread_muted = was_muted; }
+    ThreadMute(const ThreadMute &) = delete;
+    ThreadMute &operator=(const ThreadMute &) = delete;
 
-    // output_stream << levelToString(level) << " "; // Calls implementation
+  private:
+    bool was_muted;
+  };
 
-    std::stringstream ss;
-    using List = int[];
-    (void)List{0, ((void)(ss << args), 0)...};
-    output_stream << ss.str();
-    output_stream << std::endl;
+  /**
+   * @brief Cheap filter: one relaxed load, no lock, no formatting.
+   */
+  bool isEnabled(LogLevel level) const {
+    return isCompiledIn(level) && !thread_muted &&
+           logSeverity(level) >=
+               logSeverity(min_level.load(std::memory_order_relaxed));
+  }
+
+  // --- TEMPLATE METHODS (Must stay in header) ---
+  template <typename... Args> void log(LogLevel level, Args &&...args) {
+    // Level check first: filtered lines cost neither a lock nor formatting
+    if (!isEnabled(level))
+      return;
+
+    // Formatted into this thread's reusable buffer: no stream, no allocation
+    log_fmt::BufferLease lease;
+    log_fmt::appendAll(lease.get(), args...);
+    submit(level, lease.get().data(), lease.get().size());
   }
 
   template <typename... Args> void info(Args &&...args) {
-    log(LogLevel::INFO, std::forward<Args>(args)...);
+    logAt<LogLevel::INFO>(std::forward<Args>(args)...);
   }
   template <typename... Args> void success(Args &&...args) {
-    log(LogLevel::SUCCESS, std::forward<Args>(args)...);
+    logAt<LogLevel::SUCCESS>(std::forward<Args>(args)...);
   }
   template <typename... Args> void warn(Args &&...args) {
-    log(LogLevel::WARNING, std::forward<Args>(args)...);
+    logAt<LogLevel::WARNING>(std::forward<Args>(args)...);
   }
   template <typename... Args> void fatal(Args &&...args) {
-    log(LogLevel::FATAL, std::forward<Args>(args)...);
+    logAt<LogLevel::FATAL>(std::forward<Args>(args)...);
   }
   template <typename... Args> void debug(Args &&...args) {
-    log(LogLevel::DEBUG, std::forward<Args>(args)...);
+    logAt<LogLevel::DEBUG>(std::forward<Args>(args)...);
   }
+
+private:
+  // Levels below LOGGER_COMPILED_MIN_LEVEL resolve to the empty overload, so
+  // log() is never even instantiated for them.
+  template <LogLevel Level, typename... Args> void logAt(Args &&...args) {
+    logIf(std::integral_constant<bool, isCompiledIn(Level)>(), Level,
+          std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  void logIf(std::true_type, LogLevel level, Args &&...args) {
+    log(level, std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  void logIf(std::false_type, LogLevel, Args &&...) {}
 };
 
 extern Logger logger;
 
+/**
+ * @brief Default directory for the file sink: $HOME/uconnux, matching the
+ * Makefile's LOG_DIR. Empty if HOME is not set.
+ */
+std::string defaultLogDirectory();
+
 #endif // LOGGER_HPP
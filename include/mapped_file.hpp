@@ -0,0 +1,40 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ *
+ * Pages are faulted in on first touch, so large images and logs cost no
+ * read() copies and no up-front I/O. An empty file maps to size() == 0.
+ */
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * @param sequential Hint the kernel to read ahead aggressively.
+   * @return true on success, false with error filled otherwise.
+   */
+  bool open(const std::string &path, std::string &error,
+            bool sequential = true);
+  void close();
+
+  bool isOpen() const { return open_; }
+  const uint8_t *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  bool open_ = false;
+};
+
+#endif // MAPPED_FILE_HPP
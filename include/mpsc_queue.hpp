@@ -0,0 +1,124 @@
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief Bounded multi-producer/single-consumer queue.
+ *
+ * Each slot carries a sequence number that tells producers and the consumer
+ * whose turn it is (Vyukov's bounded queue). Producers claim a slot with one
+ * CAS on the shared enqueue index and never block each other while copying
+ * their payload; the single consumer needs no atomic RMW at all.
+ *
+ * Slots are allocated once at construction, so steady-state use performs no
+ * allocation. Capacity must be a power of two.
+ *
+ * @tparam T Slot payload, must be default constructible.
+ * @tparam Capacity Number of slots, must be a power of two.
+ */
+template <typename T, size_t Capacity> class MpscQueue {
+  static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0,
+                "MpscQueue capacity must be a power of two");
+
+private:
+  static const size_t CACHE_LINE = 64;
+  static const size_t MASK = Capacity - 1;
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  char pad0_[CACHE_LINE];
+  std::atomic<size_t> enqueue_pos_{0};
+  char pad1_[CACHE_LINE];
+  size_t dequeue_pos_ = 0;
+  char pad2_[CACHE_LINE];
+
+public:
+  MpscQueue() : slots_(new Slot[Capacity]) {
+    for (size_t i = 0; i < Capacity; i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  static constexpr size_t capacity() { return Capacity; }
+
+  /**
+   * @brief Claims a slot for writing (any thread).
+   *
+   * On success the caller fills *value in place and must then call
+   * publish() with the same ticket.
+   *
+   * @param value Set to the claimed slot's payload.
+   * @param ticket Set to the slot's position, passed back to publish().
+   * @return false if the queue is full.
+   */
+  bool tryClaim(T **value, size_t *ticket) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot &slot = slots_[pos & MASK];
+      size_t seq = slot.sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          *value = &slot.value;
+          *ticket = pos;
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // the consumer has not released this slot yet
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Makes a claimed slot visible to the consumer.
+   */
+  void publish(size_t ticket) {
+    slots_[ticket & MASK].sequence.store(ticket + 1,
+                                         std::memory_order_release);
+  }
+
+  /**
+   * @brief Returns the oldest published slot (consumer thread only).
+   * @return nullptr if the queue is empty.
+   */
+  T *front() {
+    Slot &slot = slots_[dequeue_pos_ & MASK];
+    size_t seq = slot.sequence.load(std::memory_order_acquire);
+    if (seq != dequeue_pos_ + 1) {
+      return nullptr;
+    }
+    return &slot.value;
+  }
+
+  /**
+   * @brief Releases the slot returned by front() (consumer thread only).
+   */
+  void pop() {
+    slots_[dequeue_pos_ & MASK].sequence.store(dequeue_pos_ + Capacity,
+                                               std::memory_order_release);
+    dequeue_pos_++;
+  }
+
+  /**
+   * @brief Number of slots claimed so far; a ticket upper bound for flushes.
+   */
+  size_t claimed() const {
+    return enqueue_pos_.load(std::memory_order_acquire);
+  }
+};
+
+#endif // MPSC_QUEUE_HPP
@@ -0,0 +1,60 @@
+#ifndef PAGE_DELTA_HPP
+#define PAGE_DELTA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bootloader_protocol.hpp"
+#include "firmware_image.hpp"
+
+/**
+ * Page bookkeeping for delta flashing: which erase pages an image touches,
+ * what each of them will hash to once flashed, and the slices of the image
+ * that fall in a chosen subset of pages.
+ *
+ * Pages are identified by their start address.
+ */
+namespace page_delta {
+
+/** @brief A run of consecutive pages. */
+struct PageRun {
+  uint32_t address;
+  uint32_t count;
+};
+
+/**
+ * @brief Collects the pages the segments touch, in ascending order.
+ * @return false with error filled if an image byte lies outside flash.
+ */
+bool touchedPages(const std::vector<Segment> &segments,
+                  const bootloader::DeviceInfo &info,
+                  std::vector<uint32_t> &pages, std::string &error);
+
+/** @brief Groups ascending page addresses into runs of consecutive pages. */
+std::vector<PageRun> runs(const std::vector<uint32_t> &pages,
+                          uint32_t page_size);
+
+/**
+ * @brief CRC-32 of each page as it reads after erasing and flashing the
+ *        segments: image bytes where there are any, 0xFF elsewhere.
+ *
+ * Pages are split into contiguous slices hashed on up to threads threads;
+ * small images stay on the calling thread.
+ */
+std::vector<uint32_t> hashPages(const std::vector<Segment> &segments,
+                                const std::vector<uint32_t> &pages,
+                                uint32_t page_size, unsigned threads);
+
+/**
+ * @brief The parts of the segments that fall in pages. The result points
+ *        into the same data, so it lives as long as the image.
+ */
+std::vector<Segment> clip(const std::vector<Segment> &segments,
+                          const std::vector<uint32_t> &pages,
+                          uint32_t page_size);
+
+} // namespace page_delta
+
+#endif // PAGE_DELTA_HPP
@@ -0,0 +1,256 @@
+#ifndef PORT_MANAGER_HPP
+#define PORT_MANAGER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture_file.hpp"
+#include "frame_decoder.hpp"
+#include "latency_histogram.hpp"
+#include "spsc_ring.hpp"
+
+/**
+ * @brief Snapshot of a port's state, used by the `ports` command.
+ */
+struct PortInfo {
+  std::string name;
+  std::string path;
+  int baud;
+  bool is_pty;
+  uint64_t rx_bytes;
+  uint64_t tx_bytes;
+  uint64_t rx_dropped;
+  size_t rx_buffered;
+  size_t tx_pending;
+  framing::Framing framing;
+  uint64_t frame_errors; // malformed plus oversized frames
+  uint64_t rx_frames;
+  uint64_t tx_writes;
+  uint64_t crc_errors;
+  size_t rx_peak;
+  std::chrono::steady_clock::time_point opened;
+};
+
+/**
+ * @brief One open tty owned by the PortManager.
+ *
+ * Bytes move between the I/O thread and command threads through two
+ * lock-free SPSC rings: the I/O thread is the only producer of rx_ring and
+ * the only consumer of tx_ring. The mutexes below only serialize multiple
+ * command-side readers (or writers) among themselves and park a thread that
+ * has to wait; the streaming path never takes them.
+ *
+ * The descriptor is closed when the last reference goes away, so a consumer
+ * holding a shared_ptr can never race a close() into a recycled fd number.
+ */
+class Port {
+public:
+  static const size_t RX_RING_SIZE = 1 << 20;
+  static const size_t TX_RING_SIZE = 1 << 16;
+
+  Port(std::string name, std::string path, int fd, int baud);
+  ~Port();
+
+  Port(const Port &) = delete;
+  Port &operator=(const Port &) = delete;
+
+  const std::string name;
+  const std::string path;
+  const int fd;
+  const int baud;
+
+  // Set only for ports created with PortManager::openPty().
+  int pty_slave_fd = -1;
+
+  std::atomic<uint64_t> rx_bytes{0};
+  std::atomic<uint64_t> tx_bytes{0};
+  std::atomic<uint64_t> rx_dropped{0};
+  std::atomic<bool> closed{false};
+
+  // Counters for `stats`: relaxed, bumped on paths that already touch the
+  // port, so they stay on.
+  std::atomic<uint64_t> rx_frames{0}; // delivered by readFrames()
+  std::atomic<uint64_t> tx_writes{0}; // write() calls
+  // Frames a protocol client such as Flasher rejected for a bad CRC.
+  std::atomic<uint64_t> crc_errors{0};
+  std::atomic<size_t> rx_peak{0};     // deepest rx_ring seen, I/O thread
+  const std::chrono::steady_clock::time_point opened =
+      std::chrono::steady_clock::now();
+  // Request/response round trips, timed by protocol clients such as
+  // Flasher.
+  LatencyHistogram round_trips;
+
+  SpscRing<uint8_t, RX_RING_SIZE> rx_ring;
+  SpscRing<uint8_t, TX_RING_SIZE> tx_ring;
+
+  // RX framing used by PortManager::readFrames(); guarded by reader_mutex.
+  framing::FrameDecoder decoder{framing::Framing::RAW};
+  // Copies of the decoder's mode and error count for list().
+  std::atomic<framing::Framing> framing{framing::Framing::RAW};
+  std::atomic<uint64_t> frame_errors{0};
+
+  // Command-side serialization: one reader and one writer at a time.
+  std::mutex reader_mutex;
+  std::mutex writer_mutex;
+
+  // Parking for a reader waiting on data or a writer waiting on space.
+  // The I/O thread only locks wait_mutex when a *_waiting flag is set.
+  std::mutex wait_mutex;
+  std::condition_variable rx_cv;
+  std::condition_variable tx_cv;
+  std::atomic<bool> rx_waiting{false};
+  std::atomic<bool> tx_waiting{false};
+
+  // Set by a writer when it hands the I/O thread new TX bytes; coalesces
+  // bursts of writes into a single wakeup.
+  std::atomic<bool> tx_scheduled{false};
+  bool tx_armed = false; // EPOLLOUT registered, I/O thread only
+};
+
+/**
+ * @brief Single-threaded epoll reactor that owns every open serial port.
+ *
+ * All descriptors are non-blocking and serviced by one background I/O thread,
+ * so the readline thread never blocks on a tty. Port removal is marshalled to
+ * the I/O thread; reads and writes may be issued from any thread.
+ */
+class PortManager {
+public:
+  static constexpr std::chrono::milliseconds DEFAULT_WRITE_TIMEOUT{1000};
+
+  // Receives each decoded frame; the view is only valid during the call.
+  using FrameSink = std::function<void(const framing::FrameView &)>;
+
+  PortManager();
+  ~PortManager();
+
+  PortManager(const PortManager &) = delete;
+  PortManager &operator=(const PortManager &) = delete;
+
+  /**
+   * @brief Opens a tty device and starts servicing it.
+   * @param name Filled with the name the port is registered under.
+   * @return true on success, false with error filled otherwise.
+   */
+  bool open(const std::string &path, int baud, std::string &name,
+            std::string &error);
+
+  /**
+   * @brief Creates a pty pair and services its master end.
+   *
+   * The slave end stays open for the lifetime of the port so the master never
+   * reports a hangup while no peer is attached.
+   */
+  bool openPty(std::string &name, std::string &slave_path,
+               std::string &error);
+
+  /**
+   * @brief Takes ownership of an already configured non-blocking fd.
+   *
+   * Lets callers plug in one end of an openpty() pair (or any other
+   * descriptor) without going through the device path.
+   */
+  bool adopt(int fd, const std::string &name, const std::string &path,
+             int baud, std::string &error);
+
+  /**
+   * @brief Closes a port by name or device path.
+   * @return true if a port was found and closed.
+   */
+  bool close(const std::string &name_or_path);
+
+  /**
+   * @brief Closes every open port.
+   * @return The number of ports closed.
+   */
+  size_t closeAll();
+
+  /**
+   * @brief Queues bytes for transmission.
+   *
+   * Waits up to timeout for ring space when the TX ring is full.
+   *
+   * @return The number of bytes accepted, or -1 if the port does not exist.
+   */
+  long write(const std::string &name, const void *data, size_t len,
+             std::chrono::milliseconds timeout = DEFAULT_WRITE_TIMEOUT);
+
+  /**
+   * @brief Reads buffered RX bytes, waiting up to timeout for the first one.
+   * @return The number of bytes copied, or -1 if the port does not exist.
+   */
+  long read(const std::string &name, void *data, size_t len,
+            std::chrono::milliseconds timeout);
+
+  /**
+   * @brief Selects how readFrames() splits the port's RX stream.
+   *
+   * Any partially received frame is discarded.
+   *
+   * @return false if the port does not exist.
+   */
+  bool setFraming(const std::string &name, framing::Framing mode);
+
+  /**
+   * @brief Decodes buffered RX bytes into frames, waiting up to timeout for
+   *        at least one complete frame.
+   *
+   * Frames are decoded in place in the RX ring and passed to sink as views,
+   * so no frame is copied unless it wrapped around the end of the ring.
+   *
+   * @return The number of frames delivered, or -1 if the port does not exist.
+   */
+  long readFrames(const std::string &name, const FrameSink &sink,
+                  std::chrono::milliseconds timeout);
+
+  std::vector<PortInfo> list() const;
+  std::shared_ptr<Port> find(const std::string &name_or_path) const;
+
+  /**
+   * @brief Copies every chunk read from or written to any port into
+   *        writer, timestamped on the I/O thread; nullptr stops.
+   *
+   * Replaces any previous writer. Once this returns, the previous one
+   * gets no more appends and may be closed.
+   */
+  void setCapture(std::shared_ptr<capture::Writer> writer);
+
+private:
+  int epoll_fd;
+  int wake_fd;
+  std::atomic<bool> stopping{false};
+  std::thread io_thread;
+
+  mutable std::mutex ports_mutex;
+  std::map<std::string, std::shared_ptr<Port>> ports;
+  unsigned next_pty_id = 0;
+
+  std::mutex ops_mutex;
+  std::vector<std::function<void()>> pending_ops;
+  std::vector<std::shared_ptr<Port>> tx_ready;
+
+  std::shared_ptr<capture::Writer> capture; // I/O thread only
+
+  void run();
+  void wake();
+  void runOnIoThread(std::function<void()> op);
+  bool addPort(std::shared_ptr<Port> port, std::string &error);
+  void removePort(Port *port);
+  bool waitReadable(Port &port, std::chrono::steady_clock::time_point deadline);
+  void handleReadable(Port *port);
+  void handleWritable(Port *port);
+  void scheduleTx(const std::shared_ptr<Port> &port);
+  void drainTx(Port &port);
+  void setTxArmed(Port &port, bool armed);
+};
+
+#endif // PORT_MANAGER_HPP
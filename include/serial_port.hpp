@@ -0,0 +1,53 @@
+#ifndef SERIAL_PORT_HPP
+#define SERIAL_PORT_HPP
+
+#include <string>
+#include <vector>
+
+namespace serial {
+
+const int DEFAULT_BAUD = 115200;
+
+/**
+ * @brief Opens a tty in raw, non-blocking mode and applies the baud rate.
+ *
+ * The descriptor is opened with O_NOCTTY | O_NONBLOCK | O_CLOEXEC and is
+ * marked exclusive (TIOCEXCL) so a second process cannot grab the same board.
+ *
+ * @param path Device path, e.g. /dev/ttyACM0.
+ * @param baud Baud rate, must be one of the standard termios rates.
+ * @param error Filled with a human readable reason on failure.
+ * @return The file descriptor, or -1 on failure.
+ */
+int openDevice(const std::string &path, int baud, std::string &error);
+
+/**
+ * @brief Creates a pseudo terminal pair for testing without hardware.
+ *
+ * Both ends are put in raw mode. The master end is non-blocking and is what
+ * the CLI reads/writes; the slave path can be handed to any other program.
+ *
+ * @return true on success, false with error filled otherwise.
+ */
+bool openPty(int &master_fd, int &slave_fd, std::string &slave_path,
+             std::string &error);
+
+/**
+ * @brief Applies raw mode and the given baud rate to an open tty.
+ * @return true on success, false with error filled otherwise.
+ */
+bool configure(int fd, int baud, std::string &error);
+
+/**
+ * @brief Checks whether a baud rate maps to a termios speed constant.
+ */
+bool isSupportedBaud(int baud);
+
+/**
+ * @brief All rates isSupportedBaud() accepts, in ascending order.
+ */
+std::vector<int> supportedBauds();
+
+} // namespace serial
+
+#endif // SERIAL_PORT_HPP
@@ -0,0 +1,183 @@
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Fixed-size, lock-free single-producer/single-consumer ring buffer.
+ *
+ * Exactly one thread may call the producer side (write, writeSpan,
+ * commitWrite) and exactly one thread may call the consumer side (read,
+ * readSpan, commitRead) at any time. The indices are free-running counters,
+ * so Capacity must be a power of two.
+ *
+ * The producer and consumer indices live on separate cache lines, and each
+ * side keeps a private copy of the other side's index so the shared line is
+ * only touched when the cached view says the ring is full (or empty).
+ *
+ * The span API exposes the ring storage directly, which lets the I/O thread
+ * read() from a tty straight into the ring and lets consumers parse bytes in
+ * place without copying them out first.
+ *
+ * @tparam T Element type, must be trivially copyable.
+ * @tparam Capacity Number of elements, must be a power of two.
+ */
+template <typename T, size_t Capacity> class SpscRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "SpscRing capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SpscRing elements must be trivially copyable");
+
+private:
+  static const size_t CACHE_LINE = 64;
+  static const size_t MASK = Capacity - 1;
+
+  // Padding instead of alignas() keeps the ring usable with plain
+  // operator new: any two fields 64+ bytes apart never share a line.
+  char pad0_[CACHE_LINE];
+  std::atomic<size_t> head_{0}; // next slot to write, owned by the producer
+  size_t cached_tail_ = 0;      // producer's last view of tail_
+  char pad1_[CACHE_LINE];
+  std::atomic<size_t> tail_{0}; // next slot to read, owned by the consumer
+  size_t cached_head_ = 0;      // consumer's last view of head_
+  char pad2_[CACHE_LINE];
+  T buffer_[Capacity];
+
+public:
+  SpscRing() = default;
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  static constexpr size_t capacity() { return Capacity; }
+
+  // --- Producer side ---
+
+  /**
+   * @brief Returns the largest contiguous writable region.
+   * @param ptr Set to the start of the region.
+   * @return Number of elements that may be written at ptr (may be 0).
+   */
+  size_t writeSpan(T **ptr) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (Capacity - (head - cached_tail_) == 0) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+    }
+    size_t free_count = Capacity - (head - cached_tail_);
+    size_t offset = head & MASK;
+    *ptr = &buffer_[offset];
+    return std::min(free_count, Capacity - offset);
+  }
+
+  /**
+   * @brief Publishes count elements previously filled through writeSpan().
+   */
+  void commitWrite(size_t count) {
+    head_.store(head_.load(std::memory_order_relaxed) + count,
+                std::memory_order_release);
+  }
+
+  /**
+   * @brief Copies up to count elements into the ring.
+   * @return Number of elements written; less than count if the ring filled.
+   */
+  size_t write(const T *data, size_t count) {
+    size_t written = 0;
+    while (written < count) {
+      T *ptr;
+      size_t span = writeSpan(&ptr);
+      if (span == 0) {
+        break;
+      }
+      size_t n = std::min(span, count - written);
+      std::memcpy(ptr, data + written, n * sizeof(T));
+      commitWrite(n);
+      written += n;
+    }
+    return written;
+  }
+
+  bool push(const T &value) { return write(&value, 1) == 1; }
+
+  // --- Consumer side ---
+
+  /**
+   * @brief Returns the largest contiguous readable region.
+   * @param ptr Set to the start of the region.
+   * @return Number of elements readable at ptr (may be 0).
+   */
+  size_t readSpan(const T **ptr) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (cached_head_ == tail) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+    }
+    size_t available = cached_head_ - tail;
+    size_t offset = tail & MASK;
+    *ptr = &buffer_[offset];
+    return std::min(available, Capacity - offset);
+  }
+
+  /**
+   * @brief Mutable variant of readSpan().
+   *
+   * The consumer owns the returned region until commitRead(), so it may
+   * rewrite it in place, e.g. to decode a frame without copying it out.
+   */
+  size_t readSpan(T **ptr) {
+    const T *readable;
+    size_t count = readSpan(&readable);
+    *ptr = const_cast<T *>(readable);
+    return count;
+  }
+
+  /**
+   * @brief Releases count elements previously obtained through readSpan().
+   */
+  void commitRead(size_t count) {
+    tail_.store(tail_.load(std::memory_order_relaxed) + count,
+                std::memory_order_release);
+  }
+
+  /**
+   * @brief Copies up to count elements out of the ring.
+   * @return Number of elements read; less than count if the ring drained.
+   */
+  size_t read(T *out, size_t count) {
+    size_t done = 0;
+    while (done < count) {
+      const T *ptr;
+      size_t span = readSpan(&ptr);
+      if (span == 0) {
+        break;
+      }
+      size_t n = std::min(span, count - done);
+      std::memcpy(out + done, ptr, n * sizeof(T));
+      commitRead(n);
+      done += n;
+    }
+    return done;
+  }
+
+  bool pop(T &value) { return read(&value, 1) == 1; }
+
+  // --- Either side ---
+
+  /**
+   * @brief Approximate number of buffered elements.
+   *
+   * Exact when called from the producer or consumer thread with the other
+   * side idle; otherwise a snapshot that may be stale by the time it returns.
+   */
+  size_t size() const {
+    size_t tail = tail_.load(std::memory_order_acquire);
+    size_t head = head_.load(std::memory_order_acquire);
+    return head - tail;
+  }
+
+  bool empty() const { return size() == 0; }
+};
+
+#endif // SPSC_RING_HPP
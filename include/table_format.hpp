@@ -0,0 +1,30 @@
+#ifndef TABLE_FORMAT_HPP
+#define TABLE_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Cell formatting for the tables commands such as `stats` and
+ *        `bench` print through the logger.
+ */
+namespace table_fmt {
+
+/** @brief 1234567 -> "1.2M", with unit appended. */
+std::string scaled(double value, const char *unit);
+
+/** @brief A duration in the largest unit that keeps it >= 1, e.g. "2.5 ms". */
+std::string duration(uint64_t ns);
+
+/**
+ * @brief Left-aligns the cells of one table row, padding each but the last
+ *        to its column's width.
+ */
+std::string row(const std::vector<std::string> &cells,
+                const std::vector<size_t> &widths);
+
+} // namespace table_fmt
+
+#endif // TABLE_FORMAT_HPP
@@ -0,0 +1,45 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed set of worker threads draining one FIFO of tasks.
+ *
+ * Meant for fanning blocking work (one device each) out and waiting for
+ * all of it, so tasks may block for as long as they like. The destructor
+ * runs whatever is still queued before joining.
+ */
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  size_t size() const { return workers_.size(); }
+
+  void submit(std::function<void()> task);
+  /** @brief Blocks until every task submitted so far has finished. */
+  void wait();
+
+private:
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  size_t running_ = 0;
+  bool stopping_ = false;
+
+  void workerLoop();
+};
+
+#endif // THREAD_POOL_HPP
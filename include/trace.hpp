@@ -0,0 +1,86 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Span tracing into per-thread buffers, written out as Chrome Trace
+ *        Event JSON (chrome://tracing, ui.perfetto.dev).
+ *
+ * Each thread appends finished spans to its own buffer, so tracing threads
+ * never contend with each other; the buffers are only gathered by stop().
+ * While tracing is off a Span is one relaxed load and a branch that is
+ * always taken the same way, so spans stay compiled into hot paths.
+ */
+namespace trace {
+
+// Spans recorded per thread between start() and stop(); later ones are
+// counted as dropped.
+const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+/** @brief Discards anything recorded before and starts recording. */
+void start();
+
+/**
+ * @brief Stops recording and writes every thread's spans to path.
+ * @param events Filled with the number of spans written.
+ * @param dropped Filled with the number of spans lost to full buffers.
+ * @return false with error filled if the file cannot be written. If it
+ *         cannot even be created, recording goes on and nothing is lost.
+ */
+bool stop(const std::string &path, size_t &events, size_t &dropped,
+          std::string &error);
+
+/** @brief Names the calling thread in traces, e.g. "io". */
+void nameThread(std::string name);
+
+/**
+ * @brief Times its own lifetime as one span.
+ *
+ * name and category must be string literals; detail (a port or command
+ * name) is copied, truncated to a few bytes, and only when tracing is on.
+ */
+class Span {
+public:
+  Span(const char *category, const char *name, std::string_view detail = {}) {
+    if (enabled()) {
+      begin(category, name, detail);
+    }
+  }
+  ~Span() {
+    if (begin_ns_ != 0) {
+      end();
+    }
+  }
+
+  Span(const Span &) = delete;
+  Span &operator=(const Span &) = delete;
+
+  /** @brief Attaches a byte count, shown as args.bytes. */
+  void setBytes(long bytes) { bytes_ = bytes; }
+
+  static const size_t DETAIL_SIZE = 24;
+
+private:
+  const char *category_ = nullptr;
+  const char *name_ = nullptr;
+  uint64_t begin_ns_ = 0;
+  long bytes_ = -1;
+  char detail_[DETAIL_SIZE];
+
+  void begin(const char *category, const char *name,
+             std::string_view detail);
+  void end();
+};
+
+} // namespace trace
+
+#endif // TRACE_HPP
@@ -0,0 +1,83 @@
+#include "../include/alloc_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Trivially constructible, so no TLS init guard on the allocation path.
+thread_local alloc_counter::Counts counts;
+
+void *allocate(std::size_t size) {
+  counts.allocations++;
+  counts.bytes += size;
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t align) {
+  counts.allocations++;
+  counts.bytes += size;
+  std::size_t alignment = static_cast<std::size_t>(align);
+  // aligned_alloc() wants a multiple of the alignment.
+  std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+  void *p = std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void release(void *p) {
+  if (p != nullptr) {
+    counts.frees++;
+    std::free(p);
+  }
+}
+
+} // namespace
+
+namespace alloc_counter {
+
+Counts thisThread() { return counts; }
+
+} // namespace alloc_counter
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+void *operator new(std::size_t size, std::align_val_t align) {
+  return allocateAligned(size, align);
+}
+void *operator new[](std::size_t size, std::align_val_t align) {
+  return allocateAligned(size, align);
+}
+
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, std::size_t) noexcept { release(p); }
+void operator delete[](void *p, std::size_t) noexcept { release(p); }
+void operator delete(void *p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { release(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  release(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  release(p);
+}
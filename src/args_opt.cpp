@@ -1,4 +1,9 @@
 #include "../include/args_opt.hpp"
+#include "../include/serial_port.hpp"
+#include "../include/trace.hpp"
+
+#include <cerrno>
+#include <cstdlib>
 #include <string>
 
 namespace opt_parser {
@@ -17,11 +22,11 @@ void Option::set_arg(std::string arg) { this->arg = arg; }
 
 char Option::get_letter() const { return letter; }
 
-std::string Option::get_name() const { return name; }
+const std::string &Option::get_name() const { return name; }
 
 ArgumentOptions Option::get_arg_option() const { return arg_option; }
 
-std::string Option::get_arg() const { return arg; }
+const std::string &Option::get_arg() const { return arg; }
 
 bool Option::get_found() const { return found; }
 
@@ -37,7 +42,7 @@ Option *OptionsParser::findOption(char letter) {
   return nullptr;
 }
 
-Option *OptionsParser::findOption(std::string name) {
+Option *OptionsParser::findOption(const std::string &name) {
   for (Option &opt : options) {
     if (opt.get_name() == name) {
       return &opt;
@@ -60,8 +65,8 @@ void OptionsParser::addOption(char letter, ArgumentOptions arg_option) {
 const std::vector<Option> &OptionsParser::getOptions() const { return options; }
 
 int OptionsParser::parseOptionsString(std::vector<std::string> const &args) {
+  trace::Span span("cli", "OptionsParser::parseOptionsString");
   size_t i;
-  int last_index = 0;
 
   for (Option &option : options) {
     option.set_arg("");
@@ -109,11 +114,330 @@ int OptionsParser::parseOptionsString(std::vector<std::string> const &args) {
     } else {
       break;
     }
+  }
+
+  // Index of the first positional argument.
+  return static_cast<int>(i);
+}
+
+namespace {
+
+int hexDigit(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+bool isHexSeparator(char c) {
+  return c == ' ' || c == ':' || c == ',' || c == '-';
+}
+
+bool parseInteger(std::string_view text, int64_t &value) {
+  if (text.empty()) {
+    return false;
+  }
+  std::string copy(text); // strtoll needs a terminator
+  char *end = nullptr;
+  errno = 0;
+  long long parsed = std::strtoll(copy.c_str(), &end, 0);
+  if (errno != 0 || end != copy.c_str() + copy.size()) {
+    return false;
+  }
+  value = parsed;
+  return true;
+}
+
+bool parseBaud(std::string_view text, int64_t &value) {
+  if (text.empty() || text.size() > 8) {
+    return false;
+  }
+  int64_t baud = 0;
+  for (char c : text) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    baud = baud * 10 + (c - '0');
+  }
+  if (!serial::isSupportedBaud(static_cast<int>(baud))) {
+    return false;
+  }
+  value = baud;
+  return true;
+}
+
+// Groups are split by separators; each may carry a 0x prefix and must hold
+// whole bytes.
+bool parseHexBytes(std::string_view text, std::vector<uint8_t> &out) {
+  size_t start_size = out.size();
+  size_t i = 0;
+  while (i < text.size()) {
+    if (isHexSeparator(text[i])) {
+      i++;
+      continue;
+    }
+    if (text.size() - i >= 2 && text[i] == '0' &&
+        (text[i + 1] == 'x' || text[i + 1] == 'X')) {
+      i += 2;
+    }
+    size_t group = i;
+    while (i < text.size() && !isHexSeparator(text[i])) {
+      if (hexDigit(text[i]) < 0) {
+        return false;
+      }
+      i++;
+    }
+    if (i == group || (i - group) % 2 != 0) {
+      return false;
+    }
+    for (size_t j = group; j < i; j += 2) {
+      out.push_back(
+          static_cast<uint8_t>(hexDigit(text[j]) << 4 | hexDigit(text[j + 1])));
+    }
+  }
+  return out.size() > start_size;
+}
 
-    last_index++;
+bool parseDuration(std::string_view text, int64_t &micros) {
+  size_t i = 0;
+  double value = 0;
+  bool digits = false;
+  while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+    value = value * 10 + (text[i++] - '0');
+    digits = true;
+  }
+  if (i < text.size() && text[i] == '.') {
+    double scale = 0.1;
+    for (i++; i < text.size() && text[i] >= '0' && text[i] <= '9'; i++) {
+      value += (text[i] - '0') * scale;
+      scale /= 10;
+      digits = true;
+    }
+  }
+  if (!digits) {
+    return false;
+  }
+
+  std::string_view unit = text.substr(i);
+  double scale;
+  if (unit.empty() || unit == "ms") {
+    scale = 1e3;
+  } else if (unit == "us") {
+    scale = 1;
+  } else if (unit == "s") {
+    scale = 1e6;
+  } else if (unit == "m") {
+    scale = 60e6;
+  } else {
+    return false;
+  }
+  value *= scale;
+  if (value > 9.2e18) {
+    return false;
+  }
+  micros = static_cast<int64_t>(value);
+  return true;
+}
+
+const char *describe(ValueType type) {
+  switch (type) {
+  case ValueType::INTEGER:
+    return "integer";
+  case ValueType::BAUD:
+    return "baud rate";
+  case ValueType::HEX_BYTES:
+    return "hex byte string";
+  case ValueType::DURATION:
+    return "duration";
+  case ValueType::STRING:
+    break;
+  }
+  return "value";
+}
+
+} // namespace
+
+/** ParsedOptions class **/
+const ParsedOptions::Value *ParsedOptions::lookup(char letter) const {
+  int index = table_->indexOf(letter);
+  if (index == OptionTable::NOT_FOUND || !values_[index].found) {
+    return nullptr;
+  }
+  return &values_[index];
+}
+
+bool ParsedOptions::has(char letter) const { return lookup(letter) != nullptr; }
+
+std::string_view ParsedOptions::str(char letter,
+                                    std::string_view fallback) const {
+  const Value *value = lookup(letter);
+  return value != nullptr ? value->text : fallback;
+}
+
+int64_t ParsedOptions::integer(char letter, int64_t fallback) const {
+  const Value *value = lookup(letter);
+  return value != nullptr && !value->text.empty() ? value->number : fallback;
+}
+
+int ParsedOptions::baud(char letter, int fallback) const {
+  return static_cast<int>(integer(letter, fallback));
+}
+
+std::chrono::microseconds
+ParsedOptions::duration(char letter, std::chrono::microseconds fallback) const {
+  const Value *value = lookup(letter);
+  if (value == nullptr || value->text.empty()) {
+    return fallback;
+  }
+  return std::chrono::microseconds(value->number);
+}
+
+std::vector<uint8_t> ParsedOptions::bytes(char letter) const {
+  const Value *value = lookup(letter);
+  if (value == nullptr) {
+    return {};
+  }
+  auto first = bytes_.begin() + value->bytes_offset;
+  return std::vector<uint8_t>(first, first + value->bytes_length);
+}
+
+bool ParsedOptions::set(int index, std::string_view text) {
+  const OptionSpec &spec = (*table_)[static_cast<size_t>(index)];
+  Value &value = values_[index];
+  value.found = true;
+  value.text = text;
+  if (text.empty() && spec.arg_option != ArgumentOptions::REQ_ARG) {
+    return true; // flag, or optional argument left out
+  }
+
+  bool valid = true;
+  switch (spec.type) {
+  case ValueType::STRING:
+    break;
+  case ValueType::INTEGER:
+    valid = parseInteger(text, value.number);
+    break;
+  case ValueType::BAUD:
+    valid = parseBaud(text, value.number);
+    break;
+  case ValueType::HEX_BYTES:
+    value.bytes_offset = static_cast<uint32_t>(bytes_.size());
+    valid = parseHexBytes(text, bytes_);
+    value.bytes_length = static_cast<uint32_t>(bytes_.size()) -
+                         value.bytes_offset;
+    break;
+  case ValueType::DURATION:
+    valid = parseDuration(text, value.number);
+    break;
+  }
+
+  if (!valid) {
+    value.found = false;
+    error_ = INVALID_VALUE;
+    error_message_ = "invalid ";
+    error_message_ += describe(spec.type);
+    error_message_ += " '";
+    error_message_ += text;
+    error_message_ += "' for option -";
+    error_message_ += spec.letter;
+  }
+  return valid;
+}
+
+/** OptionTable class **/
+ParsedOptions OptionTable::parse(const std::vector<std::string> &args) const {
+  trace::Span span("cli", "OptionTable::parse",
+                   args.empty() ? std::string_view() : args[0]);
+  ParsedOptions result(*this);
+  size_t i;
+
+  auto fail = [&result](int code, const char *what, std::string_view arg) {
+    result.error_ = code;
+    result.error_message_ = what;
+    result.error_message_ += " '";
+    result.error_message_ += arg;
+    result.error_message_ += "'";
+  };
+
+  for (i = 1; i < args.size(); i++) {
+    std::string_view arg = args[i];
+
+    if (arg == "--") {
+      i++;
+      break;
+    }
+    if (arg.size() < 2 || arg[0] != '-') {
+      break; // positional, including "-" alone
+    }
+
+    if (arg[1] == '-') {
+      std::string_view name = arg.substr(2);
+      std::string_view value;
+      size_t equals = name.find('=');
+      if (equals != std::string_view::npos) {
+        value = name.substr(equals + 1);
+        name = name.substr(0, equals);
+      }
+
+      int index = indexOf(name);
+      if (index == NOT_FOUND) {
+        fail(INVALID_OPTIONS, "unknown option", arg);
+        return result;
+      }
+      ArgumentOptions kind = specs_[index].arg_option;
+      if (equals != std::string_view::npos && kind == ArgumentOptions::NO_ARG) {
+        fail(INVALID_OPTIONS, "option takes no argument", arg);
+        return result;
+      }
+      if (equals == std::string_view::npos && kind == ArgumentOptions::REQ_ARG) {
+        if (i + 1 == args.size()) {
+          fail(MISSING_ARGUMENT, "missing argument for", arg);
+          return result;
+        }
+        value = args[++i];
+      }
+      if (!result.set(index, value)) {
+        return result;
+      }
+      continue;
+    }
+
+    // One or more bundled short options; an argument ends the bundle.
+    for (size_t j = 1; j < arg.size(); j++) {
+      int index = indexOf(arg[j]);
+      if (index == NOT_FOUND) {
+        const char letter[] = {'-', arg[j]};
+        fail(INVALID_OPTIONS, "unknown option",
+             std::string_view(letter, sizeof(letter)));
+        return result;
+      }
+
+      ArgumentOptions kind = specs_[index].arg_option;
+      std::string_view value;
+      if (kind != ArgumentOptions::NO_ARG && j + 1 < arg.size()) {
+        value = arg.substr(j + 1);
+        j = arg.size();
+      } else if (kind == ArgumentOptions::REQ_ARG) {
+        if (i + 1 == args.size()) {
+          fail(MISSING_ARGUMENT, "missing argument for", arg);
+          return result;
+        }
+        value = args[++i];
+      }
+      if (!result.set(index, value)) {
+        return result;
+      }
+    }
   }
 
-  return last_index;
+  result.first_positional_ = i;
+  return result;
 }
 
 } // namespace opt_parser
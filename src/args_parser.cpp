@@ -1,17 +1,19 @@
 #include "../include/args_parser.hpp" // Include the header first
+#include "../include/trace.hpp"
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>  // For std::cerr
-#include <cctype>    // For std::isspace
 
 // --- C headers needed for glob ---
+#include <fnmatch.h> // For fnmatch()
 #include <glob.h>    // For glob(), globfree(), glob_t
-#include <cstring>   // For strpbrk, std::memset
+#include <cstring>   // For std::memset
 
 namespace { // Use an anonymous namespace for internal linkage
 
-// RAII wrapper for glob_t (No changes needed here, works with C++11)
+// RAII wrapper for glob_t
 class GlobResult {
 private:
     glob_t glob_data;
@@ -44,40 +46,47 @@ public:
     }
 };
 
+// Character classes for the scanner: one table lookup per byte.
+enum CharClass : unsigned char { PLAIN = 0, SPACE = 1, QUOTE = 2 };
 
-// --- Argument Splitting Logic (Modified Escape Handling) ---
-// Takes const std::string& now, as string_view is removed
-std::vector<std::string> splitArguments(const std::string& input) {
-    std::vector<std::string> tokens;
-    std::string current_token;
-    current_token.reserve(64);
+struct ClassTable {
+    unsigned char table[256];
 
-    // State machine remains useful for quotes
+    ClassTable() : table() {
+        for (unsigned char c : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+            table[c] = SPACE;
+        }
+        table[static_cast<unsigned char>('\'')] = QUOTE;
+        table[static_cast<unsigned char>('"')] = QUOTE;
+    }
+};
+
+const ClassTable char_classes;
+
+inline unsigned char classOf(char c) {
+    return char_classes.table[static_cast<unsigned char>(c)];
+}
+
+// Slow path for a token that contains quotes: unescapes it into the arena.
+// Starts at the first quote; returns the index just past the token.
+size_t scanQuotedToken(std::string_view input, size_t i, std::string& arena) {
     enum class State { DEFAULT, IN_SINGLE_QUOTES, IN_DOUBLE_QUOTES };
     State state = State::DEFAULT;
 
-    for (std::size_t i = 0; i < input.length(); ++i) {
+    for (; i < input.length(); ++i) {
         char c = input[i];
-        char next_c = (i + 1 < input.length()) ? input[i+1] : '\0'; // Lookahead
 
         switch (state) {
             case State::DEFAULT:
-                if (std::isspace(static_cast<unsigned char>(c))) {
-                    // End of token if we have accumulated one
-                    if (!current_token.empty()) {
-                        // Use emplace_back(std::move(...)) in C++11 for efficiency
-                        tokens.emplace_back(std::move(current_token));
-                        current_token.clear();
-                        current_token.reserve(64);
-                    }
+                if (classOf(c) == SPACE) {
+                    return i; // End of token
                 } else if (c == '\'') {
                     state = State::IN_SINGLE_QUOTES;
                 } else if (c == '"') {
                     state = State::IN_DOUBLE_QUOTES;
-                } else if (c == '\\') {
-                    current_token += c;
                 } else {
-                    current_token += c;
+                    // Backslashes outside quotes are kept literally
+                    arena += c;
                 }
                 break;
 
@@ -85,92 +94,147 @@ std::vector<std::string> splitArguments(const std::string& input) {
                 if (c == '\'') {
                     state = State::DEFAULT;
                 } else {
-                    current_token += c;
+                    arena += c;
                 }
                 break;
 
             case State::IN_DOUBLE_QUOTES:
                 if (c == '"') {
-                    state = State::DEFAULT; // End quote state
-                    // Don't add the quote itself
-                } else if (c == '\\') {
-                    // --- Modified Escape Logic ---
-                    // Check if the next character is special (\, ", ')
-                    if (next_c == '\\' || next_c == '"' || next_c == '\'') {
-                        // Escape the special character: add it and skip it in the next iteration
-                        current_token += next_c;
-                        i++; // Consume the escaped character
-                    } else {
-                        // Not escaping a special char, treat backslash literally
-                        current_token += c;
-                    }
+                    state = State::DEFAULT; // Don't add the quote itself
+                } else if (c == '\\' && i + 1 < input.length() &&
+                           (input[i + 1] == '\\' || input[i + 1] == '"' ||
+                            input[i + 1] == '\'')) {
+                    // Escape the special character and skip it
+                    arena += input[++i];
                 } else {
-                    // Regular character inside double quotes
-                    current_token += c;
+                    // Not escaping a special char, treat backslash literally
+                    arena += c;
                 }
                 break;
         }
     }
 
-    // Handle unclosed quotes (same as before)
-    if (state == State::IN_SINGLE_QUOTES || state == State::IN_DOUBLE_QUOTES) {
+    if (state != State::DEFAULT) {
         std::cerr << "Warning: Unclosed quote encountered in input string." << std::endl;
     }
+    return i;
+}
 
-    // Add the last token if any
-    if (!current_token.empty()) {
-        tokens.emplace_back(std::move(current_token));
+// Appends one argument, expanding it through glob() when it has wildcards.
+void expandInto(std::string_view token, GlobResult& glob_result,
+                std::vector<std::string>& out) {
+    if (!hasWildcards(token)) {
+        out.emplace_back(token);
+        return;
     }
 
-    return tokens;
+    // glob() needs a NUL-terminated pattern; wildcard tokens are rare.
+    std::string pattern(token);
+    // GLOB_TILDE might be a GNU extension, but often available. GLOB_ERR is POSIX.
+    int ret = glob_result.call_glob(pattern.c_str(), GLOB_ERR | GLOB_TILDE);
+
+    if (ret == 0) {
+        size_t match_count = glob_result.count();
+        out.reserve(out.size() + match_count);
+        for (size_t j = 0; j < match_count; ++j) {
+            out.emplace_back(glob_result[j]);
+        }
+    } else if (ret == GLOB_NOMATCH) {
+        // Do nothing.
+    } else {
+        std::cerr << "Warning: glob() failed for pattern '" << pattern
+                  << "' (error code " << ret << "). Treating pattern as literal argument.\n";
+        out.push_back(std::move(pattern));
+    }
 }
 
+} // end anonymous namespace
 
-// --- Wildcard Expansion Logic (No changes needed, works with C++11) ---
-std::vector<std::string> expandWildcards(const std::vector<std::string>& args) {
-    std::vector<std::string> expanded_args;
-    expanded_args.reserve(args.size());
-    GlobResult glob_result;
 
-    for (const std::string& arg : args) {
-        // std::string::npos exists since C++98
-        // arg.find_first_of is C++11
-        if (arg.find_first_of("*?[]") == std::string::npos) {
-            expanded_args.push_back(arg); // push_back is fine
-        } else {
-            // std::string::c_str() exists since C++98
-            // GLOB_TILDE might be a GNU extension, but often available. GLOB_ERR is POSIX.
-            int ret = glob_result.call_glob(arg.c_str(), GLOB_ERR | GLOB_TILDE);
-
-            if (ret == 0) {
-                size_t match_count = glob_result.count();
-                expanded_args.reserve(expanded_args.size() + match_count);
-                for (size_t j = 0; j < match_count; ++j) {
-                    expanded_args.emplace_back(glob_result[j]);
-                }
-            } else if (ret == GLOB_NOMATCH) {
-                // Do nothing.
-            } else {
-                std::cerr << "Warning: glob() failed for pattern '" << arg
-                          << "' (error code " << ret << "). Treating pattern as literal argument.\n";
-                expanded_args.push_back(arg);
-            }
+void tokenizeCommandLine(std::string_view input, CommandTokens& out) {
+    out.clear();
+    // Unescaped text is never longer than the line: no reallocation, so
+    // views into the arena stay valid while we keep appending.
+    out.arena_.reserve(input.length());
+
+    size_t i = 0;
+    const size_t n = input.length();
+
+    while (true) {
+        while (i < n && classOf(input[i]) == SPACE) {
+            ++i;
+        }
+        if (i >= n) {
+            break;
+        }
+
+        // Fast path: plain run up to whitespace or a quote.
+        size_t start = i;
+        while (i < n && classOf(input[i]) == PLAIN) {
+            ++i;
+        }
+        if (i == n || classOf(input[i]) == SPACE) {
+            out.tokens_.emplace_back(input.data() + start, i - start);
+            continue;
+        }
+
+        // Quoted token: copy the plain prefix, unescape the rest.
+        size_t arena_start = out.arena_.size();
+        out.arena_.append(input.data() + start, i - start);
+        i = scanQuotedToken(input, i, out.arena_);
+
+        // Empty tokens (e.g. "") are dropped, as before.
+        size_t len = out.arena_.size() - arena_start;
+        if (len > 0) {
+            out.tokens_.emplace_back(out.arena_.data() + arena_start, len);
         }
     }
-    return expanded_args;
 }
 
-} // end anonymous namespace
+bool hasWildcards(std::string_view token) {
+    return token.find_first_of("*?[]") != std::string_view::npos;
+}
+
+bool matchWildcard(std::string_view pattern, std::string_view name) {
+    // glob() matches each path component with fnmatch() and these flags.
+    return fnmatch(std::string(pattern).c_str(), std::string(name).c_str(),
+                   FNM_PERIOD) == 0;
+}
+
+std::vector<std::string> materializeTokens(const CommandTokens& tokens,
+                                           bool expand_wildcards) {
+    std::vector<std::string> final_args;
+    final_args.reserve(tokens.size());
+    if (!expand_wildcards) {
+        final_args.assign(tokens.begin(), tokens.end());
+        return final_args;
+    }
+    GlobResult glob_result;
+    for (std::string_view token : tokens) {
+        expandInto(token, glob_result, final_args);
+    }
+    return final_args;
+}
+
+std::vector<std::string> expandWildcards(const std::vector<std::string>& arguments) {
+    std::vector<std::string> final_args;
+    final_args.reserve(arguments.size());
+    GlobResult glob_result;
+    for (const std::string& argument : arguments) {
+        expandInto(argument, glob_result, final_args);
+    }
+    return final_args;
+}
 
 
 // --- Public Interface Function ---
-// Only the std::string version remains
 std::vector<std::string> parseCommandLine(const std::string& commandLine) {
-    // 1. Split arguments respecting quotes (now takes std::string)
-    std::vector<std::string> initial_args = splitArguments(commandLine);
+    trace::Span span("cli", "parseCommandLine");
 
-    // 2. Expand wildcards
-    std::vector<std::string> final_args = expandWildcards(initial_args);
+    // 1. Split arguments respecting quotes, reusing this thread's buffers
+    thread_local CommandTokens tokens;
+    tokenizeCommandLine(commandLine, tokens);
 
-    return final_args;
+    // 2. Materialize each argument once, expanding wildcards
+    return materializeTokens(tokens, true);
 }
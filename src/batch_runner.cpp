@@ -0,0 +1,274 @@
+#include "../include/batch_runner.hpp"
+#include "../include/args_opt.hpp"
+#include "../include/command_registry.hpp"
+#include "../include/icommand.hpp"
+#include "../include/interrupt.hpp"
+#include "../include/job_manager.hpp"
+#include "../include/logger.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+extern Logger logger;
+
+namespace {
+
+const size_t READ_CHUNK = 64 * 1024;
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'c', "command", ArgumentOptions::REQ_ARG, ValueType::STRING},
+    {'k', "keep-going", ArgumentOptions::NO_ARG, ValueType::STRING},
+    {'h', "help", ArgumentOptions::NO_ARG, ValueType::STRING},
+});
+
+bool isBlankOrComment(const std::string &line) {
+  size_t first = line.find_first_not_of(" \t\r");
+  return first == std::string::npos || line[first] == '#';
+}
+
+int exitCodeFor(int result) {
+  if (result == COMMAND_EXIT_REQUESTED) {
+    return EXIT_OK;
+  }
+  if (result == COMMAND_NOT_FOUND) {
+    return EXIT_COMMAND_NOT_FOUND;
+  }
+  if (result == COMMAND_CANCELLED) {
+    return EXIT_INTERRUPTED;
+  }
+  return result == COMMAND_SUCCESS ? EXIT_OK : EXIT_COMMAND_FAILED;
+}
+
+} // namespace
+
+void printUsage(const char *program) {
+  std::printf("Usage: %s [-k] [-c \"<commands>\"] [<script>|-]\n"
+              "\n"
+              "Without arguments and on a terminal, starts the interactive "
+              "shell.\n"
+              "Otherwise runs commands headless (no banner, no readline):\n"
+              "  -c, --command <cmds>  run <cmds>; separate commands with ';'\n"
+              "  <script>              run commands from a file, '-' for "
+              "stdin\n"
+              "  (piped stdin)         run commands as they arrive\n"
+              "  -k, --keep-going      continue after a failing command\n"
+              "  -h, --help            show this help\n"
+              "\n"
+              "Exit status: 0 success, 1 command failed, 2 usage error, "
+              "127 unknown command, 130 interrupted.\n",
+              program);
+}
+
+bool parseBatchOptions(const std::vector<std::string> &argv,
+                       BatchOptions &options, std::string &error) {
+  opt_parser::ParsedOptions parsed = OPTIONS.parse(argv);
+  if (!parsed.ok()) {
+    error = parsed.errorMessage();
+    return false;
+  }
+
+  options.show_help = parsed.has('h');
+  options.keep_going = parsed.has('k');
+  if (parsed.has('c')) {
+    options.commands = splitScript(std::string(parsed.str('c')));
+  }
+
+  size_t first_arg = parsed.firstPositional();
+  size_t positional = argv.size() - first_arg;
+  if (positional > 1) {
+    error = "at most one script may be given";
+    return false;
+  }
+  if (positional == 1) {
+    options.script_path = argv[first_arg];
+  }
+  return true;
+}
+
+std::vector<std::string> splitScript(const std::string &text) {
+  std::vector<std::string> lines;
+  std::string current;
+  char quote = '\0';
+
+  for (size_t i = 0; i < text.size(); i++) {
+    char c = text[i];
+    if (quote != '\0') {
+      if (c == '\\' && quote == '"' && i + 1 < text.size()) {
+        current += c;
+        c = text[++i];
+      } else if (c == quote) {
+        quote = '\0';
+      }
+      current += c;
+    } else if (c == '\'' || c == '"') {
+      quote = c;
+      current += c;
+    } else if (c == '\n' || c == ';') {
+      if (!isBlankOrComment(current)) {
+        lines.push_back(current);
+      }
+      current.clear();
+    } else {
+      current += c;
+    }
+  }
+  if (!isBlankOrComment(current)) {
+    lines.push_back(current);
+  }
+  return lines;
+}
+
+int runBatchLines(CommandRegistry &registry, JobManager &jobs,
+                  const std::vector<std::string> &lines, bool keep_going,
+                  bool &exit_requested) {
+  int exit_code = EXIT_OK;
+
+  for (std::string line : lines) {
+    int result;
+    try {
+      bool background = JobManager::takeBackgroundMarker(line);
+      std::vector<std::string> arguments = registry.parseLine(line);
+      if (arguments.empty()) {
+        continue;
+      }
+      if (background) {
+        logger.info("[", jobs.start(std::move(arguments), line), "] ", line);
+        continue;
+      }
+      CommandContext context;
+      interrupt::Foreground foreground(context.token());
+      result = registry.executeCommand(arguments, context);
+    } catch (const std::exception &e) {
+      logger.fatal("Error running '", line, "': ", e.what());
+      result = COMMAND_ERROR;
+    }
+
+    if (result == COMMAND_EXIT_REQUESTED) {
+      exit_requested = true;
+      break;
+    }
+
+    int code = exitCodeFor(result);
+    if (code != EXIT_OK) {
+      if (exit_code == EXIT_OK) {
+        exit_code = code;
+      }
+      if (!keep_going || code == EXIT_INTERRUPTED) {
+        exit_requested = true;
+        break;
+      }
+    }
+  }
+  return exit_code;
+}
+
+int runBatchStream(CommandRegistry &registry, JobManager &jobs, int fd,
+                   bool keep_going, bool &exit_requested) {
+  std::string pending;
+  std::vector<char> chunk(READ_CHUNK);
+  int exit_code = EXIT_OK;
+
+  while (!exit_requested) {
+    ssize_t n = ::read(fd, chunk.data(), chunk.size());
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      logger.fatal("Error reading commands: ", std::strerror(errno));
+      return EXIT_USAGE;
+    }
+
+    size_t complete;
+    if (n == 0) {
+      complete = pending.size(); // EOF: run whatever is left
+    } else {
+      pending.append(chunk.data(), static_cast<size_t>(n));
+      size_t newline = pending.rfind('\n');
+      if (newline == std::string::npos) {
+        continue;
+      }
+      complete = newline + 1;
+    }
+
+    std::vector<std::string> lines = splitScript(pending.substr(0, complete));
+    pending.erase(0, complete);
+
+    int code =
+        runBatchLines(registry, jobs, lines, keep_going, exit_requested);
+    if (exit_code == EXIT_OK) {
+      exit_code = code;
+    }
+    if (n == 0) {
+      break;
+    }
+  }
+  return exit_code;
+}
+
+namespace {
+
+// runBatch() without waiting for background jobs.
+int runBatchCommands(CommandRegistry &registry, JobManager &jobs,
+                     const BatchOptions &options, bool &exit_requested) {
+  int exit_code = EXIT_OK;
+
+  if (!options.commands.empty()) {
+    exit_code = runBatchLines(registry, jobs, options.commands,
+                              options.keep_going, exit_requested);
+    if (exit_requested) {
+      return exit_code;
+    }
+  }
+
+  int fd = -1;
+  if (options.script_path == "-") {
+    fd = STDIN_FILENO;
+  } else if (!options.script_path.empty()) {
+    fd = ::open(options.script_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      logger.fatal("Cannot open script ", options.script_path, ": ",
+                   std::strerror(errno));
+      return EXIT_USAGE;
+    }
+  } else if (options.commands.empty()) {
+    fd = STDIN_FILENO; // piped input
+  }
+
+  if (fd >= 0) {
+    int code = runBatchStream(registry, jobs, fd, options.keep_going,
+                              exit_requested);
+    if (exit_code == EXIT_OK) {
+      exit_code = code;
+    }
+    if (fd != STDIN_FILENO) {
+      ::close(fd);
+    }
+  }
+  return exit_code;
+}
+
+} // namespace
+
+int runBatch(CommandRegistry &registry, JobManager &jobs,
+             const BatchOptions &options) {
+  bool exit_requested = false;
+  int exit_code = runBatchCommands(registry, jobs, options, exit_requested);
+  // After `exit` or a failure that stopped the run, the JobManager's
+  // destructor cancels whatever is still running.
+  if (exit_requested) {
+    return exit_code;
+  }
+  if (!jobs.waitAll() && exit_code == EXIT_OK) {
+    exit_code = EXIT_COMMAND_FAILED;
+  }
+  return exit_code;
+}
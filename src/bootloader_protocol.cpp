@@ -0,0 +1,112 @@
+#include "../include/bootloader_protocol.hpp"
+#include "../include/crc.hpp"
+#include "../include/frame_decoder.hpp"
+
+namespace bootloader {
+
+const char *statusName(uint8_t status) {
+  switch (status) {
+  case STATUS_OK:
+    return "ok";
+  case STATUS_BAD_PACKET:
+    return "bad packet";
+  case STATUS_OUT_OF_RANGE:
+    return "address out of range";
+  case STATUS_NOT_ERASED:
+    return "target not erased";
+  case STATUS_UNALIGNED:
+    return "not page aligned";
+  case STATUS_UNKNOWN:
+    return "unsupported request";
+  }
+  return "unknown status";
+}
+
+PacketWriter::PacketWriter(Opcode opcode) { packet_.push_back(opcode); }
+
+PacketWriter &PacketWriter::u8(uint8_t value) {
+  packet_.push_back(value);
+  return *this;
+}
+
+PacketWriter &PacketWriter::u16(uint16_t value) {
+  packet_.push_back(static_cast<uint8_t>(value));
+  packet_.push_back(static_cast<uint8_t>(value >> 8));
+  return *this;
+}
+
+PacketWriter &PacketWriter::u32(uint32_t value) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    packet_.push_back(static_cast<uint8_t>(value >> shift));
+  }
+  return *this;
+}
+
+PacketWriter &PacketWriter::bytes(const uint8_t *data, size_t len) {
+  packet_.insert(packet_.end(), data, data + len);
+  return *this;
+}
+
+void PacketWriter::finish(std::vector<uint8_t> &wire) {
+  crc::appendTrailer(crc::Algorithm::CRC32, packet_);
+  framing::cobsEncode(packet_.data(), packet_.size(), wire);
+}
+
+PacketReader::PacketReader(const uint8_t *data, size_t len)
+    : pos_(data), end_(data) {
+  const size_t crc_size = crc::checksumSize(crc::Algorithm::CRC32);
+  if (len < 1 + crc_size ||
+      !crc::verifyTrailer(crc::Algorithm::CRC32, data, len)) {
+    return;
+  }
+  valid_ = true;
+  opcode_ = data[0];
+  pos_ = data + 1;
+  end_ = data + len - crc_size;
+}
+
+bool PacketReader::take(size_t len) {
+  if (static_cast<size_t>(end_ - pos_) < len) {
+    truncated_ = true;
+    pos_ = end_;
+    return false;
+  }
+  return true;
+}
+
+uint8_t PacketReader::u8() {
+  if (!take(1)) {
+    return 0;
+  }
+  return *pos_++;
+}
+
+uint16_t PacketReader::u16() {
+  if (!take(2)) {
+    return 0;
+  }
+  uint16_t value = static_cast<uint16_t>(pos_[0] | (pos_[1] << 8));
+  pos_ += 2;
+  return value;
+}
+
+uint32_t PacketReader::u32() {
+  if (!take(4)) {
+    return 0;
+  }
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    value |= static_cast<uint32_t>(pos_[i]) << (8 * i);
+  }
+  pos_ += 4;
+  return value;
+}
+
+const uint8_t *PacketReader::rest(size_t &len) {
+  const uint8_t *start = pos_;
+  len = static_cast<size_t>(end_ - pos_);
+  pos_ = end_;
+  return start;
+}
+
+} // namespace bootloader
@@ -0,0 +1,402 @@
+#include "../include/byte_search.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BYTE_SEARCH_X86 1
+#endif
+
+namespace byte_search {
+
+namespace {
+
+// Finds the first p in [p, end) with p[0] == first and p[gap] == last;
+// p[gap] must be readable for every such p.
+using FindFn = const uint8_t *(*)(const uint8_t *, const uint8_t *, uint8_t,
+                                  uint8_t, size_t);
+
+const uint8_t *findScalar(const uint8_t *p, const uint8_t *end,
+                          uint8_t first, uint8_t last, size_t gap) {
+  while (p < end) {
+    p = static_cast<const uint8_t *>(std::memchr(p, first, end - p));
+    if (p == nullptr) {
+      return end;
+    }
+    if (p[gap] == last) {
+      return p;
+    }
+    ++p;
+  }
+  return end;
+}
+
+#if defined(BYTE_SEARCH_X86) && defined(__SSE2__)
+const uint8_t *findSse2(const uint8_t *p, const uint8_t *end, uint8_t first,
+                        uint8_t last, size_t gap) {
+  const __m128i firsts = _mm_set1_epi8(static_cast<char>(first));
+  const __m128i lasts = _mm_set1_epi8(static_cast<char>(last));
+  while (end - p >= 16) {
+    __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i tail =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + gap));
+    int mask = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(head, firsts), _mm_cmpeq_epi8(tail, lasts)));
+    if (mask != 0) {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 16;
+  }
+  return findScalar(p, end, first, last, gap);
+}
+
+__attribute__((target("avx2"))) const uint8_t *
+findAvx2(const uint8_t *p, const uint8_t *end, uint8_t first, uint8_t last,
+         size_t gap) {
+  const __m256i firsts = _mm256_set1_epi8(static_cast<char>(first));
+  const __m256i lasts = _mm256_set1_epi8(static_cast<char>(last));
+  while (end - p >= 32) {
+    __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i tail =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + gap));
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(head, firsts),
+                         _mm256_cmpeq_epi8(tail, lasts))));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return findSse2(p, end, first, last, gap);
+}
+#endif
+
+bool supports(ScanLevel level) {
+  switch (level) {
+  case ScanLevel::SCALAR:
+    return true;
+#if defined(BYTE_SEARCH_X86) && defined(__SSE2__)
+  case ScanLevel::SSE2:
+    return true;
+  case ScanLevel::AVX2:
+    return __builtin_cpu_supports("avx2");
+#else
+  case ScanLevel::SSE2:
+  case ScanLevel::AVX2:
+    return false;
+#endif
+  }
+  return false;
+}
+
+FindFn functionFor(ScanLevel level) {
+  switch (level) {
+#if defined(BYTE_SEARCH_X86) && defined(__SSE2__)
+  case ScanLevel::SSE2:
+    return findSse2;
+  case ScanLevel::AVX2:
+    return findAvx2;
+#endif
+  default:
+    return findScalar;
+  }
+}
+
+ScanLevel detectScanLevel() {
+  if (supports(ScanLevel::AVX2)) {
+    return ScanLevel::AVX2;
+  }
+  if (supports(ScanLevel::SSE2)) {
+    return ScanLevel::SSE2;
+  }
+  return ScanLevel::SCALAR;
+}
+
+const ScanLevel best_level = detectScanLevel();
+ScanLevel active_level = best_level;
+FindFn active_find = functionFor(best_level);
+
+// Literal text every match of expression contains: the first run of
+// plain characters outside groups and classes if the expression starts
+// with one (anchored), else the longest such run. A character a
+// quantifier may drop ends the run without it. Any alternation disables
+// this, as the text might belong to one branch only.
+std::vector<uint8_t> requiredLiteral(const std::string &expression,
+                                     bool &anchored) {
+  std::vector<uint8_t> best;
+  anchored = false;
+  if (expression.find('|') != std::string::npos) {
+    return best;
+  }
+  std::vector<uint8_t> run;
+  size_t run_start = 0;
+  int depth = 0;
+  auto endRun = [&]() {
+    if (run_start == 0 && !run.empty()) {
+      anchored = true;
+      best = run;
+    } else if (!anchored && run.size() > best.size()) {
+      best = run;
+    }
+    run.clear();
+  };
+  for (size_t i = 0; i < expression.size(); i++) {
+    char c = expression[i];
+    if (c == '\\' && i + 1 < expression.size() &&
+        !std::isalnum(static_cast<unsigned char>(expression[i + 1]))) {
+      if (depth == 0) {
+        if (run.empty()) {
+          run_start = i;
+        }
+        run.push_back(static_cast<uint8_t>(expression[i + 1]));
+      }
+      i++;
+    } else if (c == '[') {
+      endRun();
+      // A ']' first in the class is a member, not its end.
+      size_t close = expression.find(']', i + 2);
+      i = close == std::string::npos ? expression.size() : close;
+    } else if (c == '\\') {
+      endRun();
+      // \d, \b, \xHH, \uHHHH, \cX: skip the whole escape.
+      char kind = i + 1 < expression.size() ? expression[i + 1] : '\0';
+      i += kind == 'x' ? 3 : kind == 'u' ? 5 : kind == 'c' ? 2 : 1;
+    } else if (c == '?' || c == '*' || c == '{') {
+      if (!run.empty()) {
+        run.pop_back();
+      }
+      endRun();
+      if (c == '{') {
+        size_t close = expression.find('}', i);
+        i = close == std::string::npos ? expression.size() : close;
+      }
+    } else if (std::strchr("^$.+()", c) != nullptr) {
+      endRun();
+      depth += c == '(' ? 1 : c == ')' ? -1 : 0;
+    } else if (depth == 0) {
+      if (run.empty()) {
+        run_start = i;
+      }
+      run.push_back(static_cast<uint8_t>(c));
+    }
+  }
+  endRun();
+  return best;
+}
+
+const uint8_t *lineEnd(const uint8_t *p, const uint8_t *end) {
+  end = std::min(end, p + MAX_REGEX_SPAN);
+  const void *newline = std::memchr(p, '\n', end - p);
+  return newline != nullptr ? static_cast<const uint8_t *>(newline) : end;
+}
+
+} // namespace
+
+ScanLevel bestScanLevel() { return best_level; }
+
+ScanLevel scanLevel() { return active_level; }
+
+bool setScanLevel(ScanLevel level) {
+  if (!supports(level)) {
+    return false;
+  }
+  active_level = level;
+  active_find = functionFor(level);
+  return true;
+}
+
+const char *scanLevelName(ScanLevel level) {
+  switch (level) {
+  case ScanLevel::SCALAR:
+    return "scalar";
+  case ScanLevel::SSE2:
+    return "sse2";
+  case ScanLevel::AVX2:
+    return "avx2";
+  }
+  return "?";
+}
+
+bool Searcher::compileLiteral(std::vector<uint8_t> needle,
+                              std::string &error) {
+  if (needle.empty()) {
+    error = "empty pattern";
+    return false;
+  }
+  is_regex_ = false;
+  anchored_ = true;
+  literal_ = std::move(needle);
+  return true;
+}
+
+bool Searcher::compileRegex(const std::string &expression,
+                            std::string &error) {
+  try {
+    regex_.assign(expression, std::regex::ECMAScript | std::regex::optimize);
+  } catch (const std::regex_error &e) {
+    error = e.what();
+    return false;
+  }
+  is_regex_ = true;
+  literal_ = requiredLiteral(expression, anchored_);
+  return true;
+}
+
+size_t Searcher::overlap() const {
+  return is_regex_ ? MAX_REGEX_SPAN : literal_.size() - 1;
+}
+
+size_t Searcher::scan(const uint8_t *data, size_t size, size_t limit,
+                      const Sink &sink) const {
+  limit = std::min(limit, size);
+  if (!is_regex_) {
+    return scanLiteral(data, size, limit, sink);
+  }
+  if (literal_.empty()) {
+    return scanLines(data, size, limit, sink);
+  }
+  return anchored_ ? scanPrefixed(data, size, limit, sink)
+                   : scanFiltered(data, size, limit, sink);
+}
+
+size_t Searcher::scanLiteral(const uint8_t *data, size_t size, size_t limit,
+                             const Sink &sink) const {
+  size_t length = literal_.size();
+  if (size < length) {
+    return 0;
+  }
+  size_t gap = length - 1;
+  const uint8_t *needle = literal_.data();
+  const uint8_t *p = data;
+  const uint8_t *end = data + std::min(limit, size - gap);
+  size_t found = 0;
+  while ((p = active_find(p, end, needle[0], needle[gap], gap)) < end) {
+    if (length <= 2 || std::memcmp(p + 1, needle + 1, length - 2) == 0) {
+      sink(static_cast<size_t>(p - data), length);
+      found++;
+    }
+    ++p;
+  }
+  return found;
+}
+
+size_t Searcher::scanPrefixed(const uint8_t *data, size_t size,
+                              size_t limit, const Sink &sink) const {
+  size_t length = literal_.size();
+  if (size < length) {
+    return 0;
+  }
+  size_t gap = length - 1;
+  const uint8_t *needle = literal_.data();
+  const uint8_t *p = data;
+  const uint8_t *end = data + std::min(limit, size - gap);
+  size_t found = 0;
+  while ((p = active_find(p, end, needle[0], needle[gap], gap)) < end) {
+    if (length > 2 && std::memcmp(p + 1, needle + 1, length - 2) != 0) {
+      ++p;
+      continue;
+    }
+    std::cmatch match;
+    auto flags = std::regex_constants::match_continuous;
+    if (p > data) {
+      flags |= std::regex_constants::match_prev_avail;
+    }
+    const char *from = reinterpret_cast<const char *>(p);
+    const char *to = reinterpret_cast<const char *>(lineEnd(p, data + size));
+    if (std::regex_search(from, to, match, regex_, flags) &&
+        match.length(0) > 0) {
+      sink(static_cast<size_t>(p - data),
+           static_cast<size_t>(match.length(0)));
+      found++;
+      p += match.length(0);
+    } else {
+      ++p;
+    }
+  }
+  return found;
+}
+
+// Runs the regex on each line holding the literal.
+size_t Searcher::scanFiltered(const uint8_t *data, size_t size,
+                              size_t limit, const Sink &sink) const {
+  size_t length = literal_.size();
+  if (size < length) {
+    return 0;
+  }
+  size_t gap = length - 1;
+  const uint8_t *needle = literal_.data();
+  const uint8_t *end = data + size;
+  const uint8_t *p = data;
+  // A match starting before limit may hold the literal a span later.
+  const uint8_t *last =
+      data + std::min(size - gap, limit + MAX_REGEX_SPAN);
+  const uint8_t *scanned = data; // lines before this were searched
+  size_t found = 0;
+  while ((p = active_find(p, last, needle[0], needle[gap], gap)) < last) {
+    if (length > 2 && std::memcmp(p + 1, needle + 1, length - 2) != 0) {
+      ++p;
+      continue;
+    }
+    const uint8_t *line = p;
+    const uint8_t *floor =
+        std::max(scanned, p - std::min<size_t>(p - data, MAX_REGEX_SPAN));
+    while (line > floor && line[-1] != '\n') {
+      --line;
+    }
+    if (line >= data + limit) {
+      break;
+    }
+    const uint8_t *stop = lineEnd(line, end);
+    found += scanLine(data, line, stop, limit, sink);
+    scanned = stop < end && *stop == '\n' ? stop + 1 : stop;
+    p = std::max(scanned, p + 1);
+  }
+  return found;
+}
+
+size_t Searcher::scanLines(const uint8_t *data, size_t size, size_t limit,
+                           const Sink &sink) const {
+  const uint8_t *end = data + size;
+  const uint8_t *line = data;
+  size_t found = 0;
+  while (line < data + limit) {
+    const uint8_t *stop = lineEnd(line, end);
+    found += scanLine(data, line, stop, limit, sink);
+    line = stop < end && *stop == '\n' ? stop + 1 : stop;
+  }
+  return found;
+}
+
+// Reports the regex's matches in [line, stop) that start before limit.
+size_t Searcher::scanLine(const uint8_t *data, const uint8_t *line,
+                          const uint8_t *stop, size_t limit,
+                          const Sink &sink) const {
+  const char *from = reinterpret_cast<const char *>(line);
+  const char *to = reinterpret_cast<const char *>(stop);
+  auto flags = std::regex_constants::match_default;
+  if (line > data && line[-1] != '\n') {
+    flags |= std::regex_constants::match_prev_avail;
+  }
+  std::cmatch match;
+  size_t found = 0;
+  while (from < to && std::regex_search(from, to, match, regex_, flags)) {
+    const uint8_t *at = reinterpret_cast<const uint8_t *>(match[0].first);
+    if (at >= data + limit) {
+      break;
+    }
+    if (match.length(0) > 0) {
+      sink(static_cast<size_t>(at - data),
+           static_cast<size_t>(match.length(0)));
+      found++;
+      from = match[0].second;
+    } else {
+      from = match[0].first + 1;
+    }
+    flags |= std::regex_constants::match_prev_avail;
+  }
+  return found;
+}
+
+} // namespace byte_search
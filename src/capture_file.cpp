@@ -0,0 +1,436 @@
+#include "../include/capture_file.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace capture {
+
+namespace {
+
+// How often a partly filled block is written anyway, bounding what a
+// crash can lose.
+const std::chrono::seconds FLUSH_INTERVAL{1};
+
+uint64_t steadyNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+template <typename T> T load(const uint8_t *p) {
+  T value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+} // namespace
+
+const char *directionName(Direction direction) {
+  switch (direction) {
+  case RX:
+    return "rx";
+  case TX:
+    return "tx";
+  case PORT:
+    return "port";
+  }
+  return "?";
+}
+
+bool isCapture(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  char magic[sizeof(FILE_MAGIC)];
+  bool match = ::read(fd, magic, sizeof(magic)) ==
+                   static_cast<ssize_t>(sizeof(magic)) &&
+               std::memcmp(magic, FILE_MAGIC, sizeof(magic)) == 0;
+  ::close(fd);
+  return match;
+}
+
+/** Writer class **/
+Writer::~Writer() {
+  if (fd_ >= 0) {
+    std::string ignored;
+    close(ignored);
+  }
+}
+
+bool Writer::open(const std::string &path, std::string &error) {
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    error = std::strerror(errno);
+    return false;
+  }
+  path_ = path;
+  origin_ns_ = steadyNs();
+
+  FileHeader header;
+  std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+  header.version = VERSION;
+  header.header_size = sizeof(FileHeader);
+  header.wall_start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::system_clock::now()
+                                 .time_since_epoch())
+                             .count();
+  header.reserved = 0;
+  if (!writeAll(reinterpret_cast<const uint8_t *>(&header), sizeof(header),
+                error)) {
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  offset_ = sizeof(header);
+  stats_.written = sizeof(header);
+  (void)::fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, PREALLOCATE);
+
+  for (size_t i = 0; i < SPARE_BLOCKS; i++) {
+    spare_.emplace_back(new uint8_t[BLOCK_SIZE]);
+  }
+  thread_ = std::thread(&Writer::writerLoop, this);
+  return true;
+}
+
+void Writer::copyIn(const void *data, size_t length) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  offset_ += length;
+  while (length > 0) {
+    if (!current_) {
+      if (spare_.empty()) {
+        current_.reset(new uint8_t[BLOCK_SIZE]); // the disk is behind
+      } else {
+        current_ = std::move(spare_.back());
+        spare_.pop_back();
+      }
+    }
+    size_t n = std::min(length, BLOCK_SIZE - fill_);
+    std::memcpy(current_.get() + fill_, bytes, n);
+    fill_ += n;
+    bytes += n;
+    length -= n;
+    if (fill_ == BLOCK_SIZE) {
+      queue_.push_back(Filled{std::move(current_), fill_});
+      fill_ = 0;
+      stats_.queued_blocks = queue_.size();
+      stats_.peak_queued_blocks =
+          std::max(stats_.peak_queued_blocks, queue_.size());
+      cv_.notify_one();
+    }
+  }
+}
+
+void Writer::append(const std::string &port, Direction direction,
+                    const uint8_t *data, size_t length, uint64_t time_ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stopping_) {
+    return;
+  }
+  uint64_t time = time_ns > origin_ns_ ? time_ns - origin_ns_ : 0;
+  time = std::max(time, last_ns_);
+  last_ns_ = time;
+
+  auto record = [&](uint16_t id, Direction kind, const void *payload,
+                    uint32_t size) {
+    if (index_.empty() || offset_ - last_indexed_ >= INDEX_SPACING) {
+      index_.push_back(IndexEntry{time, offset_});
+      last_indexed_ = offset_;
+    }
+    RecordHeader header{time, id, kind, RECORD_SYNC, size};
+    copyIn(&header, sizeof(header));
+    copyIn(payload, size);
+    static const uint8_t zeros[8] = {};
+    copyIn(zeros, paddedLength(size) - size);
+  };
+
+  auto found = port_ids_.find(port);
+  if (found == port_ids_.end()) {
+    if (port_names_.size() > UINT16_MAX) {
+      return;
+    }
+    uint16_t id = static_cast<uint16_t>(port_names_.size());
+    found = port_ids_.emplace(port, id).first;
+    port_names_.push_back(port);
+    stats_.ports = port_names_.size();
+    record(id, PORT, port.data(), static_cast<uint32_t>(port.size()));
+  }
+  record(found->second, direction, data, static_cast<uint32_t>(length));
+  stats_.records++;
+  stats_.bytes += length;
+}
+
+void Writer::writerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    bool ready = cv_.wait_for(lock, FLUSH_INTERVAL, [this] {
+      return stopping_ || !queue_.empty();
+    });
+    // Quiet for a while, or closing: the partial block goes out too.
+    if ((!ready || stopping_) && queue_.empty() && fill_ > 0) {
+      queue_.push_back(Filled{std::move(current_), fill_});
+      fill_ = 0;
+    }
+
+    while (!queue_.empty()) {
+      Filled filled = std::move(queue_.front());
+      queue_.pop_front();
+      stats_.queued_blocks = queue_.size();
+      bool failed = !stats_.error.empty();
+      lock.unlock();
+      std::string error;
+      // After a write error the rest is discarded, not piled up in memory.
+      bool ok = !failed && writeAll(filled.block.get(), filled.size, error);
+      lock.lock();
+      if (ok) {
+        stats_.written += filled.size;
+      } else if (stats_.error.empty()) {
+        stats_.error = error;
+      }
+      if (spare_.size() < SPARE_BLOCKS) {
+        spare_.push_back(std::move(filled.block));
+      }
+    }
+    if (stopping_ && fill_ == 0) {
+      return;
+    }
+  }
+}
+
+bool Writer::writeAll(const uint8_t *data, size_t size, std::string &error) {
+  // Keep the file reserved well ahead of the data so it stays in few
+  // extents; KEEP_SIZE leaves no zeros to skip if we never get to close().
+  off_t position = ::lseek(fd_, 0, SEEK_CUR);
+  if (position >= 0 && static_cast<uint64_t>(position) % PREALLOCATE +
+                               size >= PREALLOCATE) {
+    off_t next = (position / PREALLOCATE + 1) * PREALLOCATE;
+    // Not every file system can; that only costs some fragmentation.
+    (void)::fallocate(fd_, FALLOC_FL_KEEP_SIZE, next, PREALLOCATE);
+  }
+  while (size > 0) {
+    ssize_t n = ::write(fd_, data, size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      error = n < 0 ? std::strerror(errno) : "short write";
+      return false;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool Writer::close(std::string &error) {
+  if (fd_ < 0) {
+    return true;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+
+  // Trailer: index, names, footer.
+  std::vector<uint8_t> trailer;
+  auto put = [&trailer](const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    trailer.insert(trailer.end(), bytes, bytes + size);
+  };
+  Footer footer;
+  footer.index_offset = offset_;
+  footer.index_entries = index_.size();
+  put(index_.data(), index_.size() * sizeof(IndexEntry));
+  footer.names_offset = offset_ + trailer.size();
+  footer.names_count = port_names_.size();
+  for (const std::string &name : port_names_) {
+    uint16_t length = static_cast<uint16_t>(
+        std::min<size_t>(name.size(), UINT16_MAX));
+    put(&length, sizeof(length));
+    put(name.data(), length);
+  }
+  trailer.resize(paddedLength(static_cast<uint32_t>(trailer.size())));
+  footer.records = stats_.records;
+  footer.end_ns = last_ns_;
+  std::memcpy(footer.magic, FOOTER_MAGIC, sizeof(footer.magic));
+  put(&footer, sizeof(footer));
+
+  bool ok = stats_.error.empty();
+  if (ok && !writeAll(trailer.data(), trailer.size(), error)) {
+    ok = false;
+  } else if (!ok) {
+    error = stats_.error;
+  }
+  if (ok) {
+    stats_.written += trailer.size();
+    // Give back the space reserved past the end.
+    if (::ftruncate(fd_, static_cast<off_t>(stats_.written)) != 0) {
+      error = std::strerror(errno);
+      ok = false;
+    }
+  }
+  ::close(fd_);
+  fd_ = -1;
+  return ok;
+}
+
+Writer::Stats Writer::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+/** Reader class **/
+bool Reader::open(const std::string &path, std::string &error) {
+  if (!file_.open(path, error)) {
+    return false;
+  }
+  const uint8_t *data = file_.data();
+  if (file_.size() < sizeof(FileHeader) ||
+      std::memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+    error = "not a capture file";
+    return false;
+  }
+  FileHeader header = load<FileHeader>(data);
+  if (header.version != VERSION || header.header_size != sizeof(header)) {
+    error = "unsupported capture version " + std::to_string(header.version);
+    return false;
+  }
+  wall_start_ns_ = header.wall_start_ns;
+  if (!readTrailer()) {
+    rebuild();
+  }
+  return true;
+}
+
+bool Reader::readTrailer() {
+  const uint8_t *data = file_.data();
+  size_t size = file_.size();
+  if (size < sizeof(FileHeader) + sizeof(Footer)) {
+    return false;
+  }
+  Footer footer = load<Footer>(data + size - sizeof(Footer));
+  uint64_t footer_at = size - sizeof(Footer);
+  if (std::memcmp(footer.magic, FOOTER_MAGIC, sizeof(FOOTER_MAGIC)) != 0 ||
+      footer.index_offset < sizeof(FileHeader) ||
+      footer.index_offset > footer.names_offset ||
+      footer.index_entries >
+          (footer.names_offset - footer.index_offset) / sizeof(IndexEntry) ||
+      footer.names_offset > footer_at) {
+    return false;
+  }
+
+  index_.resize(footer.index_entries);
+  if (!index_.empty()) {
+    std::memcpy(index_.data(), data + footer.index_offset,
+                index_.size() * sizeof(IndexEntry));
+  }
+  names_.clear();
+  uint64_t at = footer.names_offset;
+  for (uint64_t i = 0; i < footer.names_count; i++) {
+    if (at + sizeof(uint16_t) > footer_at) {
+      return false;
+    }
+    uint16_t length = load<uint16_t>(data + at);
+    at += sizeof(length);
+    if (at + length > footer_at) {
+      return false;
+    }
+    names_.emplace_back(reinterpret_cast<const char *>(data + at), length);
+    at += length;
+  }
+  complete_ = true;
+  records_ = footer.records;
+  end_ns_ = footer.end_ns;
+  records_end_ = footer.index_offset;
+  return true;
+}
+
+void Reader::rebuild() {
+  complete_ = false;
+  index_.clear();
+  names_.clear();
+  records_ = 0;
+  end_ns_ = 0;
+  records_end_ = file_.size();
+
+  size_t offset = begin();
+  size_t last_indexed = 0;
+  Record record;
+  while (true) {
+    size_t at = offset;
+    if (!next(offset, record) || record.time_ns < end_ns_) {
+      offset = at; // stop before anything damaged
+      break;
+    }
+    if (index_.empty() || at - last_indexed >= INDEX_SPACING) {
+      index_.push_back(IndexEntry{record.time_ns, at});
+      last_indexed = at;
+    }
+    end_ns_ = record.time_ns;
+    if (record.direction == PORT) {
+      if (record.port >= names_.size()) {
+        names_.resize(record.port + 1u, "?");
+      }
+      names_[record.port].assign(reinterpret_cast<const char *>(record.data),
+                                 record.length);
+    } else {
+      records_++;
+    }
+  }
+  records_end_ = offset;
+}
+
+const std::string &Reader::portName(uint16_t port) const {
+  static const std::string unknown = "?";
+  return port < names_.size() ? names_[port] : unknown;
+}
+
+size_t Reader::seek(uint64_t time_ns) const {
+  // Start from the last indexed record before time_ns; everything ahead
+  // of it is no later than it.
+  auto after = std::lower_bound(
+      index_.begin(), index_.end(), time_ns,
+      [](const IndexEntry &entry, uint64_t t) { return entry.time_ns < t; });
+  size_t offset = after == index_.begin() ? begin() : (after - 1)->offset;
+  Record record;
+  size_t at = offset;
+  while (next(offset, record)) {
+    if (record.time_ns >= time_ns) {
+      return at;
+    }
+    at = offset;
+  }
+  return end();
+}
+
+bool Reader::next(size_t &offset, Record &record) const {
+  if (offset >= records_end_ ||
+      records_end_ - offset < sizeof(RecordHeader)) {
+    return false;
+  }
+  RecordHeader header = load<RecordHeader>(file_.data() + offset);
+  if (header.sync != RECORD_SYNC || header.direction > PORT) {
+    return false;
+  }
+  size_t total = sizeof(RecordHeader) + paddedLength(header.length);
+  if (total > records_end_ - offset) {
+    return false;
+  }
+  record.time_ns = header.time_ns;
+  record.port = header.port;
+  record.direction = static_cast<Direction>(header.direction);
+  record.data = file_.data() + offset + sizeof(RecordHeader);
+  record.length = header.length;
+  offset += total;
+  return true;
+}
+
+} // namespace capture
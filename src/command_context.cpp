@@ -0,0 +1,28 @@
+#include "../include/command_context.hpp"
+
+#include <algorithm>
+
+constexpr std::chrono::milliseconds CancellationToken::POLL;
+
+void CancellationToken::cancel() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_.store(true, std::memory_order_relaxed);
+  }
+  cv_.notify_all();
+}
+
+bool CancellationToken::waitFor(std::chrono::milliseconds duration) const {
+  auto deadline = std::chrono::steady_clock::now() + duration;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!cancelled()) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return true;
+    }
+    // Bounded so a cancelFromSignal(), which cannot notify, is noticed.
+    cv_.wait_for(lock, std::min<std::chrono::steady_clock::duration>(
+                           deadline - now, POLL));
+  }
+  return false;
+}
@@ -1,6 +1,11 @@
 #include "../include/command_registry.hpp"
+#include "../include/args_parser.hpp"
+#include "../include/args_opt.hpp"
+#include "../include/trace.hpp"
 #include "../include/logger.hpp" // Include logger definitions (needed for extern declaration and usage)
 
+#include <algorithm>
+#include <functional>
 #include <vector>
 #include <string>
 
@@ -22,27 +27,123 @@ CommandRegistry::CommandRegistry() = default;
 CommandRegistry::~CommandRegistry() = default;
 
 
-ICommand* CommandRegistry::findCommand(const std::string& name) const {
-    auto it = command_map.find(name);
-    if (it != command_map.end()) {
-        return it->second; // Return the non-owning pointer
+namespace {
+
+CompletionTrie optionNamesOf(const ICommand& command) {
+    CompletionTrie names;
+    const opt_parser::OptionTable* options = command.getOptions();
+    if (options != nullptr) {
+        for (const opt_parser::OptionSpec& spec : *options) {
+            names.insert(std::string{'-', spec.letter});
+            if (spec.name != nullptr) {
+                names.insert(std::string("--") + spec.name);
+            }
+        }
+    }
+    return names;
+}
+
+} // end anonymous namespace
+
+size_t CommandRegistry::hashName(std::string_view name) {
+    return std::hash<std::string_view>()(name);
+}
+
+size_t CommandRegistry::findSlot(std::string_view name, size_t hash) const {
+    if (slots.empty()) {
+        return NO_SLOT;
+    }
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot& slot = slots[i];
+        if (slot.command == nullptr) {
+            return NO_SLOT; // Reached a gap: not registered
+        }
+        if (slot.hash == hash && slot.name == name) {
+            return i;
+        }
+    }
+}
+
+void CommandRegistry::insertSlot(Slot slot) {
+    size_t mask = slots.size() - 1;
+    size_t i = slot.hash & mask;
+    while (slots[i].command != nullptr) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = std::move(slot);
+}
+
+void CommandRegistry::addCommand(std::string name, ICommand* command) {
+    size_t hash = hashName(name);
+
+    auto sorted_it = std::lower_bound(
+        sorted_commands.begin(), sorted_commands.end(), name,
+        [](const CommandList::value_type& entry, const std::string& key) {
+            return entry.first < key;
+        });
+
+    size_t existing = findSlot(name, hash);
+    if (existing != NO_SLOT) {
+        logger.warn("Command '", name, "' is already registered. Overwriting previous entry.");
+        // The old object stays owned by command_objects; only lookups move over.
+        slots[existing].command = command;
+        slots[existing].option_names = optionNamesOf(*command);
+        sorted_it->second = command;
+        return;
+    }
+
+    sorted_commands.insert(sorted_it, CommandList::value_type(name, command));
+    command_names.insert(name);
+
+    // Grow to keep the table at most half full, so probe runs stay short.
+    if ((slot_count + 1) * 2 > slots.size()) {
+        std::vector<Slot> old_slots(std::max<size_t>(16, slots.size() * 2));
+        old_slots.swap(slots);
+        for (Slot& slot : old_slots) {
+            if (slot.command != nullptr) {
+                insertSlot(std::move(slot));
+            }
+        }
+    }
+
+    Slot slot;
+    slot.name = std::move(name);
+    slot.command = command;
+    slot.hash = hash;
+    slot.option_names = optionNamesOf(*command);
+    insertSlot(std::move(slot));
+    slot_count++;
+}
+
+ICommand* CommandRegistry::findCommand(std::string_view name) const {
+    size_t slot = findSlot(name, hashName(name));
+    if (slot != NO_SLOT) {
+        return slots[slot].command; // Return the non-owning pointer
     }
     return nullptr; // Command not found
 }
 
 int CommandRegistry::executeCommand(const std::vector<std::string>& arguments) {
+    CommandContext context;
+    return executeCommand(arguments, context);
+}
+
+int CommandRegistry::executeCommand(const std::vector<std::string>& arguments,
+                                    CommandContext& context) {
     if (arguments.empty()) {
         logger.warn("executeCommand called with empty arguments.");
         return COMMAND_SUCCESS; // Or perhaps an error code indicating no command?
     }
 
     const std::string& commandName = arguments[0];
+    trace::Span span("cli", "executeCommand", commandName);
     ICommand* command = findCommand(commandName);
 
     if (command) {
         try {
             // Delegate execution to the found command object
-            return command->execute(arguments);
+            return command->run(arguments, context);
         }
         catch (const std::exception& e) {
              logger.fatal("Exception during execution of '", commandName, "': ", e.what());
@@ -58,6 +159,27 @@ int CommandRegistry::executeCommand(const std::vector<std::string>& arguments) {
     }
 }
 
-const std::map<std::string, ICommand*>& CommandRegistry::getCommands() const {
-    return command_map;
+std::vector<std::string> CommandRegistry::parseLine(const std::string& line) const {
+    trace::Span span("cli", "CommandRegistry::parseLine");
+    thread_local CommandTokens tokens;
+    tokenizeCommandLine(line, tokens);
+    bool expand = true;
+    if (!tokens.empty()) {
+        ICommand* command = findCommand(tokens[0]);
+        expand = command == nullptr || command->expandsWildcards();
+    }
+    return materializeTokens(tokens, expand);
+}
+
+const CommandRegistry::CommandList& CommandRegistry::getCommands() const {
+    return sorted_commands;
+}
+
+const CompletionTrie& CommandRegistry::getCommandNames() const {
+    return command_names;
+}
+
+const CompletionTrie* CommandRegistry::getOptionNames(std::string_view name) const {
+    size_t slot = findSlot(name, hashName(name));
+    return slot != NO_SLOT ? &slots[slot].option_names : nullptr;
 }
@@ -3,38 +3,45 @@
 #include "../../include/icommand.hpp"
 #include "../../include/logger.hpp"
 
-AddCommand::AddCommand() {
-  parser.addOption('a', "add", opt_parser::ArgumentOptions::REQ_ARG);
-}
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'a', "add", ArgumentOptions::REQ_ARG, ValueType::STRING},
+});
+
+} // namespace
+
+AddCommand::AddCommand() {}
 
 std::string AddCommand::getName() const { return "add"; }
 std::string AddCommand::getDescription() const {
   return "Adds a new item to the list.";
 }
 
+const opt_parser::OptionTable *AddCommand::getOptions() const {
+  return &OPTIONS;
+}
+
 int AddCommand::execute(const std::vector<std::string> &arguments) {
   extern Logger logger;
 
-  for (opt_parser::Option &opt :
-       const_cast<std::vector<opt_parser::Option> &>(parser.getOptions())) {
-    opt.set_found(false);
-    opt.set_arg("");
-  }
-
-  int parse_result = parser.parseOptionsString(arguments);
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
 
-  if (parse_result < 0) {
-    logger.fatal("Error parsing arguments for '", getName(), "' command.");
+  if (!options.ok()) {
+    logger.fatal("Error parsing arguments for '", getName(),
+                 "' command: ", options.errorMessage(), ".");
     return COMMAND_ERROR;
   }
 
-  const opt_parser::Option *itemOpt = parser.findOption('a');
-  if (!itemOpt || !itemOpt->get_found() || itemOpt->get_arg().empty()) {
+  std::string_view itemToAdd = options.str('a');
+  if (itemToAdd.empty()) {
     logger.fatal("Error: Missing required argument -a/--add for command '",
                  getName(), "'.");
     return COMMAND_ERROR;
   }
-  std::string itemToAdd = itemOpt->get_arg();
 
 
   logger.success("Item '", itemToAdd, "' added.");
@@ -0,0 +1,175 @@
+#include "../../include/commands/bench.hpp"
+#include "../../include/alloc_counter.hpp"
+#include "../../include/args_opt.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+#include "../../include/table_format.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+using table_fmt::duration;
+using table_fmt::row;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'n', "count", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+    {'w', "warmup", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+});
+
+const int64_t MAX_RUNS = 100000000;
+
+// Quotes an argument so the tokenizer gives it back unchanged.
+std::string quoted(const std::string &argument) {
+  if (!argument.empty() &&
+      argument.find_first_of(" \t\n\v\f\r'\"") == std::string::npos) {
+    return argument;
+  }
+  std::string text = "'";
+  for (char c : argument) {
+    text += c == '\'' ? std::string("'\"'\"'") : std::string(1, c);
+  }
+  return text + "'";
+}
+
+} // namespace
+
+BenchCommand::BenchCommand(CommandRegistry &registry) : registry_(registry) {}
+
+std::string BenchCommand::getName() const { return "bench"; }
+std::string BenchCommand::getDescription() const {
+  return "Times a command line run N times with its output muted: bench "
+         "[-n <runs>] [-w <warmup>] -- <command> [args]";
+}
+
+const opt_parser::OptionTable *BenchCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+ArgumentKind BenchCommand::getArgumentKind() const {
+  return ArgumentKind::COMMAND;
+}
+
+int BenchCommand::run(const std::vector<std::string> &arguments,
+                      CommandContext &context) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  size_t first_arg = options.firstPositional();
+  if (!options.ok() || first_arg == arguments.size()) {
+    if (!options.ok()) {
+      logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    }
+    logger.fatal("Usage: ", getName(),
+                 " [-n <runs>] [-w <warmup>] -- <command> [args]");
+    return COMMAND_ERROR;
+  }
+  int64_t runs = options.integer('n', 1000);
+  int64_t warmup = options.integer('w', std::min<int64_t>(runs / 10, 100));
+  if (runs < 1 || runs > MAX_RUNS || warmup < 0 || warmup > MAX_RUNS) {
+    logger.fatal(getName(), ": runs must be 1..", MAX_RUNS,
+                 " and warmup 0..", MAX_RUNS, ".");
+    return COMMAND_ERROR;
+  }
+
+  ICommand *target = registry_.findCommand(arguments[first_arg]);
+  if (target == nullptr) {
+    logger.fatal("Unknown command: '", arguments[first_arg], "'.");
+    return COMMAND_NOT_FOUND;
+  }
+  if (target == this) {
+    logger.fatal(getName(), ": cannot bench itself.");
+    return COMMAND_ERROR;
+  }
+
+  // Rebuilt as text so every run pays for tokenizing and expansion, as a
+  // typed line does.
+  std::string line;
+  for (size_t i = first_arg; i < arguments.size(); i++) {
+    line += i == first_arg ? "" : " ";
+    line += quoted(arguments[i]);
+  }
+
+  std::vector<uint64_t> samples;
+  samples.reserve(static_cast<size_t>(runs));
+  alloc_counter::Counts allocs;
+  int failure = 0;
+  int64_t failed_at = 0;
+  auto started = std::chrono::steady_clock::now();
+  {
+    // Output of the runs is dropped; the runs' own threads are not muted.
+    Logger::ThreadMute mute;
+    for (int64_t i = 0; i < warmup + runs && !context.cancelled(); i++) {
+      alloc_counter::Counts before = alloc_counter::thisThread();
+      auto began = std::chrono::steady_clock::now();
+      CommandContext run_context(context.token());
+      int result =
+          registry_.executeCommand(registry_.parseLine(line), run_context);
+      auto ended = std::chrono::steady_clock::now();
+      if (result != 0) {
+        failure = result;
+        failed_at = i + 1;
+        break;
+      }
+      if (i < warmup) {
+        continue;
+      }
+      alloc_counter::Counts used = alloc_counter::thisThread().since(before);
+      allocs.allocations += used.allocations;
+      allocs.frees += used.frees;
+      allocs.bytes += used.bytes;
+      samples.push_back(static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(ended - began)
+              .count()));
+      context.progress(samples.size(), static_cast<size_t>(runs));
+    }
+  }
+  uint64_t wall_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - started)
+          .count());
+
+  if (failure != COMMAND_SUCCESS && failure != COMMAND_CANCELLED) {
+    logger.fatal(getName(), ": run ", failed_at, " of '", line,
+                 "' failed with ", failure, "; run it alone to see why.");
+    return COMMAND_ERROR;
+  }
+  if (samples.empty()) {
+    logger.warn(getName(), " cancelled before the first timed run.");
+    return COMMAND_CANCELLED;
+  }
+
+  uint64_t total = 0;
+  for (uint64_t sample : samples) {
+    total += sample;
+  }
+  std::sort(samples.begin(), samples.end());
+  size_t n = samples.size();
+  auto at = [&](double q) {
+    return samples[std::min(n - 1, static_cast<size_t>(q * n))];
+  };
+  double mean = static_cast<double>(total) / n;
+
+  std::vector<size_t> widths = {9, 10, 10, 10, 10, 10};
+  logger.info(row({"RUNS", "MIN", "MEAN", "P50", "P99", "MAX"}, widths));
+  logger.info(row({std::to_string(n), duration(samples.front()),
+                   duration(static_cast<uint64_t>(mean)), duration(at(0.5)),
+                   duration(at(0.99)), duration(samples.back())},
+                  widths));
+  logger.info("  ", static_cast<uint64_t>(1e9 / mean), " ops/s; ",
+              static_cast<double>(allocs.allocations) / n, " allocation(s), ",
+              static_cast<double>(allocs.frees) / n, " free(s) and ",
+              allocs.bytes / n, " bytes per run (this thread, ",
+              duration(wall_ns), " in all).");
+
+  if (context.cancelled()) {
+    logger.warn(getName(), " cancelled after ", n, " of ", runs, " run(s).");
+    return COMMAND_CANCELLED;
+  }
+  return COMMAND_SUCCESS;
+}
@@ -0,0 +1,205 @@
+#include "../../include/commands/broadcast.hpp"
+#include "../../include/args_opt.hpp"
+#include "../../include/args_parser.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+#include "../../include/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'j', "jobs", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+});
+
+const int64_t MAX_JOBS = 64;
+const char *const PLACEHOLDER = "{}";
+
+struct Outcome {
+  std::string port;
+  int result = 0;
+  double ms = 0;
+};
+
+// The command line for one port: every "{}" becomes the port name.
+// Without one, the port becomes the first positional argument, after the
+// command's options.
+std::vector<std::string> commandFor(const ICommand &target,
+                                    const std::vector<std::string> &command,
+                                    const std::string &port) {
+  std::vector<std::string> line = command;
+  bool substituted = false;
+  for (std::string &argument : line) {
+    if (argument == PLACEHOLDER) {
+      argument = port;
+      substituted = true;
+    }
+  }
+  if (!substituted) {
+    size_t at = 1;
+    if (target.getOptions() != nullptr) {
+      opt_parser::ParsedOptions options = target.getOptions()->parse(line);
+      at = options.ok() ? options.firstPositional() : 1;
+    }
+    line.insert(line.begin() + at, port);
+  }
+  return line;
+}
+
+} // namespace
+
+BroadcastCommand::BroadcastCommand(CommandRegistry &registry,
+                                   const PortManager &ports)
+    : registry_(registry), ports_(ports) {}
+
+std::string BroadcastCommand::getName() const { return "broadcast"; }
+std::string BroadcastCommand::getDescription() const {
+  return "Runs a command on every matching port in parallel: broadcast "
+         "[-j <jobs>] <port-glob>... -- <command> [args, {} = port]";
+}
+
+const opt_parser::OptionTable *BroadcastCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+ArgumentKind BroadcastCommand::getArgumentKind() const {
+  return ArgumentKind::PORT;
+}
+
+int BroadcastCommand::run(const std::vector<std::string> &arguments,
+                          CommandContext &context) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  size_t first_arg = options.firstPositional();
+  auto separator =
+      std::find(arguments.begin() + first_arg, arguments.end(), "--");
+  if (!options.ok() || separator == arguments.begin() + first_arg ||
+      separator == arguments.end() || separator + 1 == arguments.end()) {
+    if (!options.ok()) {
+      logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    }
+    logger.fatal("Usage: ", getName(),
+                 " [-j <jobs>] <port-glob>... -- <command> [args]");
+    return COMMAND_ERROR;
+  }
+  std::vector<std::string> patterns(arguments.begin() + first_arg, separator);
+  std::vector<std::string> command(separator + 1, arguments.end());
+
+  ICommand *target = registry_.findCommand(command[0]);
+  if (target == nullptr) {
+    logger.fatal("Unknown command: '", command[0], "'.");
+    return COMMAND_NOT_FOUND;
+  }
+  if (target == this) {
+    logger.fatal(getName(), ": cannot broadcast itself.");
+    return COMMAND_ERROR;
+  }
+  // The rest of the line was not expanded on the way in.
+  if (target->expandsWildcards()) {
+    command = expandWildcards(command);
+  }
+
+  // Same pattern rules as file wildcards, matched against port names or
+  // device paths.
+  std::vector<std::string> targets;
+  for (const PortInfo &info : ports_.list()) {
+    for (const std::string &pattern : patterns) {
+      if (matchWildcard(pattern, info.name) ||
+          matchWildcard(pattern, info.path)) {
+        targets.push_back(info.name);
+        break;
+      }
+    }
+  }
+  if (targets.empty()) {
+    logger.fatal(getName(), ": no open port matches.");
+    return COMMAND_ERROR;
+  }
+  std::sort(targets.begin(), targets.end());
+
+  int64_t jobs =
+      options.integer('j', std::min<int64_t>(targets.size(), MAX_JOBS));
+  if (jobs < 1 || jobs > MAX_JOBS) {
+    logger.fatal(getName(), ": jobs must be 1..", MAX_JOBS, ".");
+    return COMMAND_ERROR;
+  }
+
+  // Every port shares the broadcast's token; ports not started yet when
+  // it fires are skipped.
+  std::vector<Outcome> outcomes(targets.size());
+  std::atomic<uint64_t> finished{0};
+  auto start = std::chrono::steady_clock::now();
+  {
+    ThreadPool pool(std::min<size_t>(static_cast<size_t>(jobs),
+                                     targets.size()));
+    for (size_t i = 0; i < targets.size(); i++) {
+      pool.submit([&, i] {
+        Outcome &outcome = outcomes[i];
+        outcome.port = targets[i];
+        if (context.cancelled()) {
+          outcome.result = COMMAND_CANCELLED;
+          context.progress(++finished, targets.size());
+          return;
+        }
+        auto began = std::chrono::steady_clock::now();
+        CommandContext port_context(context.token());
+        outcome.result = registry_.executeCommand(
+            commandFor(*target, command, targets[i]), port_context);
+        context.progress(++finished, targets.size());
+        outcome.ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - began)
+                         .count();
+      });
+    }
+    pool.wait();
+  }
+  double wall_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  size_t name_len = 4;
+  for (const Outcome &outcome : outcomes) {
+    name_len = std::max(name_len, outcome.port.length());
+  }
+  logger.info("  PORT", std::string(name_len - 2, ' '), "RESULT      TIME");
+  size_t failed = 0;
+  double total_ms = 0;
+  for (const Outcome &outcome : outcomes) {
+    std::string result =
+        outcome.result == COMMAND_SUCCESS ? "ok"
+        : outcome.result == COMMAND_CANCELLED
+            ? "cancelled"
+            : "failed (" + std::to_string(outcome.result) + ")";
+    if (outcome.result != COMMAND_SUCCESS) {
+      failed++;
+    }
+    total_ms += outcome.ms;
+    logger.info("  ", outcome.port,
+                std::string(name_len - outcome.port.length() + 2, ' '), result,
+                std::string(12 - std::min<size_t>(result.length(), 11), ' '),
+                outcome.ms, " ms");
+  }
+
+  if (context.cancelled()) {
+    logger.warn(getName(), " cancelled after ", wall_ms, " ms.");
+    return COMMAND_CANCELLED;
+  }
+  if (failed > 0) {
+    logger.fatal(command[0], " failed on ", failed, " of ", outcomes.size(),
+                 " port(s) (", wall_ms, " ms).");
+    return COMMAND_ERROR;
+  }
+  logger.success(command[0], " succeeded on ", outcomes.size(),
+                 " port(s) in ", wall_ms, " ms (", total_ms,
+                 " ms one after another).");
+  return COMMAND_SUCCESS;
+}
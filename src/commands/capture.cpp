@@ -0,0 +1,93 @@
+#include "../../include/commands/capture.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+
+#include <string>
+
+CaptureCommand::CaptureCommand(PortManager &ports) : ports_(ports) {}
+
+std::string CaptureCommand::getName() const { return "capture"; }
+std::string CaptureCommand::getDescription() const {
+  return "Records all port traffic, timestamped, into a binary capture "
+         "file: capture start <file> | capture stop";
+}
+
+ArgumentKind CaptureCommand::getArgumentKind() const {
+  return ArgumentKind::FILE;
+}
+
+int CaptureCommand::execute(const std::vector<std::string> &arguments) {
+  extern Logger logger;
+
+  bool start = arguments.size() == 3 && arguments[1] == "start";
+  bool stop = arguments.size() == 2 && arguments[1] == "stop";
+  if (!start && !stop && arguments.size() != 1) {
+    logger.fatal("Usage: ", getName(), " start <file> | ", getName(),
+                 " stop");
+    return COMMAND_ERROR;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - started_)
+                       .count();
+  if (arguments.size() == 1) {
+    if (!writer_) {
+      logger.info("Not capturing.");
+      return COMMAND_SUCCESS;
+    }
+    capture::Writer::Stats stats = writer_->stats();
+    logger.info("Capturing into ", writer_->path(), " for ", seconds,
+                " s: ", stats.records, " chunk(s), ", stats.bytes,
+                " bytes from ", stats.ports, " port(s); ", stats.written,
+                " bytes on disk, ", stats.queued_blocks, " block(s) queued.");
+    if (!stats.error.empty()) {
+      logger.warn("Writing ", writer_->path(), " failed: ", stats.error);
+    }
+    return COMMAND_SUCCESS;
+  }
+
+  if (start) {
+    if (writer_) {
+      logger.fatal("Already capturing into ", writer_->path(), ".");
+      return COMMAND_ERROR;
+    }
+    std::shared_ptr<capture::Writer> writer =
+        std::make_shared<capture::Writer>();
+    std::string error;
+    if (!writer->open(arguments[2], error)) {
+      logger.fatal("Cannot create ", arguments[2], ": ", error);
+      return COMMAND_ERROR;
+    }
+    ports_.setCapture(writer);
+    writer_ = std::move(writer);
+    started_ = std::chrono::steady_clock::now();
+    logger.success("Capturing all port traffic into ", arguments[2], ".");
+    return COMMAND_SUCCESS;
+  }
+
+  if (!writer_) {
+    logger.fatal("Not capturing.");
+    return COMMAND_ERROR;
+  }
+  ports_.setCapture(nullptr);
+  std::shared_ptr<capture::Writer> writer = std::move(writer_);
+  writer_.reset();
+  std::string error;
+  bool closed = writer->close(error);
+  capture::Writer::Stats stats = writer->stats();
+  if (!closed) {
+    logger.fatal("Capture into ", writer->path(), " failed: ", error);
+    return COMMAND_ERROR;
+  }
+  if (stats.peak_queued_blocks > capture::Writer::SPARE_BLOCKS) {
+    logger.warn("The disk fell behind: up to ", stats.peak_queued_blocks,
+                " blocks of ", capture::Writer::BLOCK_SIZE >> 20,
+                " MiB were buffered.");
+  }
+  logger.success("Captured ", stats.records, " chunk(s), ", stats.bytes,
+                 " bytes from ", stats.ports, " port(s) in ", seconds,
+                 " s into ", writer->path(), " (", stats.written,
+                 " bytes).");
+  return COMMAND_SUCCESS;
+}
@@ -0,0 +1,502 @@
+#include "../../include/commands/cgrep.hpp"
+#include "../../include/byte_search.hpp"
+#include "../../include/capture_file.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+#include "../../include/mapped_file.hpp"
+#include "../../include/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'x', "hex", ArgumentOptions::REQ_ARG, ValueType::HEX_BYTES},
+    {'e', "regex", ArgumentOptions::NO_ARG, ValueType::STRING},
+    {'p', "port", ArgumentOptions::REQ_ARG, ValueType::STRING},
+    {'m', "max", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+    {'j', "jobs", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+});
+
+const int64_t DEFAULT_SHOWN = 20;
+const int64_t MAX_JOBS = 256;
+// Work is handed out in pieces of about this much file, so cores that
+// finish early take more and Ctrl+C is noticed within a piece.
+const uint64_t PIECE_SIZE = 16 << 20;
+const size_t SHOWN_BYTES = 32;
+
+struct Match {
+  uint64_t offset; // of the first matching byte in the file
+  uint64_t time_ns;
+  uint16_t port;
+  capture::Direction direction;
+  std::string shown;
+};
+
+// The first or last few payload bytes of one capture stream (a port and
+// direction), with where they came from. A literal can straddle records,
+// so their edges are searched together.
+struct Edge {
+  // bytes from start on were read from offset in the file at time_ns.
+  struct Segment {
+    size_t start;
+    uint64_t offset;
+    uint64_t time_ns;
+  };
+  std::vector<uint8_t> bytes;
+  std::vector<Segment> segments;
+
+  void append(const uint8_t *data, size_t length, uint64_t offset,
+              uint64_t time_ns) {
+    if (length > 0) {
+      segments.push_back(Segment{bytes.size(), offset, time_ns});
+      bytes.insert(bytes.end(), data, data + length);
+    }
+  }
+  void append(const Edge &other) {
+    for (const Segment &segment : other.segments) {
+      segments.push_back(Segment{bytes.size() + segment.start,
+                                 segment.offset, segment.time_ns});
+    }
+    bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end());
+  }
+  void keepLast(size_t keep) {
+    if (bytes.size() <= keep) {
+      return;
+    }
+    size_t drop = bytes.size() - keep;
+    bytes.erase(bytes.begin(), bytes.begin() + drop);
+    size_t first = 0;
+    while (first + 1 < segments.size() && segments[first + 1].start <= drop) {
+      first++;
+    }
+    segments.erase(segments.begin(), segments.begin() + first);
+    segments[0].offset += drop - segments[0].start;
+    segments[0].start = drop;
+    for (Segment &segment : segments) {
+      segment.start -= drop;
+    }
+  }
+  const Segment &segmentOf(size_t index) const {
+    size_t i = segments.size() - 1;
+    while (segments[i].start > index) {
+      i--;
+    }
+    return segments[i];
+  }
+};
+
+struct Piece {
+  Piece(uint64_t begin, uint64_t end) : begin(begin), end(end) {}
+
+  uint64_t begin;
+  uint64_t end;
+  uint64_t count = 0;
+  std::vector<Match> matches; // the first few, in file order
+  std::vector<Edge> heads;    // per stream, capture files only
+  std::vector<Edge> tails;
+
+  // A seam match can start before matches already found in records of
+  // other streams, so matches are not always found in file order.
+  bool wants(uint64_t offset, size_t shown) const {
+    return matches.size() < shown ||
+           (shown > 0 && offset < matches.back().offset);
+  }
+  // Adds a match wants() took, keeping the first shown.
+  void keep(Match match, size_t shown) {
+    auto at = std::upper_bound(
+        matches.begin(), matches.end(), match.offset,
+        [](uint64_t offset, const Match &m) { return offset < m.offset; });
+    matches.insert(at, std::move(match));
+    if (matches.size() > shown) {
+      matches.pop_back();
+    }
+  }
+};
+
+// Printable text in quotes, or hex, cut at SHOWN_BYTES.
+std::string show(const uint8_t *data, size_t length) {
+  size_t shown = std::min(length, SHOWN_BYTES);
+  bool text = std::all_of(data, data + shown,
+                          [](uint8_t c) { return c >= 0x20 && c < 0x7f; });
+  std::string out;
+  if (text) {
+    out = "\"" + std::string(reinterpret_cast<const char *>(data), shown) +
+          "\"";
+  } else {
+    char hex[4];
+    for (size_t i = 0; i < shown; i++) {
+      std::snprintf(hex, sizeof(hex), i == 0 ? "%02x" : " %02x", data[i]);
+      out += hex;
+    }
+  }
+  if (shown < length) {
+    out += " ...";
+  }
+  return out;
+}
+
+// Wall clock time of the record, to the microsecond.
+std::string wallTime(int64_t ns) {
+  std::time_t seconds = static_cast<std::time_t>(ns / 1000000000);
+  std::tm local;
+  localtime_r(&seconds, &local);
+  char text[40];
+  size_t n = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+  std::snprintf(text + n, sizeof(text) - n, ".%06lld",
+                static_cast<long long>(ns % 1000000000 / 1000));
+  return text;
+}
+
+std::string hexOffset(uint64_t offset) {
+  char text[24];
+  std::snprintf(text, sizeof(text), "0x%08llx",
+                static_cast<unsigned long long>(offset));
+  return text;
+}
+
+// Reports literal matches that start in before and end in after.
+void searchSeam(const byte_search::Searcher &searcher, const Edge &before,
+                const uint8_t *after, size_t after_length, uint16_t port,
+                capture::Direction direction, size_t shown, Piece &piece,
+                std::vector<uint8_t> &joined) {
+  // Most edges cannot even start the literal.
+  const uint8_t first = searcher.literal()[0];
+  if (std::memchr(before.bytes.data(), first, before.bytes.size()) ==
+      nullptr) {
+    return;
+  }
+  joined.assign(before.bytes.begin(), before.bytes.end());
+  joined.insert(joined.end(), after, after + after_length);
+  size_t split = before.bytes.size();
+  auto found = [&, split](size_t offset, size_t length) {
+    if (offset + length <= split) {
+      return; // found with the record it lies in
+    }
+    piece.count++;
+    const Edge::Segment &segment = before.segmentOf(offset);
+    uint64_t at = segment.offset + (offset - segment.start);
+    if (piece.wants(at, shown)) {
+      piece.keep(Match{at, segment.time_ns, port, direction,
+                       show(joined.data() + offset, length)},
+                 shown);
+    }
+  };
+  searcher.scan(joined.data(), joined.size(), split, found);
+}
+
+void searchRaw(const byte_search::Searcher &searcher, const MappedFile &file,
+               size_t shown, Piece &piece) {
+  size_t reach = std::min<uint64_t>(file.size(),
+                                    piece.end + searcher.overlap());
+  const uint8_t *base = file.data() + piece.begin;
+  piece.count = searcher.scan(
+      base, reach - piece.begin, piece.end - piece.begin,
+      [&](size_t offset, size_t length) {
+        if (piece.matches.size() < shown) {
+          piece.matches.push_back(Match{piece.begin + offset, 0, 0,
+                                        capture::RX,
+                                        show(base + offset, length)});
+        }
+      });
+}
+
+// stream_ok[port] says whether the port was asked for.
+void searchCapture(const byte_search::Searcher &searcher,
+                   const capture::Reader &reader,
+                   const std::vector<bool> &stream_ok, size_t shown,
+                   Piece &piece) {
+  size_t keep = searcher.isRegex() ? 0 : searcher.overlap();
+  if (keep > 0) {
+    piece.heads.resize(stream_ok.size() * 2);
+    piece.tails.resize(stream_ok.size() * 2);
+  }
+  std::vector<uint8_t> joined;
+  size_t offset = piece.begin;
+  capture::Record record;
+  uint64_t payload = 0;
+  // Captures stay small enough for std::function not to allocate.
+  struct {
+    Piece &piece;
+    const capture::Record &record;
+    const uint64_t &payload;
+    size_t shown;
+  } site{piece, record, payload, shown};
+  auto found = [&site](size_t at, size_t length) {
+    if (site.piece.wants(site.payload + at, site.shown)) {
+      const capture::Record &record = site.record;
+      site.piece.keep(Match{site.payload + at, record.time_ns, record.port,
+                            record.direction, show(record.data + at, length)},
+                      site.shown);
+    }
+  };
+  while (offset < piece.end) {
+    size_t at = offset;
+    if (!reader.next(offset, record)) {
+      break;
+    }
+    if (record.direction == capture::PORT || record.port >= stream_ok.size() ||
+        !stream_ok[record.port] || record.length == 0) {
+      continue;
+    }
+    payload = at + sizeof(capture::RecordHeader);
+    if (keep == 0) {
+      piece.count +=
+          searcher.scan(record.data, record.length, record.length, found);
+      continue;
+    }
+    size_t stream = record.port * 2u + record.direction;
+    Edge &head = piece.heads[stream];
+    Edge &tail = piece.tails[stream];
+    // Seam matches start in earlier records, so they go first.
+    if (!tail.bytes.empty()) {
+      searchSeam(searcher, tail, record.data,
+                 std::min<size_t>(keep, record.length), record.port,
+                 record.direction, shown, piece, joined);
+    }
+    piece.count +=
+        searcher.scan(record.data, record.length, record.length, found);
+    if (head.bytes.size() < keep) {
+      head.append(record.data,
+                  std::min<size_t>(keep - head.bytes.size(), record.length),
+                  payload, record.time_ns);
+    }
+    size_t skip = record.length > keep ? record.length - keep : 0;
+    tail.append(record.data + skip, record.length - skip, payload + skip,
+                record.time_ns);
+    tail.keepLast(keep);
+  }
+}
+
+} // namespace
+
+std::string CgrepCommand::getName() const { return "cgrep"; }
+std::string CgrepCommand::getDescription() const {
+  return "Searches a capture or raw file on all cores for text, bytes or a "
+         "regex: cgrep [-e] [-p <port>] [-m <shown>] [-j <jobs>] <file> "
+         "<pattern> | cgrep -x <hex> <file>";
+}
+
+const opt_parser::OptionTable *CgrepCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+ArgumentKind CgrepCommand::getArgumentKind() const {
+  return ArgumentKind::FILE;
+}
+
+int CgrepCommand::run(const std::vector<std::string> &arguments,
+                      CommandContext &context) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  size_t first_arg = options.firstPositional();
+  bool hex = options.has('x');
+  if (!options.ok() ||
+      first_arg + (hex ? 1 : 2) != arguments.size() ||
+      (hex && options.has('e'))) {
+    if (!options.ok()) {
+      logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    }
+    logger.fatal("Usage: ", getName(),
+                 " [-e] [-p <port>] [-m <shown>] [-j <jobs>] <file> "
+                 "<pattern>");
+    logger.fatal("       ", getName(),
+                 " -x <hex bytes> [-p <port>] [-m <shown>] [-j <jobs>] "
+                 "<file>");
+    return COMMAND_ERROR;
+  }
+  const std::string &path = arguments[first_arg];
+
+  byte_search::Searcher searcher;
+  std::string error;
+  bool compiled = false;
+  if (hex) {
+    compiled = searcher.compileLiteral(options.bytes('x'), error);
+  } else if (options.has('e')) {
+    compiled = searcher.compileRegex(arguments[first_arg + 1], error);
+  } else {
+    const std::string &text = arguments[first_arg + 1];
+    compiled = searcher.compileLiteral(
+        std::vector<uint8_t>(text.begin(), text.end()), error);
+  }
+  if (!compiled) {
+    logger.fatal(getName(), ": bad pattern: ", error, ".");
+    return COMMAND_ERROR;
+  }
+  int64_t shown = options.integer('m', DEFAULT_SHOWN);
+  int64_t jobs = options.integer(
+      'j', std::clamp<int64_t>(std::thread::hardware_concurrency(), 1,
+                               MAX_JOBS));
+  if (shown < 0) {
+    logger.fatal(getName(), ": -m must not be negative.");
+    return COMMAND_ERROR;
+  }
+  if (jobs < 1 || jobs > MAX_JOBS) {
+    logger.fatal(getName(), ": jobs must be 1..", MAX_JOBS, ".");
+    return COMMAND_ERROR;
+  }
+
+  bool is_capture = capture::isCapture(path);
+  capture::Reader reader;
+  MappedFile raw;
+  std::vector<bool> stream_ok;
+  std::vector<Piece> pieces;
+  if (is_capture) {
+    if (!reader.open(path, error)) {
+      logger.fatal("Cannot read ", path, ": ", error);
+      return COMMAND_ERROR;
+    }
+    std::string port(options.str('p'));
+    for (size_t id = 0; id < reader.ports(); id++) {
+      stream_ok.push_back(port.empty() ||
+                          reader.portName(static_cast<uint16_t>(id)) == port);
+    }
+    if (!port.empty() &&
+        std::find(stream_ok.begin(), stream_ok.end(), true) ==
+            stream_ok.end()) {
+      logger.fatal(path, " holds no traffic from '", port, "'.");
+      return COMMAND_ERROR;
+    }
+    // Pieces start at indexed records, the only offsets known to be
+    // record boundaries.
+    uint64_t begin = reader.begin();
+    for (const capture::IndexEntry &entry : reader.index()) {
+      if (entry.offset >= begin + PIECE_SIZE && entry.offset < reader.end()) {
+        pieces.emplace_back(begin, entry.offset);
+        begin = entry.offset;
+      }
+    }
+    pieces.emplace_back(begin, reader.end());
+  } else {
+    if (options.has('p')) {
+      logger.fatal(getName(), ": -p needs a capture file.");
+      return COMMAND_ERROR;
+    }
+    if (!raw.open(path, error)) {
+      logger.fatal("Cannot read ", path, ": ", error);
+      return COMMAND_ERROR;
+    }
+    // A regex is matched line by line, so its pieces start on lines.
+    uint64_t begin = 0;
+    while (begin < raw.size()) {
+      uint64_t end = std::min<uint64_t>(raw.size(), begin + PIECE_SIZE);
+      if (searcher.isRegex() && end < raw.size()) {
+        const uint8_t *from = raw.data() + end;
+        size_t span = std::min<uint64_t>(byte_search::MAX_REGEX_SPAN,
+                                         raw.size() - end);
+        const void *newline = std::memchr(from, '\n', span);
+        if (newline != nullptr) {
+          end = static_cast<const uint8_t *>(newline) - raw.data() + 1;
+        }
+      }
+      pieces.emplace_back(begin, end);
+      begin = end;
+    }
+  }
+  uint64_t total = is_capture ? reader.end() - reader.begin() : raw.size();
+
+  std::atomic<uint64_t> searched{0};
+  auto start = std::chrono::steady_clock::now();
+  {
+    ThreadPool pool(std::min<size_t>(static_cast<size_t>(jobs),
+                                     pieces.size()));
+    for (Piece &piece : pieces) {
+      pool.submit([&] {
+        if (context.cancelled()) {
+          return;
+        }
+        if (is_capture) {
+          searchCapture(searcher, reader, stream_ok,
+                        static_cast<size_t>(shown), piece);
+        } else {
+          searchRaw(searcher, raw, static_cast<size_t>(shown), piece);
+        }
+        context.progress(searched += piece.end - piece.begin, total);
+      });
+    }
+    pool.wait();
+  }
+  if (context.cancelled()) {
+    logger.warn(getName(), " cancelled.");
+    return COMMAND_CANCELLED;
+  }
+
+  uint64_t count = 0;
+  std::vector<Match> matches;
+  for (const Piece &piece : pieces) {
+    count += piece.count;
+    matches.insert(matches.end(), piece.matches.begin(),
+                   piece.matches.end());
+  }
+  // Join literals cut between pieces: carry each stream's last bytes
+  // from piece to piece.
+  size_t keep = searcher.isRegex() ? 0 : searcher.overlap();
+  if (is_capture && keep > 0) {
+    std::vector<Edge> carried(stream_ok.size() * 2);
+    std::vector<uint8_t> joined;
+    Piece seams(0, 0);
+    for (const Piece &piece : pieces) {
+      for (size_t stream = 0; stream < carried.size(); stream++) {
+        if (!carried[stream].bytes.empty() &&
+            !piece.heads[stream].bytes.empty()) {
+          searchSeam(searcher, carried[stream],
+                     piece.heads[stream].bytes.data(),
+                     piece.heads[stream].bytes.size(),
+                     static_cast<uint16_t>(stream / 2),
+                     static_cast<capture::Direction>(stream % 2),
+                     static_cast<size_t>(shown), seams, joined);
+        }
+        carried[stream].append(piece.tails[stream]);
+        carried[stream].keepLast(keep);
+      }
+    }
+    count += seams.count;
+    matches.insert(matches.end(), seams.matches.begin(), seams.matches.end());
+  }
+  std::sort(matches.begin(), matches.end(),
+            [](const Match &a, const Match &b) { return a.offset < b.offset; });
+  if (matches.size() > static_cast<size_t>(shown)) {
+    matches.resize(static_cast<size_t>(shown));
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  for (const Match &match : matches) {
+    if (is_capture) {
+      char relative[32];
+      std::snprintf(relative, sizeof(relative), "+%.6f s",
+                    match.time_ns / 1e9);
+      logger.info("  ", wallTime(reader.wallStartNs() + match.time_ns), "  ",
+                  relative, "  ", reader.portName(match.port), "  ",
+                  capture::directionName(match.direction), "  ",
+                  match.shown);
+    } else {
+      logger.info("  ", hexOffset(match.offset), "  ", match.shown);
+    }
+  }
+  char summary[96];
+  std::snprintf(summary, sizeof(summary),
+                "%.2f MiB in %.3f s (%.0f MiB/s, %zu thread(s), %s)",
+                total / 1048576.0, seconds,
+                seconds > 0 ? total / 1048576.0 / seconds : 0.0,
+                std::min<size_t>(static_cast<size_t>(jobs), pieces.size()),
+                byte_search::scanLevelName(byte_search::scanLevel()));
+  logger.info(count, " match(es) in ", summary, ".");
+  if (count > matches.size() && shown > 0) {
+    logger.info("Showing the first ", matches.size(), "; -m shows more.");
+  }
+  return COMMAND_SUCCESS;
+}
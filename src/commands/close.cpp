@@ -0,0 +1,64 @@
+#include "../../include/commands/close.hpp"
+#include "../../include/args_opt.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'a', "all", ArgumentOptions::NO_ARG, ValueType::STRING},
+});
+
+} // namespace
+
+CloseCommand::CloseCommand(PortManager &ports) : ports_(ports) {}
+
+std::string CloseCommand::getName() const { return "close"; }
+std::string CloseCommand::getDescription() const {
+  return "Closes serial ports: close <port>... | close --all";
+}
+
+const opt_parser::OptionTable *CloseCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+ArgumentKind CloseCommand::getArgumentKind() const {
+  return ArgumentKind::PORT;
+}
+
+int CloseCommand::execute(const std::vector<std::string> &arguments) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  if (!options.ok()) {
+    logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    logger.fatal("Usage: ", getName(), " <port>... | ", getName(), " --all");
+    return COMMAND_ERROR;
+  }
+  size_t first_arg = options.firstPositional();
+
+  if (options.has('a')) {
+    size_t count = ports_.closeAll();
+    logger.success("Closed ", count, " port(s).");
+    return COMMAND_SUCCESS;
+  }
+
+  if (first_arg == arguments.size()) {
+    logger.fatal("Usage: ", getName(), " <port>... | ", getName(), " --all");
+    return COMMAND_ERROR;
+  }
+
+  int result = COMMAND_SUCCESS;
+  for (size_t i = first_arg; i < arguments.size(); i++) {
+    if (ports_.close(arguments[i])) {
+      logger.success("Closed '", arguments[i], "'.");
+    } else {
+      logger.fatal("No open port named '", arguments[i], "'.");
+      result = COMMAND_ERROR;
+    }
+  }
+  return result;
+}
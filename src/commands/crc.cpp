@@ -0,0 +1,175 @@
+#include "../../include/commands/crc.hpp"
+#include "../../include/args_opt.hpp"
+#include "../../include/crc.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'a', "algorithm", ArgumentOptions::REQ_ARG, ValueType::STRING},
+    {'x', "hex", ArgumentOptions::REQ_ARG, ValueType::HEX_BYTES},
+    {'f', "file", ArgumentOptions::REQ_ARG, ValueType::STRING},
+    {'v', "verify", ArgumentOptions::NO_ARG, ValueType::STRING},
+    {'s', "self-test", ArgumentOptions::NO_ARG, ValueType::STRING},
+});
+
+const size_t FILE_CHUNK = 256 * 1024;
+
+// Streams a file through every checksum at once.
+bool checksumFile(const std::string &path, std::vector<crc::Crc> &crcs,
+                  size_t &total, std::string &error) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error = std::strerror(errno);
+    return false;
+  }
+  std::vector<uint8_t> buffer(FILE_CHUNK);
+  total = 0;
+  while (true) {
+    ssize_t n = ::read(fd, buffer.data(), buffer.size());
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      error = std::strerror(errno);
+      ::close(fd);
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    for (crc::Crc &crc : crcs) {
+      crc.update(buffer.data(), static_cast<size_t>(n));
+    }
+    total += static_cast<size_t>(n);
+  }
+  ::close(fd);
+  return true;
+}
+
+} // namespace
+
+CrcCommand::CrcCommand() {}
+
+std::string CrcCommand::getName() const { return "crc"; }
+std::string CrcCommand::getDescription() const {
+  return "Computes or verifies CRCs: crc [-a ccitt|modbus|crc32|crc32c] "
+         "[-v] -x <hex> | -f <file> | <text>";
+}
+
+const opt_parser::OptionTable *CrcCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+int CrcCommand::execute(const std::vector<std::string> &arguments) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  if (!options.ok()) {
+    logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    logger.fatal("Usage: ", getName(), " [-a <algorithm>] [-v] -x <hex> | -f ",
+                 "<file> | <text>...");
+    return COMMAND_ERROR;
+  }
+  size_t first_arg = options.firstPositional();
+
+  if (options.has('s')) {
+    std::string failure;
+    if (!crc::selfTest(failure)) {
+      logger.fatal("CRC self-test failed: ", failure, ".");
+      return COMMAND_ERROR;
+    }
+    logger.success("CRC self-test passed (best engine: ",
+                   crc::engineName(crc::bestEngine()), ").");
+    return COMMAND_SUCCESS;
+  }
+
+  std::vector<crc::Crc> crcs;
+  if (options.has('a')) {
+    crc::Algorithm algorithm;
+    if (!crc::parseAlgorithm(options.str('a'), algorithm)) {
+      logger.fatal(getName(), ": unknown algorithm '", options.str('a'),
+                   "' (expected ccitt, modbus, crc32 or crc32c).");
+      return COMMAND_ERROR;
+    }
+    crcs.emplace_back(algorithm);
+  } else {
+    for (size_t i = 0; i < crc::ALGORITHM_COUNT; i++) {
+      crcs.emplace_back(static_cast<crc::Algorithm>(i));
+    }
+  }
+
+  int sources = (options.has('x') ? 1 : 0) + (options.has('f') ? 1 : 0) +
+                (first_arg < arguments.size() ? 1 : 0);
+  if (sources != 1) {
+    logger.fatal("Usage: ", getName(), " [-a <algorithm>] [-v] -x <hex> | -f ",
+                 "<file> | <text>...");
+    return COMMAND_ERROR;
+  }
+
+  if (options.has('v')) {
+    // The input ends with its own checksum; only -x makes sense here.
+    if (!options.has('x') || crcs.size() != 1) {
+      logger.fatal(getName(), ": --verify needs -a <algorithm> and -x <hex>.");
+      return COMMAND_ERROR;
+    }
+    std::vector<uint8_t> frame = options.bytes('x');
+    crc::Algorithm algorithm = crcs.front().algorithm();
+    if (crc::verifyTrailer(algorithm, frame.data(), frame.size())) {
+      logger.success(crc::algorithmName(algorithm), " OK.");
+      return COMMAND_SUCCESS;
+    }
+    logger.fatal(crc::algorithmName(algorithm), " mismatch.");
+    return COMMAND_ERROR;
+  }
+
+  size_t total = 0;
+  if (options.has('x')) {
+    std::vector<uint8_t> data = options.bytes('x');
+    for (crc::Crc &crc : crcs) {
+      crc.update(data.data(), data.size());
+    }
+    total = data.size();
+  } else if (options.has('f')) {
+    std::string path(options.str('f'));
+    std::string error;
+    if (!checksumFile(path, crcs, total, error)) {
+      logger.fatal("Cannot read ", path, ": ", error);
+      return COMMAND_ERROR;
+    }
+  } else {
+    // Free text: the arguments joined by single spaces.
+    for (size_t i = first_arg; i < arguments.size(); i++) {
+      if (i > first_arg) {
+        for (crc::Crc &crc : crcs) {
+          crc.update(" ", 1);
+        }
+        total++;
+      }
+      for (crc::Crc &crc : crcs) {
+        crc.update(arguments[i].data(), arguments[i].size());
+      }
+      total += arguments[i].size();
+    }
+  }
+
+  for (const crc::Crc &crc : crcs) {
+    const char *name = crc::algorithmName(crc.algorithm());
+    int digits = static_cast<int>(crc::checksumSize(crc.algorithm()) * 2);
+    logger.info("  ", name, std::string(8 - std::strlen(name), ' '),
+                log_fmt::hex(crc.value(), digits));
+  }
+  logger.debug(total, " byte(s) checksummed.");
+  return COMMAND_SUCCESS;
+}
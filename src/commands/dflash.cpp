@@ -0,0 +1,207 @@
+#include "../../include/commands/dflash.hpp"
+#include "../../include/args_opt.hpp"
+#include "../../include/firmware_image.hpp"
+#include "../../include/flasher.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+#include "../../include/page_delta.hpp"
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+using flash_opt::requestFailed;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    flash_opt::WINDOW,
+    flash_opt::BLOCK_SIZE,
+    flash_opt::ADDRESS,
+    flash_opt::TIMEOUT,
+    flash_opt::RETRIES,
+    {'j', "jobs", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+    {'d', "dry-run", ArgumentOptions::NO_ARG, ValueType::STRING},
+    flash_opt::NO_VERIFY,
+    flash_opt::GO,
+});
+
+// Pages whose hashes differ, given both lists in the same page order.
+std::vector<uint32_t> changedPages(const std::vector<uint32_t> &pages,
+                                   const std::vector<uint32_t> &local,
+                                   const std::vector<uint32_t> &device) {
+  std::vector<uint32_t> changed;
+  for (size_t i = 0; i < pages.size(); i++) {
+    if (local[i] != device[i]) {
+      changed.push_back(pages[i]);
+    }
+  }
+  return changed;
+}
+
+} // namespace
+
+DflashCommand::DflashCommand(PortManager &ports) : ports_(ports) {}
+
+std::string DflashCommand::getName() const { return "dflash"; }
+std::string DflashCommand::getDescription() const {
+  return "Flashes only the pages that differ from the device: dflash "
+         "[-d] [-j <jobs>] [-n] [-g] <port> <image>";
+}
+
+const opt_parser::OptionTable *DflashCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+ArgumentKind DflashCommand::getArgumentKind() const {
+  return ArgumentKind::FILE;
+}
+
+int DflashCommand::run(const std::vector<std::string> &arguments,
+                       CommandContext &context) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  size_t first_arg = options.firstPositional();
+  if (!options.ok() || first_arg + 2 != arguments.size()) {
+    if (!options.ok()) {
+      logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    }
+    logger.fatal("Usage: ", getName(),
+                 " [-w <window>] [-s <block-size>] [-a <addr>] [-t <timeout>] "
+                 "[-r <retries>] [-j <jobs>] [-d] [-n] [-g] <port> <image>");
+    return COMMAND_ERROR;
+  }
+  const std::string &port = arguments[first_arg];
+  const std::string &path = arguments[first_arg + 1];
+
+  FlashOptions flash_options;
+  std::string error;
+  if (!flash_opt::parse(options, flash_options, error)) {
+    logger.fatal(getName(), ": ", error, ".");
+    return COMMAND_ERROR;
+  }
+  flash_options.cancel = &context.token();
+  int64_t jobs = options.integer(
+      'j', std::max(1u, std::thread::hardware_concurrency()));
+  if (jobs < 1 || jobs > 256) {
+    logger.fatal(getName(), ": jobs must be 1..256.");
+    return COMMAND_ERROR;
+  }
+
+  if (!ports_.find(port)) {
+    logger.fatal("No open port named '", port, "'.");
+    return COMMAND_ERROR;
+  }
+
+  Flasher flasher(ports_, port, flash_options);
+  bootloader::DeviceInfo info;
+  if (!flasher.hello(info, error)) {
+    if (context.cancelled()) {
+      return COMMAND_CANCELLED;
+    }
+    logger.fatal("Bootloader on '", port, "' did not answer: ", error);
+    return COMMAND_ERROR;
+  }
+
+  FirmwareImage image;
+  uint32_t base = static_cast<uint32_t>(options.integer('a', info.flash_base));
+  if (!image.load(path, base, error)) {
+    logger.fatal("Cannot load ", path, ": ", error);
+    return COMMAND_ERROR;
+  }
+  std::vector<uint32_t> pages;
+  if (!page_delta::touchedPages(image.segments(), info, pages, error)) {
+    logger.fatal("Cannot flash ", path, ": ", error);
+    return COMMAND_ERROR;
+  }
+  if (pages.empty()) {
+    logger.fatal(path, " contains no data.");
+    return COMMAND_ERROR;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  // Hash the image while the device hashes its flash.
+  std::future<std::vector<uint32_t>> local = std::async(
+      std::launch::async, page_delta::hashPages, std::cref(image.segments()),
+      std::cref(pages), info.page_size, static_cast<unsigned>(jobs));
+  std::vector<uint32_t> device;
+  std::vector<uint32_t> device_run;
+  for (const page_delta::PageRun &run :
+       page_delta::runs(pages, info.page_size)) {
+    if (!flasher.pageHashes(run.address, run.count, info, device_run,
+                            error)) {
+      local.wait();
+      return requestFailed(context, port, "Cannot read page hashes: ", error);
+    }
+    device.insert(device.end(), device_run.begin(), device_run.end());
+  }
+  std::vector<uint32_t> local_hashes = local.get();
+
+  std::vector<uint32_t> changed = changedPages(pages, local_hashes, device);
+  logger.info(changed.size(), " of ", pages.size(), " page(s) differ on '",
+              port, "' (page ", info.page_size, ").");
+  if (options.has('d')) {
+    for (const page_delta::PageRun &run :
+         page_delta::runs(changed, info.page_size)) {
+      logger.info("  ", log_fmt::hex(run.address, 8), " +",
+                  run.count * info.page_size);
+    }
+    return COMMAND_SUCCESS;
+  }
+
+  if (!changed.empty()) {
+    std::vector<Segment> delta =
+        page_delta::clip(image.segments(), changed, info.page_size);
+    if (!flasher.erase(delta, info, error)) {
+      return requestFailed(context, port, "Erase failed: ", error);
+    }
+    FlashStats stats;
+    auto progress = [&context](size_t done, size_t total) {
+      context.progress(done, total);
+    };
+    if (!flasher.write(delta, info, progress, stats, error)) {
+      return requestFailed(context, port, "Write failed: ", error);
+    }
+
+    if (!options.has('n')) {
+      std::vector<uint32_t> changed_hashes =
+          page_delta::hashPages(image.segments(), changed, info.page_size,
+                                static_cast<unsigned>(jobs));
+      device.clear();
+      for (const page_delta::PageRun &run :
+           page_delta::runs(changed, info.page_size)) {
+        if (!flasher.pageHashes(run.address, run.count, info, device_run,
+                                error)) {
+          return requestFailed(context, port, "Verify failed: ", error);
+        }
+        device.insert(device.end(), device_run.begin(), device_run.end());
+      }
+      std::vector<uint32_t> bad =
+          changedPages(changed, changed_hashes, device);
+      if (!bad.empty()) {
+        logger.fatal("Verify failed: ", bad.size(), " page(s) differ, first ",
+                     "at ", log_fmt::hex(bad.front(), 8), ".");
+        return COMMAND_ERROR;
+      }
+    }
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    logger.success("Flashed ", stats.bytes, " of ", image.size(),
+                   " bytes in ", seconds, " s, ", stats.retransmits,
+                   " retransmit(s)", options.has('n') ? "." : ", verified.");
+  } else {
+    logger.success("'", port, "' already holds ", path, ".");
+  }
+
+  if (options.has('g') && !flasher.boot(error)) {
+    return requestFailed(context, port, "Boot request failed: ", error);
+  }
+  return COMMAND_SUCCESS;
+}
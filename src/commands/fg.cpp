@@ -0,0 +1,43 @@
+#include "../../include/commands/fg.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+
+FgCommand::FgCommand(JobManager &jobs) : jobs_(jobs) {}
+
+std::string FgCommand::getName() const { return "fg"; }
+std::string FgCommand::getDescription() const {
+  return "Waits for a background job and returns its result; Ctrl+C kills "
+         "it: fg [<job>]";
+}
+
+int FgCommand::run(const std::vector<std::string> &arguments,
+                   CommandContext &context) {
+  extern Logger logger;
+  int id = 0;
+  if (arguments.size() > 2 ||
+      (arguments.size() == 2 && !JobManager::parseJobId(arguments[1], id))) {
+    logger.fatal("Usage: ", getName(), " [<job>]");
+    return COMMAND_ERROR;
+  }
+
+  if (id != 0 && id == context.jobId()) {
+    logger.fatal("Job [", id, "] cannot wait for itself.");
+    return COMMAND_ERROR;
+  }
+
+  JobInfo info;
+  if (!jobs_.wait(id, context.jobId(), context.token(), info)) {
+    if (id == 0) {
+      logger.fatal("No background jobs.");
+    } else {
+      logger.fatal("No job [", id, "].");
+    }
+    return COMMAND_ERROR;
+  }
+  // The job announced its own outcome when it finished, or will once it
+  // has stopped.
+  if (info.state != JobState::DONE && info.state != JobState::FAILED) {
+    return COMMAND_CANCELLED;
+  }
+  return info.result;
+}
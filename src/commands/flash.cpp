@@ -0,0 +1,156 @@
+#include "../../include/commands/flash.hpp"
+#include "../../include/args_opt.hpp"
+#include "../../include/crc.hpp"
+#include "../../include/firmware_image.hpp"
+#include "../../include/flasher.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+
+#include <chrono>
+#include <string>
+
+namespace {
+
+using flash_opt::requestFailed;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    flash_opt::WINDOW,
+    flash_opt::BLOCK_SIZE,
+    flash_opt::ADDRESS,
+    flash_opt::TIMEOUT,
+    flash_opt::RETRIES,
+    flash_opt::NO_VERIFY,
+    flash_opt::GO,
+});
+
+} // namespace
+
+FlashCommand::FlashCommand(PortManager &ports) : ports_(ports) {}
+
+std::string FlashCommand::getName() const { return "flash"; }
+std::string FlashCommand::getDescription() const {
+  return "Writes a .bin/.hex image through the bootloader: flash [-w <window>] "
+         "[-a <addr>] [-n] [-g] <port> <image>";
+}
+
+const opt_parser::OptionTable *FlashCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+ArgumentKind FlashCommand::getArgumentKind() const {
+  return ArgumentKind::FILE;
+}
+
+int FlashCommand::run(const std::vector<std::string> &arguments,
+                      CommandContext &context) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  size_t first_arg = options.firstPositional();
+  if (!options.ok() || first_arg + 2 != arguments.size()) {
+    if (!options.ok()) {
+      logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    }
+    logger.fatal("Usage: ", getName(),
+                 " [-w <window>] [-s <block-size>] [-a <addr>] [-t <timeout>] "
+                 "[-r <retries>] [-n] [-g] <port> <image>");
+    return COMMAND_ERROR;
+  }
+  const std::string &port = arguments[first_arg];
+  const std::string &path = arguments[first_arg + 1];
+
+  FlashOptions flash_options;
+  std::string error;
+  if (!flash_opt::parse(options, flash_options, error)) {
+    logger.fatal(getName(), ": ", error, ".");
+    return COMMAND_ERROR;
+  }
+  flash_options.cancel = &context.token();
+
+  if (!ports_.find(port)) {
+    logger.fatal("No open port named '", port, "'.");
+    return COMMAND_ERROR;
+  }
+
+  Flasher flasher(ports_, port, flash_options);
+  bootloader::DeviceInfo info;
+  if (!flasher.hello(info, error)) {
+    if (context.cancelled()) {
+      return COMMAND_CANCELLED;
+    }
+    logger.fatal("Bootloader on '", port, "' did not answer: ", error);
+    return COMMAND_ERROR;
+  }
+
+  // Raw binaries go to --address, or the start of flash by default.
+  FirmwareImage image;
+  uint32_t base = static_cast<uint32_t>(options.integer('a', info.flash_base));
+  if (!image.load(path, base, error)) {
+    logger.fatal("Cannot load ", path, ": ", error);
+    return COMMAND_ERROR;
+  }
+  if (image.segments().empty()) {
+    logger.fatal(path, " contains no data.");
+    return COMMAND_ERROR;
+  }
+  logger.info("Flashing ", image.size(), " bytes in ",
+              image.segments().size(), " segment(s) to '", port, "' (page ",
+              info.page_size, ", block ", info.max_block, ", window ",
+              flash_options.window, ").");
+
+  auto start = std::chrono::steady_clock::now();
+  if (!flasher.erase(image.segments(), info, error)) {
+    return requestFailed(context, port, "Erase failed: ", error);
+  }
+
+  // A progress line per quarter keeps the console readable.
+  int next_quarter = 1;
+  auto progress = [&](size_t done, size_t total) {
+    context.progress(done, total);
+    while (next_quarter < 4 && done * 4 >= total * next_quarter) {
+      logger.info("  ", next_quarter * 25, "% (", done, "/", total, ")");
+      next_quarter++;
+    }
+  };
+
+  FlashStats stats;
+  if (!flasher.write(image.segments(), info, progress, stats, error)) {
+    return requestFailed(context, port, "Write failed: ", error);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  if (!options.has('n')) {
+    for (const Segment &segment : image.segments()) {
+      uint32_t device_crc = 0;
+      if (!flasher.checksum(segment.address,
+                            static_cast<uint32_t>(segment.size), device_crc,
+                            error)) {
+        return requestFailed(context, port, "Verify failed: ", error);
+      }
+      uint32_t local_crc =
+          crc::compute(crc::Algorithm::CRC32, segment.data, segment.size);
+      if (device_crc != local_crc) {
+        logger.fatal("Verify failed at ", log_fmt::hex(segment.address, 8),
+                     ": device CRC ", log_fmt::hex(device_crc, 8),
+                     ", image CRC ", log_fmt::hex(local_crc, 8), ".");
+        return COMMAND_ERROR;
+      }
+    }
+  }
+
+  logger.success("Flashed ", stats.bytes, " bytes in ", seconds, " s (",
+                 static_cast<size_t>(stats.bytes / seconds / 1024), " KiB/s), ",
+                 stats.retransmits, " retransmit(s)",
+                 options.has('n') ? "." : ", verified.");
+  if (stats.retransmits > 0) {
+    logger.debug("  ", stats.timeouts, " timeout(s), ", stats.naks,
+                 " NAK(s).");
+  }
+
+  if (options.has('g') && !flasher.boot(error)) {
+    return requestFailed(context, port, "Boot request failed: ", error);
+  }
+  return COMMAND_SUCCESS;
+}
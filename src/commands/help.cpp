@@ -16,6 +16,10 @@ std::string HelpCommand::getDescription() const {
   return "Displays available commands or help for a specific command.";
 }
 
+ArgumentKind HelpCommand::getArgumentKind() const {
+  return ArgumentKind::COMMAND;
+}
+
 int HelpCommand::execute(const std::vector<std::string> &arguments) {
   const auto &commands = registry_.getCommands(); // Get map [name -> ICommand*]
 
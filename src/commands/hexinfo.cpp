@@ -0,0 +1,90 @@
+#include "../../include/commands/hexinfo.hpp"
+#include "../../include/args_opt.hpp"
+#include "../../include/crc.hpp"
+#include "../../include/firmware_image.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+
+#include <chrono>
+#include <string>
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'a', "address", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+    {'j', "jobs", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+});
+
+} // namespace
+
+HexinfoCommand::HexinfoCommand() {}
+
+std::string HexinfoCommand::getName() const { return "hexinfo"; }
+std::string HexinfoCommand::getDescription() const {
+  return "Lists the segments of a .hex/.srec/.bin image with sizes and "
+         "CRC-32s: hexinfo [-a <addr>] [-j <jobs>] <image>";
+}
+
+const opt_parser::OptionTable *HexinfoCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+ArgumentKind HexinfoCommand::getArgumentKind() const {
+  return ArgumentKind::FILE;
+}
+
+int HexinfoCommand::execute(const std::vector<std::string> &arguments) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  size_t first_arg = options.firstPositional();
+  if (!options.ok() || first_arg + 1 != arguments.size()) {
+    if (!options.ok()) {
+      logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    }
+    logger.fatal("Usage: ", getName(), " [-a <addr>] [-j <jobs>] <image>");
+    return COMMAND_ERROR;
+  }
+  const std::string &path = arguments[first_arg];
+  int64_t jobs = options.integer('j', 0);
+  int64_t address = options.integer('a', 0);
+  if (jobs < 0 || jobs > 256 || address < 0 || address > 0xFFFFFFFF) {
+    logger.fatal(getName(), ": jobs must be 0..256 (0 = one per CPU) and ",
+                 "the address 0..0xffffffff.");
+    return COMMAND_ERROR;
+  }
+
+  FirmwareImage image;
+  std::string error;
+  auto start = std::chrono::steady_clock::now();
+  if (!image.load(path, static_cast<uint32_t>(address), error,
+                  static_cast<unsigned>(jobs))) {
+    logger.fatal("Cannot load ", path, ": ", error);
+    return COMMAND_ERROR;
+  }
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+
+  logger.info(path, ": ", imageFormatName(image.format()), ", ",
+              image.segments().size(), " segment(s), ", image.size(),
+              " bytes (loaded in ", ms, " ms).");
+  // The image CRC runs over the segments back to back, gaps skipped.
+  crc::Crc whole(crc::Algorithm::CRC32);
+  for (const Segment &segment : image.segments()) {
+    logger.info("  ", log_fmt::hex(segment.address, 8), "-",
+                log_fmt::hex(segment.end() - 1, 8), "  ", segment.size,
+                " bytes  crc32 ",
+                log_fmt::hex(crc::compute(crc::Algorithm::CRC32, segment.data,
+                                          segment.size),
+                             8));
+    whole.update(segment.data, segment.size);
+  }
+  if (image.segments().size() > 1) {
+    logger.info("  image crc32 ", log_fmt::hex(whole.value(), 8));
+  }
+  return COMMAND_SUCCESS;
+}
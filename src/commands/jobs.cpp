@@ -0,0 +1,50 @@
+#include "../../include/commands/jobs.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+JobsCommand::JobsCommand(JobManager &jobs) : jobs_(jobs) {}
+
+std::string JobsCommand::getName() const { return "jobs"; }
+std::string JobsCommand::getDescription() const {
+  return "Lists background jobs. End a command with '&' to start one.";
+}
+
+int JobsCommand::execute(const std::vector<std::string> &arguments) {
+  extern Logger logger;
+  if (arguments.size() > 1) {
+    logger.fatal("Usage: ", getName());
+    return COMMAND_ERROR;
+  }
+
+  std::vector<JobInfo> infos = jobs_.list();
+  if (infos.empty()) {
+    logger.info("No background jobs.");
+    return COMMAND_SUCCESS;
+  }
+
+  logger.info("  JOB   STATE        TIME      COMMAND");
+  for (const JobInfo &info : infos) {
+    std::string id = "[" + std::to_string(info.id) + "]";
+    std::string state = jobStateName(info.state);
+    if (info.state == JobState::FAILED) {
+      state += " " + std::to_string(info.result);
+    } else if (info.state == JobState::RUNNING && info.total > 0) {
+      state += " " + std::to_string(info.done * 100 / info.total) + "%";
+    }
+    char time[32];
+    std::snprintf(time, sizeof(time), "%.1f s", info.seconds);
+    size_t time_len = std::strlen(time);
+    logger.info("  ", id,
+                std::string(6 - std::min<size_t>(id.length(), 5), ' '), state,
+                std::string(13 - std::min<size_t>(state.length(), 12), ' '),
+                time, std::string(10 - std::min<size_t>(time_len, 9), ' '),
+                info.line);
+  }
+  return COMMAND_SUCCESS;
+}
@@ -0,0 +1,34 @@
+#include "../../include/commands/kill.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+
+KillCommand::KillCommand(JobManager &jobs) : jobs_(jobs) {}
+
+std::string KillCommand::getName() const { return "kill"; }
+std::string KillCommand::getDescription() const {
+  return "Cancels background jobs: kill <job>...";
+}
+
+int KillCommand::execute(const std::vector<std::string> &arguments) {
+  extern Logger logger;
+  if (arguments.size() < 2) {
+    logger.fatal("Usage: ", getName(), " <job>...");
+    return COMMAND_ERROR;
+  }
+
+  int result = COMMAND_SUCCESS;
+  for (size_t i = 1; i < arguments.size(); i++) {
+    int id;
+    std::string error;
+    if (!JobManager::parseJobId(arguments[i], id)) {
+      logger.fatal("Not a job id: '", arguments[i], "'.");
+      result = COMMAND_ERROR;
+    } else if (!jobs_.kill(id, error)) {
+      logger.fatal(getName(), ": ", error, ".");
+      result = COMMAND_ERROR;
+    } else {
+      logger.success("Asked job [", id, "] to stop.");
+    }
+  }
+  return result;
+}
@@ -0,0 +1,88 @@
+#include "../../include/commands/open.hpp"
+#include "../../include/args_opt.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+#include "../../include/serial_port.hpp"
+
+#include <string>
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'b', "baud", ArgumentOptions::REQ_ARG, ValueType::BAUD},
+    {'p', "pty", ArgumentOptions::NO_ARG, ValueType::STRING},
+    {'f', "framing", ArgumentOptions::REQ_ARG, ValueType::STRING},
+});
+
+} // namespace
+
+OpenCommand::OpenCommand(PortManager &ports) : ports_(ports) {}
+
+std::string OpenCommand::getName() const { return "open"; }
+std::string OpenCommand::getDescription() const {
+  return "Opens a serial port: open [-b <baud>] [-f raw|newline|cobs|slip] "
+         "<device> | open --pty";
+}
+
+const opt_parser::OptionTable *OpenCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+ArgumentKind OpenCommand::getArgumentKind() const {
+  return ArgumentKind::DEVICE;
+}
+
+int OpenCommand::execute(const std::vector<std::string> &arguments) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  if (!options.ok()) {
+    logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    logger.fatal("Usage: ", getName(), " [-b <baud>] [-f <framing>] <device> | ",
+                 getName(), " --pty [-f <framing>]");
+    return COMMAND_ERROR;
+  }
+  size_t first_arg = options.firstPositional();
+
+  framing::Framing framing = framing::Framing::RAW;
+  if (options.has('f') && !framing::parseFraming(options.str('f'), framing)) {
+    logger.fatal(getName(), ": unknown framing '", options.str('f'),
+                 "' (expected raw, newline, cobs or slip).");
+    return COMMAND_ERROR;
+  }
+
+  std::string name;
+  std::string error;
+
+  if (options.has('p')) {
+    std::string slave_path;
+    if (!ports_.openPty(name, slave_path, error)) {
+      logger.fatal("Cannot create pty: ", error);
+      return COMMAND_ERROR;
+    }
+    ports_.setFraming(name, framing);
+    logger.success("Opened '", name, "', peer end is ", slave_path, ".");
+    return COMMAND_SUCCESS;
+  }
+
+  if (first_arg + 1 != arguments.size()) {
+    logger.fatal("Usage: ", getName(), " [-b <baud>] [-f <framing>] <device>");
+    return COMMAND_ERROR;
+  }
+  const std::string &device = arguments[first_arg];
+
+  // Already checked against the supported rates while parsing.
+  int baud = options.baud('b', serial::DEFAULT_BAUD);
+
+  if (!ports_.open(device, baud, name, error)) {
+    logger.fatal("Cannot open ", device, ": ", error);
+    return COMMAND_ERROR;
+  }
+  ports_.setFraming(name, framing);
+
+  logger.success("Opened '", name, "' (", device, " @ ", baud, " baud).");
+  return COMMAND_SUCCESS;
+}
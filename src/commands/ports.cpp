@@ -0,0 +1,59 @@
+#include "../../include/commands/ports.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+PortsCommand::PortsCommand(const PortManager &ports) : ports_(ports) {}
+
+std::string PortsCommand::getName() const { return "ports"; }
+std::string PortsCommand::getDescription() const {
+  return "Lists open serial ports with their traffic counters.";
+}
+
+int PortsCommand::execute(const std::vector<std::string> &arguments) {
+  extern Logger logger;
+  if (arguments.size() > 1) {
+    logger.fatal("Usage: ", getName());
+    return COMMAND_ERROR;
+  }
+
+  std::vector<PortInfo> infos = ports_.list();
+  if (infos.empty()) {
+    logger.info("No open ports. Use 'open <device>' to attach one.");
+    return COMMAND_SUCCESS;
+  }
+
+  size_t name_len = 4;
+  size_t path_len = 4;
+  for (const PortInfo &info : infos) {
+    name_len = std::max(name_len, info.name.length());
+    path_len = std::max(path_len, info.path.length());
+  }
+
+  logger.info("  NAME", std::string(name_len - 2, ' '), "PATH",
+              std::string(path_len - 2, ' '), "BAUD      FRAMING  RX          TX",
+              "          BUFFERED  DROPPED   BAD FRAMES");
+  for (const PortInfo &info : infos) {
+    std::string baud = info.is_pty ? "pty" : std::to_string(info.baud);
+    std::string framing = framing::framingName(info.framing);
+    std::string rx = std::to_string(info.rx_bytes);
+    std::string tx = std::to_string(info.tx_bytes);
+    std::string buffered = std::to_string(info.rx_buffered);
+    std::string dropped = std::to_string(info.rx_dropped);
+    logger.info("  ", info.name, std::string(name_len - info.name.length() + 2, ' '),
+                info.path, std::string(path_len - info.path.length() + 2, ' '),
+                baud, std::string(10 - std::min<size_t>(baud.length(), 9), ' '),
+                framing, std::string(9 - std::min<size_t>(framing.length(), 8), ' '),
+                rx, std::string(12 - std::min<size_t>(rx.length(), 11), ' '),
+                tx, std::string(12 - std::min<size_t>(tx.length(), 11), ' '),
+                buffered,
+                std::string(10 - std::min<size_t>(buffered.length(), 9), ' '),
+                dropped,
+                std::string(10 - std::min<size_t>(dropped.length(), 9), ' '),
+                info.frame_errors);
+  }
+  return COMMAND_SUCCESS;
+}
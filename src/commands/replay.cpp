@@ -0,0 +1,338 @@
+#include "../../include/commands/replay.hpp"
+#include "../../include/capture_file.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/latency_histogram.hpp"
+#include "../../include/logger.hpp"
+#include "../../include/mapped_file.hpp"
+#include "../../include/table_format.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+using table_fmt::duration;
+using Clock = std::chrono::steady_clock;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'s', "speed", ArgumentOptions::REQ_ARG, ValueType::STRING},
+    {'m', "max", ArgumentOptions::NO_ARG, ValueType::STRING},
+    {'S', "start", ArgumentOptions::REQ_ARG, ValueType::DURATION},
+    {'p', "port", ArgumentOptions::REQ_ARG, ValueType::STRING},
+    {'t', "tx", ArgumentOptions::NO_ARG, ValueType::STRING},
+    {'r', "record", ArgumentOptions::NO_ARG, ValueType::STRING},
+    {'d', "duration", ArgumentOptions::REQ_ARG, ValueType::DURATION},
+});
+
+// Raw files carry no timing: they go out in chunks of this size, paced at
+// the port's line rate (10 bits per byte).
+const size_t RAW_CHUNK = 256;
+// The last stretch before a chunk is due is spun rather than slept, as
+// sleeps overshoot by tens of microseconds.
+const std::chrono::microseconds SPIN{200};
+const size_t RECORD_BUFFER = 64 * 1024;
+
+// One piece of the recording to send.
+struct Chunk {
+  uint64_t time_ns; // since the start of the recording
+  const uint8_t *data;
+  size_t length;
+};
+
+uint64_t steadyNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now().time_since_epoch())
+          .count());
+}
+
+// Sleeps until due, waking every POLL to check for cancellation.
+// Returns false if cancelled.
+bool waitUntil(Clock::time_point due, const CommandContext &context) {
+  while (true) {
+    Clock::time_point now = Clock::now();
+    if (now >= due) {
+      return !context.cancelled();
+    }
+    if (due - now > CancellationToken::POLL) {
+      if (!context.token().waitFor(CancellationToken::POLL)) {
+        return false;
+      }
+    } else if (due - now > SPIN) {
+      std::this_thread::sleep_until(due - SPIN);
+    } else {
+      while (Clock::now() < due) {
+      }
+    }
+  }
+}
+
+} // namespace
+
+ReplayCommand::ReplayCommand(PortManager &ports) : ports_(ports) {}
+
+std::string ReplayCommand::getName() const { return "replay"; }
+std::string ReplayCommand::getDescription() const {
+  return "Plays a capture or raw file into a port (or `open --pty`) at its "
+         "original timing: replay [-s <speed> | -m] [-S <start>] [-p <port>] "
+         "[-t] <port> <file>; replay -r [-d <duration>] <port> <file> "
+         "records one";
+}
+
+const opt_parser::OptionTable *ReplayCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+ArgumentKind ReplayCommand::getArgumentKind() const {
+  return ArgumentKind::FILE;
+}
+
+int ReplayCommand::run(const std::vector<std::string> &arguments,
+                       CommandContext &context) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  size_t first_arg = options.firstPositional();
+  if (!options.ok() || first_arg + 2 != arguments.size()) {
+    if (!options.ok()) {
+      logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    }
+    logger.fatal("Usage: ", getName(),
+                 " [-s <speed> | -m] [-S <start>] [-p <port>] [-t] "
+                 "<port> <file>");
+    logger.fatal("       ", getName(), " -r [-d <duration>] <port> <file>");
+    return COMMAND_ERROR;
+  }
+  std::shared_ptr<Port> target = ports_.find(arguments[first_arg]);
+  if (!target) {
+    logger.fatal("No open port named '", arguments[first_arg], "'.");
+    return COMMAND_ERROR;
+  }
+  const std::string &port = target->name;
+  const std::string &path = arguments[first_arg + 1];
+  if (options.has('r')) {
+    return record(port, path, options, context);
+  }
+
+  double speed = 1;
+  if (options.has('s')) {
+    std::string text(options.str('s'));
+    char *end = nullptr;
+    speed = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || *end != '\0' || !(speed > 0)) {
+      logger.fatal(getName(), ": speed must be a positive factor, e.g. 2 "
+                              "or 0.5.");
+      return COMMAND_ERROR;
+    }
+  }
+  bool max_speed = options.has('m');
+  uint64_t start_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          options.duration('S', std::chrono::microseconds(0)))
+          .count());
+
+  // Either source hands out chunks in time order through next().
+  std::string error;
+  capture::Reader reader;
+  MappedFile raw;
+  size_t position = 0;
+  size_t first = 0;
+  size_t last = 0;
+  std::vector<bool> wanted; // capture port ids to play
+  capture::Direction direction = options.has('t') ? capture::TX : capture::RX;
+  std::function<bool(Chunk &)> next;
+
+  if (capture::isCapture(path)) {
+    if (!reader.open(path, error)) {
+      logger.fatal("Cannot read ", path, ": ", error);
+      return COMMAND_ERROR;
+    }
+    if (!reader.complete()) {
+      logger.warn(path, " was not closed cleanly; replaying what is there.");
+    }
+    std::string from(options.str('p'));
+    size_t sources = 0;
+    for (size_t id = 0; id < reader.ports(); id++) {
+      bool match = from.empty() ||
+                   reader.portName(static_cast<uint16_t>(id)) == from;
+      wanted.push_back(match);
+      sources += match;
+    }
+    if (sources == 0) {
+      logger.fatal(path, " holds no traffic from '", from, "'.");
+      return COMMAND_ERROR;
+    }
+    if (sources > 1) {
+      logger.warn("Merging the ", capture::directionName(direction),
+                  " traffic of ", sources, " ports; pick one with -p.");
+    }
+    first = position = reader.seek(start_ns);
+    last = reader.end();
+    next = [&](Chunk &chunk) {
+      capture::Record record;
+      while (reader.next(position, record)) {
+        if (record.direction == direction && record.port < wanted.size() &&
+            wanted[record.port] && record.length > 0) {
+          chunk = Chunk{record.time_ns, record.data, record.length};
+          return true;
+        }
+      }
+      return false;
+    };
+  } else {
+    if (options.has('p') || options.has('t')) {
+      logger.fatal(getName(), ": -p and -t need a capture file.");
+      return COMMAND_ERROR;
+    }
+    if (!raw.open(path, error)) {
+      logger.fatal("Cannot read ", path, ": ", error);
+      return COMMAND_ERROR;
+    }
+    double ns_per_byte = 1e10 / target->baud;
+    first = position = std::min(
+        raw.size(), static_cast<size_t>(start_ns / ns_per_byte));
+    last = raw.size();
+    next = [&](Chunk &chunk) {
+      if (position >= raw.size()) {
+        return false;
+      }
+      size_t length = std::min(RAW_CHUNK, raw.size() - position);
+      chunk = Chunk{static_cast<uint64_t>(position * ns_per_byte),
+                    raw.data() + position, length};
+      position += length;
+      return true;
+    };
+  }
+
+  LatencyHistogram lateness;
+  size_t chunks = 0;
+  uint64_t bytes = 0;
+  uint64_t base_ns = 0;
+  Clock::time_point began = Clock::now();
+  Chunk chunk;
+  bool cancelled = false;
+  while (next(chunk)) {
+    if (chunks == 0) {
+      base_ns = chunk.time_ns;
+      began = Clock::now();
+    }
+    if (!max_speed) {
+      auto offset = std::chrono::nanoseconds(static_cast<int64_t>(
+          static_cast<double>(chunk.time_ns - base_ns) / speed));
+      Clock::time_point due =
+          began + std::chrono::duration_cast<Clock::duration>(offset);
+      if (!waitUntil(due, context)) {
+        cancelled = true;
+        break;
+      }
+      lateness.record(Clock::now() - due);
+    } else if (context.cancelled()) {
+      cancelled = true;
+      break;
+    }
+
+    long sent = ports_.write(port, chunk.data, chunk.length);
+    if (sent < 0) {
+      logger.fatal("Port '", port, "' went away during the replay.");
+      return COMMAND_ERROR;
+    }
+    if (static_cast<size_t>(sent) != chunk.length) {
+      logger.fatal("Port '", port, "' stopped accepting data after ",
+                   bytes + sent, " bytes.");
+      return COMMAND_ERROR;
+    }
+    chunks++;
+    bytes += chunk.length;
+    context.progress(position - first, last - first);
+  }
+  double seconds =
+      std::chrono::duration<double>(Clock::now() - began).count();
+
+  if (chunks == 0 && !cancelled) {
+    logger.fatal(path, " has nothing to replay",
+                 start_ns > 0 ? " after the start time." : ".");
+    return COMMAND_ERROR;
+  }
+  char rate[64];
+  std::snprintf(rate, sizeof(rate), "%.3f s (%s%.1f KiB/s)", seconds,
+                max_speed ? "max speed, " : "", bytes / 1024.0 / seconds);
+  logger.info("Replayed ", chunks, " chunk(s), ", bytes, " bytes into '",
+              port, "' in ", rate, ".");
+  if (!max_speed && chunks > 0) {
+    LatencyHistogram::Snapshot late = lateness.snapshot();
+    logger.info("Timing: chunks went out late by p50 ",
+                duration(late.quantile(0.5)), ", p99 ",
+                duration(late.quantile(0.99)), ", max ",
+                duration(late.max_ns), ".");
+  }
+  if (cancelled) {
+    logger.warn(getName(), " cancelled.");
+    return COMMAND_CANCELLED;
+  }
+  return COMMAND_SUCCESS;
+}
+
+// Records what the port receives, chunk by chunk as it is read, in the
+// capture format replay plays back.
+int ReplayCommand::record(const std::string &port, const std::string &path,
+                          const opt_parser::ParsedOptions &options,
+                          CommandContext &context) {
+  extern Logger logger;
+
+  capture::Writer writer;
+  std::string error;
+  if (!writer.open(path, error)) {
+    logger.fatal("Cannot create ", path, ": ", error);
+    return COMMAND_ERROR;
+  }
+  bool bounded = options.has('d');
+  Clock::time_point deadline =
+      Clock::now() + options.duration('d', std::chrono::microseconds(0));
+  logger.info("Recording '", port, "' into ", path,
+              bounded ? "." : " until Ctrl+C.");
+
+  std::vector<uint8_t> buffer(RECORD_BUFFER);
+  bool gone = false;
+  while (!context.cancelled()) {
+    auto wait = CancellationToken::POLL;
+    if (bounded) {
+      Clock::time_point now = Clock::now();
+      if (now >= deadline) {
+        break;
+      }
+      wait = std::min(wait, std::chrono::duration_cast<
+                                std::chrono::milliseconds>(deadline - now));
+    }
+    long n = ports_.read(port, buffer.data(), buffer.size(), wait);
+    if (n < 0) {
+      gone = true;
+      break;
+    }
+    if (n > 0) {
+      writer.append(port, capture::RX, buffer.data(),
+                    static_cast<size_t>(n), steadyNs());
+    }
+  }
+
+  bool closed = writer.close(error);
+  capture::Writer::Stats stats = writer.stats();
+  if (!closed) {
+    logger.fatal("Recording into ", path, " failed: ", error);
+    return COMMAND_ERROR;
+  }
+  if (gone) {
+    logger.warn("Port '", port, "' went away; recording ends there.");
+  }
+  // Ctrl+C is the normal way to end an open-ended recording.
+  logger.success("Recorded ", stats.records, " chunk(s), ", stats.bytes,
+                 " bytes from '", port, "' into ", path, ".");
+  return COMMAND_SUCCESS;
+}
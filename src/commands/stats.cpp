@@ -0,0 +1,166 @@
+#include "../../include/commands/stats.hpp"
+#include "../../include/args_opt.hpp"
+#include "../../include/args_parser.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+#include "../../include/table_format.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+using table_fmt::duration;
+using table_fmt::row;
+using table_fmt::scaled;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'i', "interval", ArgumentOptions::REQ_ARG, ValueType::DURATION},
+    {'n', "count", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+});
+
+const std::chrono::milliseconds MIN_INTERVAL{100};
+
+} // namespace
+
+StatsCommand::StatsCommand(const PortManager &ports) : ports_(ports) {}
+
+std::string StatsCommand::getName() const { return "stats"; }
+std::string StatsCommand::getDescription() const {
+  return "Shows per-port rates and round-trip latency since the last call: "
+         "stats [-i <interval> [-n <count>]] [<port-glob>...]";
+}
+
+const opt_parser::OptionTable *StatsCommand::getOptions() const {
+  return &OPTIONS;
+}
+
+ArgumentKind StatsCommand::getArgumentKind() const {
+  return ArgumentKind::PORT;
+}
+
+int StatsCommand::run(const std::vector<std::string> &arguments,
+                      CommandContext &context) {
+  extern Logger logger;
+
+  opt_parser::ParsedOptions options = OPTIONS.parse(arguments);
+  if (!options.ok()) {
+    logger.fatal(getName(), ": ", options.errorMessage(), ".");
+    logger.fatal("Usage: ", getName(),
+                 " [-i <interval> [-n <count>]] [<port-glob>...]");
+    return COMMAND_ERROR;
+  }
+  auto interval = std::chrono::duration_cast<std::chrono::milliseconds>(
+      options.duration('i', std::chrono::milliseconds(0)));
+  bool refresh = options.has('i');
+  int64_t count = options.integer('n', refresh ? 0 : 1); // 0: until Ctrl+C
+  if ((refresh && interval < MIN_INTERVAL) || count < 0 ||
+      (options.has('n') && !refresh)) {
+    logger.fatal(getName(), ": the interval must be at least ",
+                 MIN_INTERVAL.count(), "ms and -n needs -i.");
+    return COMMAND_ERROR;
+  }
+  std::vector<std::string> patterns(
+      arguments.begin() + options.firstPositional(), arguments.end());
+
+  for (int64_t printed = 0; count == 0 || printed < count; printed++) {
+    if (printed > 0 && !context.token().waitFor(interval)) {
+      break; // Ctrl+C is the normal way out of a live view
+    }
+
+    std::vector<Sample> samples;
+    auto now = std::chrono::steady_clock::now();
+    for (const PortInfo &info : ports_.list()) {
+      bool wanted = patterns.empty();
+      for (const std::string &pattern : patterns) {
+        wanted = wanted || matchWildcard(pattern, info.name) ||
+                 matchWildcard(pattern, info.path);
+      }
+      std::shared_ptr<Port> port = ports_.find(info.name);
+      if (wanted && port) {
+        samples.push_back(Sample{now, info, port->round_trips.snapshot()});
+      }
+    }
+    if (samples.empty()) {
+      logger.fatal(patterns.empty() ? "No open ports."
+                                    : "No open port matches.");
+      return COMMAND_ERROR;
+    }
+
+    std::vector<std::vector<std::string>> traffic;
+    std::vector<std::vector<std::string>> latency;
+    traffic.push_back({"PORT", "RX", "TX", "RX FRAMES", "TX WRITES",
+                       "BAD FRAMES", "CRC ERRORS", "DROPPED",
+                       "RX QUEUE (PEAK)"});
+    latency.push_back({"PORT", "ROUND TRIPS", "P50", "P99", "P999", "MAX"});
+    double window = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (Sample &sample : samples) {
+        // Start from the previous sample of this very port, else from when
+        // it was opened.
+        const PortInfo &info = sample.info;
+        Sample base{info.opened, PortInfo(), LatencyHistogram::Snapshot()};
+        auto previous = last_.find(info.name);
+        if (previous != last_.end() &&
+            previous->second.info.opened == info.opened &&
+            previous->second.info.path == info.path) {
+          base = previous->second;
+        }
+        double seconds =
+            std::chrono::duration<double>(sample.time - base.time).count();
+        window = std::max(window, seconds);
+        seconds = std::max(seconds, 1e-3);
+        const PortInfo &was = base.info;
+        // Frame errors restart from zero when the framing changes.
+        uint64_t bad = info.frame_errors - std::min(info.frame_errors,
+                                                    was.frame_errors);
+        traffic.push_back(
+            {info.name, scaled((info.rx_bytes - was.rx_bytes) / seconds, "B/s"),
+             scaled((info.tx_bytes - was.tx_bytes) / seconds, "B/s"),
+             scaled((info.rx_frames - was.rx_frames) / seconds, "/s"),
+             scaled((info.tx_writes - was.tx_writes) / seconds, "/s"),
+             std::to_string(bad),
+             std::to_string(info.crc_errors - was.crc_errors),
+             std::to_string(info.rx_dropped - was.rx_dropped),
+             scaled(static_cast<double>(info.rx_buffered), "B") + " (" +
+                 scaled(static_cast<double>(info.rx_peak), "B") + ")"});
+
+        LatencyHistogram::Snapshot trips =
+            sample.round_trips.since(base.round_trips);
+        if (trips.total == 0) {
+          latency.push_back({info.name, "0", "-", "-", "-", "-"});
+        } else {
+          latency.push_back({info.name, std::to_string(trips.total),
+                             duration(trips.quantile(0.5)),
+                             duration(trips.quantile(0.99)),
+                             duration(trips.quantile(0.999)),
+                             duration(trips.max_ns)});
+        }
+        last_[info.name] = std::move(sample);
+      }
+    }
+
+    std::vector<size_t> widths(traffic[0].size(), 0);
+    for (const auto *table : {&traffic, &latency}) {
+      for (const auto &cells : *table) {
+        for (size_t i = 0; i < cells.size(); i++) {
+          widths[i] = std::max(widths[i], cells[i].length() + 2);
+        }
+      }
+    }
+    char window_text[32];
+    std::snprintf(window_text, sizeof(window_text), "%.2f", window);
+    logger.info("Port statistics over the last ", window_text, " s:");
+    for (const auto &cells : traffic) {
+      logger.info(row(cells, widths));
+    }
+    for (const auto &cells : latency) {
+      logger.info(row(cells, widths));
+    }
+  }
+  return COMMAND_SUCCESS;
+}
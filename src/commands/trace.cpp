@@ -0,0 +1,84 @@
+#include "../../include/commands/trace.hpp"
+#include "../../include/icommand.hpp"
+#include "../../include/logger.hpp"
+#include "../../include/trace.hpp"
+
+#include <string>
+
+TraceCommand::TraceCommand() {}
+
+std::string TraceCommand::getName() const { return "trace"; }
+std::string TraceCommand::getDescription() const {
+  return "Records parse, command and port I/O spans as a Chrome trace for "
+         "ui.perfetto.dev: trace start|stop [<file>]";
+}
+
+ArgumentKind TraceCommand::getArgumentKind() const {
+  return ArgumentKind::FILE;
+}
+
+int TraceCommand::execute(const std::vector<std::string> &arguments) {
+  extern Logger logger;
+
+  const std::string action = arguments.size() > 1 ? arguments[1] : "";
+  if (arguments.size() > 3 || (action != "start" && action != "stop" &&
+                               !(action.empty() && arguments.size() == 1))) {
+    logger.fatal("Usage: ", getName(), " start|stop [<file>]");
+    return COMMAND_ERROR;
+  }
+  const std::string path = arguments.size() == 3 ? arguments[2] : "";
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (action.empty()) {
+    if (running_) {
+      logger.info("Tracing since ",
+                  std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - started_)
+                      .count(),
+                  " s", path_.empty() ? "." : ", into " + path_ + ".");
+    } else {
+      logger.info("Not tracing.");
+    }
+    return COMMAND_SUCCESS;
+  }
+
+  if (action == "start") {
+    if (running_) {
+      logger.warn("Already tracing; restarting.");
+    }
+    path_ = path;
+    running_ = true;
+    started_ = std::chrono::steady_clock::now();
+    trace::start();
+    logger.success("Tracing started.");
+    return COMMAND_SUCCESS;
+  }
+
+  if (!running_) {
+    logger.fatal("Not tracing; run '", getName(), " start' first.");
+    return COMMAND_ERROR;
+  }
+  const std::string &file = path.empty() ? path_ : path;
+  if (file.empty()) {
+    logger.fatal("Usage: ", getName(), " stop <file>");
+    return COMMAND_ERROR; // still tracing; name a file
+  }
+  size_t events;
+  size_t dropped;
+  std::string error;
+  if (!trace::stop(file, events, dropped, error)) {
+    logger.fatal("Cannot write ", file, ": ", error);
+    // A file that cannot be created leaves the recording running.
+    running_ = trace::enabled();
+    if (running_) {
+      logger.info("Still tracing; stop again with another file.");
+    }
+    return COMMAND_ERROR;
+  }
+  running_ = false;
+  if (dropped > 0) {
+    logger.warn(dropped, " span(s) dropped: a thread filled its buffer.");
+  }
+  logger.success("Wrote ", events, " span(s) to ", file, ".");
+  return COMMAND_SUCCESS;
+}
@@ -0,0 +1,167 @@
+#include "../include/completer.hpp"
+#include "../include/args_opt.hpp"
+#include "../include/args_parser.hpp"
+#include "../include/command_registry.hpp"
+#include "../include/icommand.hpp"
+#include "../include/port_manager.hpp"
+#include "../include/serial_port.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include <dirent.h>
+
+namespace {
+
+const std::string_view DEV_DIR = "/dev/";
+const std::string_view PTS_DIR = "/dev/pts/";
+
+// Device name prefixes of USB CDC/serial adapters and on-board UARTs.
+const std::string_view SERIAL_PREFIXES[] = {
+    "ttyACM", "ttyUSB", "ttyAMA", "ttyS", "ttyTHS", "ttyGS", "rfcomm",
+};
+
+bool startsWith(std::string_view text, std::string_view prefix) {
+  return text.substr(0, prefix.size()) == prefix;
+}
+
+bool isSerialDevice(std::string_view name) {
+  for (std::string_view prefix : SERIAL_PREFIXES) {
+    if (startsWith(name, prefix) && name.size() > prefix.size()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool isNumber(std::string_view name) {
+  return !name.empty() &&
+         name.find_first_not_of("0123456789") == std::string_view::npos;
+}
+
+// The option a value is being typed for, e.g. "-b" or "--baud" just before
+// the cursor; nullptr if the previous word is not an option taking a value.
+const opt_parser::OptionSpec *
+pendingOption(const opt_parser::OptionTable &table, std::string_view previous) {
+  int index = opt_parser::OptionTable::NOT_FOUND;
+  if (startsWith(previous, "--")) {
+    if (previous.find('=') == std::string_view::npos) {
+      index = table.indexOf(previous.substr(2));
+    }
+  } else if (previous.size() >= 2 && previous[0] == '-') {
+    index = table.indexOf(previous.back()); // last flag of a bundle
+  }
+  if (index == opt_parser::OptionTable::NOT_FOUND ||
+      table[index].arg_option != opt_parser::ArgumentOptions::REQ_ARG) {
+    return nullptr;
+  }
+  return &table[index];
+}
+
+} // namespace
+
+Completer::Completer(const CommandRegistry &registry, const PortManager &ports)
+    : registry_(registry), ports_(ports) {}
+
+bool Completer::complete(std::string_view line, size_t start,
+                         std::vector<std::string> &matches) const {
+  std::string_view word = line.substr(std::min(start, line.size()));
+
+  CommandTokens before;
+  tokenizeCommandLine(line.substr(0, start), before);
+  if (before.empty()) {
+    registry_.getCommandNames().complete(word, matches);
+    return true;
+  }
+
+  const ICommand *command = registry_.findCommand(before[0]);
+  if (command == nullptr) {
+    return true;
+  }
+
+  const opt_parser::OptionTable *options = command->getOptions();
+  if (options != nullptr && before.size() >= 2) {
+    const opt_parser::OptionSpec *spec =
+        pendingOption(*options, before[before.size() - 1]);
+    if (spec != nullptr) {
+      if (spec->type == opt_parser::ValueType::BAUD) {
+        for (int rate : serial::supportedBauds()) {
+          std::string text = std::to_string(rate);
+          if (startsWith(text, word)) {
+            matches.push_back(std::move(text));
+          }
+        }
+      }
+      return true;
+    }
+  }
+
+  if (options != nullptr && startsWith(word, "-")) {
+    registry_.getOptionNames(before[0])->complete(word, matches);
+    return true;
+  }
+
+  switch (command->getArgumentKind()) {
+  case ArgumentKind::NONE:
+    return true;
+  case ArgumentKind::FILE:
+    return false;
+  case ArgumentKind::DEVICE:
+    return completeDevices(word, matches);
+  case ArgumentKind::PORT:
+    completePorts(word, matches);
+    return true;
+  case ArgumentKind::COMMAND:
+    registry_.getCommandNames().complete(word, matches);
+    return true;
+  }
+  return true;
+}
+
+bool Completer::completeDevices(std::string_view word,
+                                std::vector<std::string> &matches) const {
+  // Only paths under /dev/ (and /dev/pts/ for pty peers) are listed here;
+  // anything else, e.g. /dev/serial/by-id/..., is an ordinary file name.
+  std::string_view dir;
+  if (startsWith(DEV_DIR, word) ||
+      (startsWith(word, DEV_DIR) &&
+       word.find('/', DEV_DIR.size()) == std::string_view::npos)) {
+    dir = DEV_DIR;
+  } else if (startsWith(word, PTS_DIR) &&
+             word.find('/', PTS_DIR.size()) == std::string_view::npos) {
+    dir = PTS_DIR;
+  } else {
+    return false;
+  }
+
+  DIR *handle = ::opendir(std::string(dir).c_str());
+  if (handle == nullptr) {
+    return true;
+  }
+  while (const struct dirent *entry = ::readdir(handle)) {
+    std::string_view name = entry->d_name;
+    bool wanted = dir == DEV_DIR ? isSerialDevice(name) : isNumber(name);
+    if (!wanted) {
+      continue;
+    }
+    std::string path(dir);
+    path += name;
+    if (startsWith(path, word)) {
+      matches.push_back(std::move(path));
+    }
+  }
+  ::closedir(handle);
+
+  std::sort(matches.begin(), matches.end());
+  return true;
+}
+
+void Completer::completePorts(std::string_view word,
+                              std::vector<std::string> &matches) const {
+  for (const PortInfo &port : ports_.list()) {
+    if (startsWith(port.name, word)) {
+      matches.push_back(port.name);
+    }
+  }
+  std::sort(matches.begin(), matches.end());
+}
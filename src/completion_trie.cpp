@@ -0,0 +1,86 @@
+#include "../include/completion_trie.hpp"
+
+#include <algorithm>
+
+namespace {
+
+bool charLess(const std::pair<char, uint32_t> &entry, char c) {
+  return static_cast<unsigned char>(entry.first) <
+         static_cast<unsigned char>(c);
+}
+
+} // namespace
+
+CompletionTrie::CompletionTrie() : nodes_(1) {}
+
+uint32_t CompletionTrie::child(uint32_t node, char c) const {
+  const auto &children = nodes_[node].children;
+  auto it = std::lower_bound(children.begin(), children.end(), c, charLess);
+  if (it == children.end() || it->first != c) {
+    return NONE;
+  }
+  return it->second;
+}
+
+uint32_t CompletionTrie::find(std::string_view prefix) const {
+  uint32_t node = 0;
+  for (char c : prefix) {
+    node = child(node, c);
+    if (node == NONE) {
+      break;
+    }
+  }
+  return node;
+}
+
+void CompletionTrie::insert(std::string_view word) {
+  uint32_t node = 0;
+  for (char c : word) {
+    auto &children = nodes_[node].children;
+    auto it = std::lower_bound(children.begin(), children.end(), c, charLess);
+    if (it != children.end() && it->first == c) {
+      node = it->second;
+      continue;
+    }
+    uint32_t next = static_cast<uint32_t>(nodes_.size());
+    children.insert(it, std::make_pair(c, next));
+    nodes_.emplace_back(); // invalidates children, so done with it last
+    node = next;
+  }
+  if (!nodes_[node].terminal) {
+    nodes_[node].terminal = true;
+    words_++;
+  }
+}
+
+bool CompletionTrie::contains(std::string_view word) const {
+  uint32_t node = find(word);
+  return node != NONE && nodes_[node].terminal;
+}
+
+void CompletionTrie::complete(std::string_view prefix,
+                              std::vector<std::string> &out,
+                              size_t limit) const {
+  uint32_t node = find(prefix);
+  if (node == NONE) {
+    return;
+  }
+  std::string path(prefix);
+  collect(node, path, out, limit);
+}
+
+void CompletionTrie::collect(uint32_t node, std::string &path,
+                             std::vector<std::string> &out,
+                             size_t limit) const {
+  if (out.size() >= limit) {
+    return;
+  }
+  if (nodes_[node].terminal) {
+    out.push_back(path);
+  }
+  for (const auto &entry : nodes_[node].children) {
+    path.push_back(entry.first);
+    collect(entry.second, path, out, limit);
+    path.pop_back();
+  }
+}
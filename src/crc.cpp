@@ -0,0 +1,455 @@
+#include "../include/crc.hpp"
+
+#include <random>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CRC_X86 1
+#endif
+
+namespace crc {
+
+namespace {
+
+struct Params {
+  const char *name;
+  unsigned width;
+  uint32_t poly; // normal (MSB-first) form
+  uint32_t init;
+  uint32_t xorout;
+  bool reflected;
+  uint32_t check;
+};
+
+// Indexed by Algorithm.
+const Params PARAMS[ALGORITHM_COUNT] = {
+    {"ccitt", 16, 0x1021, 0xFFFF, 0x0000, false, 0x29B1},
+    {"modbus", 16, 0x8005, 0xFFFF, 0x0000, true, 0x4B37},
+    {"crc32", 32, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true, 0xCBF43926},
+    {"crc32c", 32, 0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF, true, 0xE3069283},
+};
+
+const Params &paramsOf(Algorithm algorithm) {
+  return PARAMS[static_cast<size_t>(algorithm)];
+}
+
+uint32_t maskOf(unsigned width) {
+  return width == 32 ? 0xFFFFFFFFu : (1u << width) - 1;
+}
+
+uint32_t reflect(uint32_t value, unsigned width) {
+  uint32_t result = 0;
+  for (unsigned i = 0; i < width; i++) {
+    if (value & (1u << i)) {
+      result |= 1u << (width - 1 - i);
+    }
+  }
+  return result;
+}
+
+// The reference implementation: one bit at a time. The state is the
+// register before the final xorout, in the algorithm's own bit order.
+uint32_t updateBitwise(const Params &p, uint32_t crc, const uint8_t *data,
+                       size_t len) {
+  if (p.reflected) {
+    uint32_t poly = reflect(p.poly, p.width);
+    for (size_t i = 0; i < len; i++) {
+      crc ^= data[i];
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+      }
+    }
+    return crc;
+  }
+
+  uint32_t top = 1u << (p.width - 1);
+  uint32_t mask = maskOf(p.width);
+  for (size_t i = 0; i < len; i++) {
+    crc ^= static_cast<uint32_t>(data[i]) << (p.width - 8);
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & top) ? (crc << 1) ^ p.poly : crc << 1;
+    }
+    crc &= mask;
+  }
+  return crc;
+}
+
+// table[k][b] is the CRC of byte b followed by k zero bytes, so eight table
+// lookups advance the register over eight input bytes at once.
+struct Slice8Tables {
+  uint32_t table[8][256];
+
+  explicit Slice8Tables(const Params &p) {
+    for (uint32_t b = 0; b < 256; b++) {
+      uint8_t byte = static_cast<uint8_t>(b);
+      table[0][b] = updateBitwise(p, 0, &byte, 1);
+    }
+    for (int k = 1; k < 8; k++) {
+      for (uint32_t b = 0; b < 256; b++) {
+        uint32_t prev = table[k - 1][b];
+        if (p.reflected) {
+          table[k][b] = (prev >> 8) ^ table[0][prev & 0xFF];
+        } else {
+          uint32_t top = (prev >> (p.width - 8)) & 0xFF;
+          table[k][b] = ((prev << 8) ^ table[0][top]) & maskOf(p.width);
+        }
+      }
+    }
+  }
+};
+
+const Slice8Tables TABLES[ALGORITHM_COUNT] = {
+    Slice8Tables(PARAMS[0]), Slice8Tables(PARAMS[1]), Slice8Tables(PARAMS[2]),
+    Slice8Tables(PARAMS[3])};
+
+uint32_t updateSlice8Reflected(const uint32_t (*t)[256], uint32_t crc,
+                               const uint8_t *p, size_t len) {
+  while (len >= 8) {
+    crc = t[7][(p[0] ^ crc) & 0xFF] ^ t[6][(p[1] ^ (crc >> 8)) & 0xFF] ^
+          t[5][(p[2] ^ (crc >> 16)) & 0xFF] ^
+          t[4][(p[3] ^ (crc >> 24)) & 0xFF] ^ t[3][p[4]] ^ t[2][p[5]] ^
+          t[1][p[6]] ^ t[0][p[7]];
+    p += 8;
+    len -= 8;
+  }
+  while (len-- > 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+  }
+  return crc;
+}
+
+uint32_t updateSlice8Normal(const uint32_t (*t)[256], unsigned width,
+                            uint32_t crc, const uint8_t *p, size_t len) {
+  uint32_t mask = maskOf(width);
+  while (len >= 8) {
+    uint32_t c = crc << (32 - width); // register MSB at bit 31
+    crc = t[7][p[0] ^ (c >> 24)] ^ t[6][(p[1] ^ (c >> 16)) & 0xFF] ^
+          t[5][(p[2] ^ (c >> 8)) & 0xFF] ^ t[4][(p[3] ^ c) & 0xFF] ^
+          t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    p += 8;
+    len -= 8;
+  }
+  while (len-- > 0) {
+    crc = ((crc << 8) ^ t[0][((crc >> (width - 8)) ^ *p++) & 0xFF]) & mask;
+  }
+  return crc;
+}
+
+uint32_t updateSlice8(Algorithm algorithm, uint32_t crc, const uint8_t *data,
+                      size_t len) {
+  const Params &p = paramsOf(algorithm);
+  const uint32_t(*t)[256] = TABLES[static_cast<size_t>(algorithm)].table;
+  return p.reflected ? updateSlice8Reflected(t, crc, data, len)
+                     : updateSlice8Normal(t, p.width, crc, data, len);
+}
+
+#if defined(CRC_X86)
+__attribute__((target("sse4.2"))) uint32_t
+updateCrc32cHardware(uint32_t crc, const uint8_t *p, size_t len) {
+  uint64_t state = crc;
+  while (len >= 8) {
+    uint64_t word;
+    __builtin_memcpy(&word, p, 8);
+    state = _mm_crc32_u64(state, word);
+    p += 8;
+    len -= 8;
+  }
+  crc = static_cast<uint32_t>(state);
+  while (len-- > 0) {
+    crc = _mm_crc32_u8(crc, *p++);
+  }
+  return crc;
+}
+
+__attribute__((target("pclmul,sse4.1"))) inline __m128i
+fold(__m128i acc, __m128i k, __m128i next) {
+  __m128i hi = _mm_clmulepi64_si128(acc, k, 0x11);
+  __m128i lo = _mm_clmulepi64_si128(acc, k, 0x00);
+  return _mm_xor_si128(_mm_xor_si128(hi, lo), next);
+}
+
+__attribute__((target("pclmul,sse4.1"))) inline __m128i
+load(const uint8_t *p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+// CRC-32 by carry-less multiplication folding ("Fast CRC Computation for
+// Generic Polynomials Using PCLMULQDQ", Intel 2009): four 128-bit lanes are
+// folded 64 bytes ahead, merged into one, then reduced to 32 bits with a
+// Barrett reduction. Needs len >= 64; handles len rounded down to 16 and
+// leaves the rest to the caller.
+__attribute__((target("pclmul,sse4.1"))) uint32_t
+updateCrc32Pclmul(uint32_t crc, const uint8_t *&p, size_t &len) {
+  const __m128i k1k2 = _mm_set_epi64x(0x1C6E41596, 0x154442BD4);
+  const __m128i k3k4 = _mm_set_epi64x(0x0CCAA009E, 0x1751997D0);
+  const __m128i k5 = _mm_set_epi64x(0, 0x163CD6124);
+  const __m128i poly_mu = _mm_set_epi64x(0x1F7011641, 0x1DB710641);
+  const __m128i mask32 = _mm_set_epi32(0, 0, 0, -1);
+
+  __m128i x1 =
+      _mm_xor_si128(load(p), _mm_cvtsi32_si128(static_cast<int>(crc)));
+  __m128i x2 = load(p + 16);
+  __m128i x3 = load(p + 32);
+  __m128i x4 = load(p + 48);
+  p += 64;
+  len -= 64;
+
+  while (len >= 64) {
+    x1 = fold(x1, k1k2, load(p));
+    x2 = fold(x2, k1k2, load(p + 16));
+    x3 = fold(x3, k1k2, load(p + 32));
+    x4 = fold(x4, k1k2, load(p + 48));
+    p += 64;
+    len -= 64;
+  }
+
+  x1 = fold(x1, k3k4, x2);
+  x1 = fold(x1, k3k4, x3);
+  x1 = fold(x1, k3k4, x4);
+  while (len >= 16) {
+    x1 = fold(x1, k3k4, load(p));
+    p += 16;
+    len -= 16;
+  }
+
+  // 128 -> 96 bits (which also appends the 32 zero bits the CRC needs),
+  // then 96 -> 64.
+  __m128i t = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), t);
+  t = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5, 0x00);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 4), t);
+
+  // Barrett reduction to the final 32-bit register.
+  t = x1;
+  x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly_mu, 0x10);
+  x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly_mu, 0x00);
+  x1 = _mm_xor_si128(x1, t);
+  return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+uint32_t updateCrc32Hardware(uint32_t crc, const uint8_t *p, size_t len) {
+  if (len >= 64) {
+    crc = updateCrc32Pclmul(crc, p, len);
+  }
+  const Slice8Tables &tables = TABLES[static_cast<size_t>(Algorithm::CRC32)];
+  return updateSlice8Reflected(tables.table, crc, p, len);
+}
+#endif
+
+bool hardwareSupports(Algorithm algorithm) {
+#if defined(CRC_X86)
+  switch (algorithm) {
+  case Algorithm::CRC32:
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+  case Algorithm::CRC32C:
+    return __builtin_cpu_supports("sse4.2");
+  case Algorithm::CRC16_CCITT:
+  case Algorithm::CRC16_MODBUS:
+    break;
+  }
+#else
+  (void)algorithm;
+#endif
+  return false;
+}
+
+bool supports(Engine engine) {
+  return engine != Engine::HARDWARE ||
+         hardwareSupports(Algorithm::CRC32) ||
+         hardwareSupports(Algorithm::CRC32C);
+}
+
+uint32_t update(Engine engine, Algorithm algorithm, uint32_t crc,
+                const uint8_t *data, size_t len) {
+  switch (engine) {
+  case Engine::BITWISE:
+    return updateBitwise(paramsOf(algorithm), crc, data, len);
+  case Engine::SLICE8:
+    return updateSlice8(algorithm, crc, data, len);
+  case Engine::HARDWARE:
+#if defined(CRC_X86)
+    if (algorithm == Algorithm::CRC32) {
+      return updateCrc32Hardware(crc, data, len);
+    }
+    if (algorithm == Algorithm::CRC32C) {
+      return updateCrc32cHardware(crc, data, len);
+    }
+#endif
+    break;
+  }
+  return updateSlice8(algorithm, crc, data, len);
+}
+
+Engine clampFor(Engine engine, Algorithm algorithm) {
+  if (engine == Engine::HARDWARE && !hardwareSupports(algorithm)) {
+    return Engine::SLICE8;
+  }
+  return engine;
+}
+
+Engine detectEngine() {
+  return supports(Engine::HARDWARE) ? Engine::HARDWARE : Engine::SLICE8;
+}
+
+const Engine best_engine = detectEngine();
+Engine active_engine = best_engine;
+// Per algorithm, so update() does not re-check CPU support on every call.
+Engine active_engines[ALGORITHM_COUNT] = {
+    clampFor(best_engine, Algorithm::CRC16_CCITT),
+    clampFor(best_engine, Algorithm::CRC16_MODBUS),
+    clampFor(best_engine, Algorithm::CRC32),
+    clampFor(best_engine, Algorithm::CRC32C)};
+
+uint32_t finish(const Params &p, uint32_t state) {
+  return (state ^ p.xorout) & maskOf(p.width);
+}
+
+} // namespace
+
+bool parseAlgorithm(std::string_view name, Algorithm &algorithm) {
+  for (size_t i = 0; i < ALGORITHM_COUNT; i++) {
+    if (name == PARAMS[i].name) {
+      algorithm = static_cast<Algorithm>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *algorithmName(Algorithm algorithm) {
+  return paramsOf(algorithm).name;
+}
+
+size_t checksumSize(Algorithm algorithm) {
+  return paramsOf(algorithm).width / 8;
+}
+
+uint32_t checkValue(Algorithm algorithm) { return paramsOf(algorithm).check; }
+
+Engine bestEngine() { return best_engine; }
+
+Engine engine() { return active_engine; }
+
+bool setEngine(Engine engine) {
+  if (!supports(engine)) {
+    return false;
+  }
+  active_engine = engine;
+  for (size_t i = 0; i < ALGORITHM_COUNT; i++) {
+    active_engines[i] = clampFor(engine, static_cast<Algorithm>(i));
+  }
+  return true;
+}
+
+Engine engineFor(Algorithm algorithm) {
+  return active_engines[static_cast<size_t>(algorithm)];
+}
+
+const char *engineName(Engine engine) {
+  switch (engine) {
+  case Engine::BITWISE:
+    return "bitwise";
+  case Engine::SLICE8:
+    return "slice8";
+  case Engine::HARDWARE:
+    return "hardware";
+  }
+  return "?";
+}
+
+Crc::Crc(Algorithm algorithm)
+    : algorithm_(algorithm), state_(paramsOf(algorithm).init) {}
+
+void Crc::update(const void *data, size_t len) {
+  state_ = crc::update(engineFor(algorithm_), algorithm_, state_,
+                       static_cast<const uint8_t *>(data), len);
+}
+
+uint32_t Crc::value() const { return finish(paramsOf(algorithm_), state_); }
+
+void Crc::reset() { state_ = paramsOf(algorithm_).init; }
+
+uint32_t compute(Algorithm algorithm, const void *data, size_t len) {
+  Crc crc(algorithm);
+  crc.update(data, len);
+  return crc.value();
+}
+
+bool verifyTrailer(Algorithm algorithm, const uint8_t *frame, size_t len) {
+  const Params &p = paramsOf(algorithm);
+  size_t size = p.width / 8;
+  if (len < size) {
+    return false;
+  }
+  size_t body = len - size;
+  uint32_t stored = 0;
+  for (size_t i = 0; i < size; i++) {
+    size_t shift = p.reflected ? i : size - 1 - i;
+    stored |= static_cast<uint32_t>(frame[body + i]) << (8 * shift);
+  }
+  return compute(algorithm, frame, body) == stored;
+}
+
+void appendTrailer(Algorithm algorithm, std::vector<uint8_t> &frame) {
+  const Params &p = paramsOf(algorithm);
+  size_t size = p.width / 8;
+  uint32_t value = compute(algorithm, frame.data(), frame.size());
+  for (size_t i = 0; i < size; i++) {
+    size_t shift = p.reflected ? i : size - 1 - i;
+    frame.push_back(static_cast<uint8_t>(value >> (8 * shift)));
+  }
+}
+
+bool selfTest(std::string &failure) {
+  static const char CHECK_INPUT[] = "123456789";
+  std::vector<uint8_t> random(4096 + 7);
+  std::mt19937 rng(1);
+  for (uint8_t &byte : random) {
+    byte = static_cast<uint8_t>(rng());
+  }
+
+  for (size_t i = 0; i < ALGORITHM_COUNT; i++) {
+    Algorithm algorithm = static_cast<Algorithm>(i);
+    const Params &p = PARAMS[i];
+    for (Engine candidate :
+         {Engine::BITWISE, Engine::SLICE8, Engine::HARDWARE}) {
+      if (clampFor(candidate, algorithm) != candidate) {
+        continue;
+      }
+      std::string where =
+          std::string(p.name) + " (" + engineName(candidate) + ")";
+
+      uint32_t check = finish(
+          p, update(candidate, algorithm, p.init,
+                    reinterpret_cast<const uint8_t *>(CHECK_INPUT), 9));
+      if (check != p.check) {
+        failure = where + ": wrong check value";
+        return false;
+      }
+
+      // Every length up to a few folds, at odd offsets, against the
+      // bitwise reference; also split in two to exercise streaming.
+      for (size_t len = 0; len <= 300; len++) {
+        const uint8_t *data = random.data() + (len % 7);
+        uint32_t expected = updateBitwise(p, p.init, data, len);
+        uint32_t whole = update(candidate, algorithm, p.init, data, len);
+        uint32_t split = update(candidate, algorithm,
+                                update(candidate, algorithm, p.init, data,
+                                       len / 3),
+                                data + len / 3, len - len / 3);
+        if (whole != expected || split != expected) {
+          failure = where + ": mismatch at length " + std::to_string(len);
+          return false;
+        }
+      }
+      if (update(candidate, algorithm, p.init, random.data(), 4096) !=
+          updateBitwise(p, p.init, random.data(), 4096)) {
+        failure = where + ": mismatch at length 4096";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace crc
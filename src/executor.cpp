@@ -0,0 +1,98 @@
+#include "../include/executor.hpp"
+#include "../include/trace.hpp"
+
+namespace {
+
+// The executor and queue index of the calling worker thread, if any.
+thread_local const Executor *current_executor = nullptr;
+thread_local size_t current_queue = 0;
+
+} // namespace
+
+Executor::Executor(size_t workers) {
+  if (workers == 0) {
+    workers = 1;
+  }
+  for (size_t i = 0; i < workers; i++) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  workers_.reserve(workers);
+  for (size_t i = 0; i < workers; i++) {
+    workers_.emplace_back(&Executor::workerLoop, this, i);
+  }
+}
+
+Executor::~Executor() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stopping_ = true;
+  }
+  sleep_cv_.notify_all();
+  for (std::thread &worker : workers_) {
+    worker.join();
+  }
+}
+
+void Executor::submit(std::function<void()> task) {
+  size_t index = current_executor == this
+                     ? current_queue
+                     : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                           queues_.size();
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+  queued_.fetch_add(1, std::memory_order_release);
+  {
+    // Pairs with the predicate check in workerLoop(): no lost wake-ups.
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+  }
+  sleep_cv_.notify_one();
+}
+
+bool Executor::popOwn(size_t self, std::function<void()> &task) {
+  Queue &queue = *queues_[self];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty()) {
+    return false;
+  }
+  task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  return true;
+}
+
+bool Executor::steal(size_t self, std::function<void()> &task) {
+  for (size_t offset = 1; offset < queues_.size(); offset++) {
+    Queue &victim = *queues_[(self + offset) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void Executor::workerLoop(size_t self) {
+  current_executor = this;
+  current_queue = self;
+  trace::nameThread("worker " + std::to_string(self));
+
+  std::function<void()> task;
+  while (true) {
+    if (popOwn(self, task) || steal(self, task)) {
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      task();
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.wait(lock, [this] {
+      return stopping_ || queued_.load(std::memory_order_acquire) > 0;
+    });
+    if (stopping_ && queued_.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+  }
+}
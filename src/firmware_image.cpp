@@ -0,0 +1,357 @@
+#include "../include/firmware_image.hpp"
+#include "../include/frame_decoder.hpp"
+#include "../include/hex_codec.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+// Smaller files are decoded on fewer threads; spawning is not free.
+const size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+bool hasSuffix(const std::string &path, const char *suffix) {
+  size_t len = std::char_traits<char>::length(suffix);
+  if (path.length() < len) {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++) {
+    char c = path[path.length() - len + i];
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
+    }
+    if (c != suffix[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A run of contiguous bytes collected while parsing.
+struct Run {
+  uint32_t address;
+  bool relative; // to the HEX upper address the chunk starts with
+  std::vector<uint8_t> bytes;
+};
+
+// One thread's share of a record file, cut at line boundaries.
+struct Chunk {
+  const uint8_t *begin = nullptr;
+  const uint8_t *end = nullptr;
+  std::vector<Run> runs;
+  size_t lines = 0;
+  bool sets_upper = false; // HEX: saw an extended address record
+  uint32_t upper = 0;      // HEX: the address the last one set
+  bool seen_end = false;   // HEX end-of-file or S-record termination
+  std::string error;       // for line number `lines`
+};
+
+void appendData(Chunk &chunk, uint32_t address, bool relative,
+                const uint8_t *data, size_t len) {
+  if (chunk.runs.empty() || chunk.runs.back().relative != relative ||
+      chunk.runs.back().address + chunk.runs.back().bytes.size() != address) {
+    chunk.runs.push_back(Run{address, relative, {}});
+  }
+  std::vector<uint8_t> &bytes = chunk.runs.back().bytes;
+  bytes.insert(bytes.end(), data, data + len);
+}
+
+// Calls record(text, last) for every non-blank line of the chunk, with
+// trailing CR and spaces stripped, until it returns false.
+template <typename RecordFn> void forEachLine(Chunk &chunk, RecordFn record) {
+  const uint8_t *p = chunk.begin;
+  while (p < chunk.end) {
+    chunk.lines++;
+    const uint8_t *eol = framing::findByte(p, chunk.end, '\n');
+    const uint8_t *last = eol;
+    while (last > p && (last[-1] == '\r' || last[-1] == ' ')) {
+      last--;
+    }
+    const uint8_t *text = p;
+    p = eol == chunk.end ? eol : eol + 1;
+    if (last != text && !record(text, last)) {
+      return;
+    }
+  }
+}
+
+// :LLAAAATT<data>CC; the bytes sum to zero.
+void parseIntelHexChunk(Chunk &chunk) {
+  uint8_t record[255 + 5];
+  forEachLine(chunk, [&](const uint8_t *text, const uint8_t *last) {
+    size_t digits = static_cast<size_t>(last - text) - 1;
+    if (text[0] != ':' || digits < 10 || digits % 2 != 0 ||
+        digits / 2 > sizeof(record)) {
+      chunk.error = "malformed record";
+      return false;
+    }
+    size_t count = digits / 2;
+    if (!hex_codec::decode(text + 1, count, record)) {
+      chunk.error = "bad hex digit";
+      return false;
+    }
+    uint8_t length = record[0];
+    if (count != length + 5u) {
+      chunk.error = "length mismatch";
+      return false;
+    }
+    uint8_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+      sum = static_cast<uint8_t>(sum + record[i]);
+    }
+    if (sum != 0) {
+      chunk.error = "checksum mismatch";
+      return false;
+    }
+
+    uint16_t offset = static_cast<uint16_t>(record[1] << 8 | record[2]);
+    const uint8_t *payload = record + 4;
+    switch (record[3]) {
+    case 0x00: // data
+      appendData(chunk, chunk.upper + offset, !chunk.sets_upper, payload,
+                 length);
+      return true;
+    case 0x01: // end of file
+      chunk.seen_end = true;
+      return false;
+    case 0x02: // extended segment address
+    case 0x04: // extended linear address
+      if (length != 2) {
+        chunk.error = "bad address record";
+        return false;
+      }
+      chunk.upper = static_cast<uint32_t>(payload[0] << 8 | payload[1]);
+      chunk.upper <<= record[3] == 0x02 ? 4 : 16;
+      chunk.sets_upper = true;
+      return true;
+    case 0x03: // start segment address
+    case 0x05: // start linear address
+      return true;
+    default:
+      chunk.error = "unknown record type";
+      return false;
+    }
+  });
+}
+
+// S<type><count><address><data><checksum>; count covers address, data and
+// checksum, and the bytes from count on sum to 0xFF.
+void parseSrecChunk(Chunk &chunk) {
+  uint8_t record[255 + 1];
+  forEachLine(chunk, [&](const uint8_t *text, const uint8_t *last) {
+    size_t digits = static_cast<size_t>(last - text) - 2;
+    if (last - text < 4 || text[0] != 'S' || digits % 2 != 0 ||
+        digits / 2 > sizeof(record)) {
+      chunk.error = "malformed record";
+      return false;
+    }
+    size_t count = digits / 2;
+    if (!hex_codec::decode(text + 2, count, record)) {
+      chunk.error = "bad hex digit";
+      return false;
+    }
+    if (count != record[0] + 1u) {
+      chunk.error = "length mismatch";
+      return false;
+    }
+    uint8_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+      sum = static_cast<uint8_t>(sum + record[i]);
+    }
+    if (sum != 0xFF) {
+      chunk.error = "checksum mismatch";
+      return false;
+    }
+
+    size_t address_size;
+    switch (text[1]) {
+    case '0': // header
+    case '5': // 16-bit record count
+    case '6': // 24-bit record count
+      return true;
+    case '1':
+      address_size = 2;
+      break;
+    case '2':
+      address_size = 3;
+      break;
+    case '3':
+      address_size = 4;
+      break;
+    case '7': // termination with 32-, 24- or 16-bit start address
+    case '8':
+    case '9':
+      chunk.seen_end = true;
+      return false;
+    default:
+      chunk.error = "unknown record type";
+      return false;
+    }
+    // count, address and checksum are not data.
+    if (count < address_size + 2) {
+      chunk.error = "length mismatch";
+      return false;
+    }
+    uint32_t address = 0;
+    for (size_t i = 0; i < address_size; i++) {
+      address = address << 8 | record[1 + i];
+    }
+    appendData(chunk, address, false, record + 1 + address_size,
+               count - address_size - 2);
+    return true;
+  });
+}
+
+} // namespace
+
+const char *imageFormatName(ImageFormat format) {
+  switch (format) {
+  case ImageFormat::BINARY:
+    return "binary";
+  case ImageFormat::INTEL_HEX:
+    return "intel-hex";
+  case ImageFormat::SREC:
+    return "srec";
+  }
+  return "?";
+}
+
+bool FirmwareImage::load(const std::string &path, uint32_t base_address,
+                         std::string &error, unsigned threads) {
+  segments_.clear();
+  storage_.clear();
+  if (!file_.open(path, error)) {
+    return false;
+  }
+
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  if (hasSuffix(path, ".hex") || hasSuffix(path, ".ihex")) {
+    format_ = ImageFormat::INTEL_HEX;
+    return parseRecords(threads, error);
+  }
+  for (const char *suffix : {".srec", ".s19", ".s28", ".s37", ".mot"}) {
+    if (hasSuffix(path, suffix)) {
+      format_ = ImageFormat::SREC;
+      return parseRecords(threads, error);
+    }
+  }
+
+  format_ = ImageFormat::BINARY;
+  if (file_.size() > UINT32_MAX - base_address) {
+    error = "image does not fit the 32-bit address space";
+    return false;
+  }
+  if (file_.size() > 0) {
+    segments_.push_back(Segment{base_address, file_.data(), file_.size()});
+  }
+  return true;
+}
+
+size_t FirmwareImage::size() const {
+  size_t total = 0;
+  for (const Segment &segment : segments_) {
+    total += segment.size;
+  }
+  return total;
+}
+
+bool FirmwareImage::parseRecords(unsigned threads, std::string &error) {
+  const uint8_t *data = file_.data();
+  const uint8_t *end = data + file_.size();
+
+  // Cut the file into roughly equal chunks, each ending after a newline.
+  size_t wanted = std::min<size_t>(threads, file_.size() / MIN_CHUNK_BYTES + 1);
+  std::vector<Chunk> chunks;
+  const uint8_t *begin = data;
+  for (size_t i = 1; i <= wanted && begin < end; i++) {
+    const uint8_t *cut = i == wanted ? end : data + file_.size() * i / wanted;
+    cut = framing::findByte(std::max(cut, begin), end, '\n');
+    if (cut != end) {
+      cut++;
+    }
+    chunks.emplace_back();
+    chunks.back().begin = begin;
+    chunks.back().end = cut;
+    begin = cut;
+  }
+
+  void (*parse)(Chunk &) = format_ == ImageFormat::INTEL_HEX
+                               ? parseIntelHexChunk
+                               : parseSrecChunk;
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < chunks.size(); i++) {
+    pool.emplace_back(parse, std::ref(chunks[i]));
+  }
+  if (!chunks.empty()) {
+    parse(chunks[0]);
+  }
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+
+  // Stitch the chunks back together in file order. Nothing after the end
+  // record counts, errors included.
+  std::vector<Run> runs;
+  uint32_t upper = 0;
+  size_t line = 0;
+  bool seen_end = false;
+  for (Chunk &chunk : chunks) {
+    if (!chunk.error.empty()) {
+      error = "line " + std::to_string(line + chunk.lines) + ": " +
+              chunk.error;
+      return false;
+    }
+    for (Run &run : chunk.runs) {
+      if (run.relative) {
+        run.address += upper;
+      }
+      runs.push_back(std::move(run));
+    }
+    if (chunk.sets_upper) {
+      upper = chunk.upper;
+    }
+    line += chunk.lines;
+    if (chunk.seen_end) {
+      seen_end = true;
+      break;
+    }
+  }
+  if (format_ == ImageFormat::INTEL_HEX && !seen_end) {
+    error = "missing end-of-file record";
+    return false;
+  }
+
+  // Records may come in any order: sort runs, join touching ones and
+  // reject overlaps.
+  std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) {
+    return a.address < b.address;
+  });
+  for (Run &run : runs) {
+    if (!storage_.empty()) {
+      Segment &prev = segments_.back();
+      uint64_t prev_end = static_cast<uint64_t>(prev.address) + prev.size;
+      if (prev_end > run.address) {
+        error = "overlapping data at " + std::to_string(run.address);
+        return false;
+      }
+      if (prev_end == run.address) {
+        std::vector<uint8_t> &bytes = storage_.back();
+        bytes.insert(bytes.end(), run.bytes.begin(), run.bytes.end());
+        prev.data = bytes.data();
+        prev.size = bytes.size();
+        continue;
+      }
+    }
+    storage_.push_back(std::move(run.bytes));
+    segments_.push_back(
+        Segment{run.address, storage_.back().data(), storage_.back().size()});
+  }
+  // storage_ may have reallocated; re-point every segment.
+  for (size_t i = 0; i < segments_.size(); i++) {
+    segments_[i].data = storage_[i].data();
+  }
+  file_.close(); // everything is decoded
+  return true;
+}
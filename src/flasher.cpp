@@ -0,0 +1,430 @@
+#include "../include/flasher.hpp"
+#include "../include/icommand.hpp"
+#include "../include/logger.hpp"
+
+#include <algorithm>
+
+using bootloader::Opcode;
+using bootloader::PacketReader;
+using bootloader::PacketWriter;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+std::chrono::milliseconds remaining(Clock::time_point deadline) {
+  auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - Clock::now());
+  return std::max(left, std::chrono::milliseconds(0));
+}
+
+struct Block {
+  uint32_t address;
+  const uint8_t *data;
+  uint16_t size;
+  Clock::time_point sent;
+  int tries = 0;
+  bool acked = false;
+};
+
+} // namespace
+
+namespace flash_opt {
+
+bool parse(const opt_parser::ParsedOptions &parsed, FlashOptions &options,
+           std::string &error) {
+  int64_t window = parsed.integer('w', 8);
+  int64_t block_size = parsed.integer('s', 0);
+  int64_t address = parsed.integer('a', 0);
+  int64_t retries = parsed.integer('r', 5);
+  auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+      parsed.duration('t', std::chrono::milliseconds(250)));
+  if (window < 1 || window > MAX_WINDOW || block_size < 0 ||
+      block_size > MAX_BLOCK_SIZE || address < 0 || address > 0xFFFFFFFF ||
+      retries < 0 || retries > MAX_RETRIES || timeout.count() <= 0) {
+    error = "window must be 1.." + std::to_string(MAX_WINDOW) +
+            ", block size 0.." + std::to_string(MAX_BLOCK_SIZE) +
+            " (0 = the device's), address 0..0xffffffff, retries 0.." +
+            std::to_string(MAX_RETRIES) + " and the timeout at least 1ms";
+    return false;
+  }
+  options.window = static_cast<size_t>(window);
+  options.block_size = static_cast<size_t>(block_size);
+  options.retries = static_cast<int>(retries);
+  options.ack_timeout = timeout;
+  return true;
+}
+
+int requestFailed(const CommandContext &context, const std::string &port,
+                  const char *what, const std::string &error) {
+  if (context.cancelled()) {
+    logger.warn("Cancelled; flash of '", port, "' may be incomplete.");
+    return COMMAND_CANCELLED;
+  }
+  logger.fatal(what, error);
+  return COMMAND_ERROR;
+}
+
+} // namespace flash_opt
+
+Flasher::Flasher(PortManager &ports, std::string port, FlashOptions options)
+    : ports_(ports), port_(std::move(port)), options_(options) {
+  handle_ = ports_.find(port_);
+  if (handle_) {
+    saved_framing_ = handle_->framing.load();
+  }
+  ports_.setFraming(port_, framing::Framing::COBS);
+  // Drop whatever the device said before we started talking.
+  ports_.readFrames(port_, [](const framing::FrameView &) {},
+                    std::chrono::milliseconds(0));
+}
+
+Flasher::~Flasher() { ports_.setFraming(port_, saved_framing_); }
+
+bool Flasher::send(PacketWriter &packet, std::string &error) {
+  wire_.clear();
+  packet.finish(wire_);
+  long sent = ports_.write(port_, wire_.data(), wire_.size());
+  if (sent < 0) {
+    error = "port '" + port_ + "' is gone";
+    return false;
+  }
+  if (static_cast<size_t>(sent) != wire_.size()) {
+    error = "transmit timed out";
+    return false;
+  }
+  return true;
+}
+
+bool Flasher::receive(const PortManager::FrameSink &sink,
+                      std::chrono::milliseconds timeout, std::string &error) {
+  if (options_.cancel != nullptr) {
+    if (options_.cancel->cancelled()) {
+      error = "cancelled";
+      return false;
+    }
+    timeout = std::min(timeout, CancellationToken::POLL);
+  }
+  if (ports_.readFrames(port_, sink, timeout) < 0) {
+    error = "port '" + port_ + "' is gone";
+    return false;
+  }
+  return true;
+}
+
+bool Flasher::transact(PacketWriter packet, Opcode expected,
+                       std::chrono::milliseconds timeout,
+                       std::vector<uint8_t> &reply, std::string &error) {
+  bool received = false;
+  auto sink = [&](const framing::FrameView &frame) {
+    PacketReader reader(frame.data, frame.size);
+    if (!reader.valid()) {
+      if (handle_) {
+        handle_->crc_errors.fetch_add(1, std::memory_order_relaxed);
+      }
+      return;
+    }
+    if (!received && reader.opcode() == expected) {
+      reply.assign(frame.data, frame.data + frame.size);
+      received = true;
+    }
+  };
+
+  for (int attempt = 0; attempt <= options_.retries; attempt++) {
+    if (!send(packet, error)) {
+      return false;
+    }
+    Clock::time_point sent = Clock::now();
+    auto deadline = sent + timeout;
+    while (!received && Clock::now() < deadline) {
+      if (!receive(sink, remaining(deadline), error)) {
+        return false;
+      }
+    }
+    if (received) {
+      if (handle_) {
+        handle_->round_trips.record(Clock::now() - sent);
+      }
+      return true;
+    }
+  }
+  error = "no answer from the bootloader";
+  return false;
+}
+
+bool Flasher::command(PacketWriter packet, std::chrono::milliseconds timeout,
+                      uint32_t *value, std::string &error) {
+  std::vector<uint8_t> reply;
+  if (!transact(std::move(packet), bootloader::RESULT, timeout, reply,
+                error)) {
+    return false;
+  }
+  PacketReader reader(reply.data(), reply.size());
+  uint8_t status = reader.u8();
+  if (status != bootloader::STATUS_OK) {
+    error = std::string("bootloader reports ") +
+            bootloader::statusName(status);
+    return false;
+  }
+  if (value != nullptr) {
+    *value = reader.u32();
+    if (reader.truncated()) {
+      error = "short reply from the bootloader";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Flasher::hello(bootloader::DeviceInfo &info, std::string &error) {
+  std::vector<uint8_t> reply;
+  if (!transact(PacketWriter(bootloader::HELLO), bootloader::INFO,
+                options_.ack_timeout, reply, error)) {
+    return false;
+  }
+  PacketReader reader(reply.data(), reply.size());
+  info.flash_base = reader.u32();
+  info.flash_size = reader.u32();
+  info.page_size = reader.u32();
+  info.max_block = reader.u16();
+  if (reader.truncated() || info.page_size == 0 || info.max_block == 0) {
+    error = "malformed INFO from the bootloader";
+    return false;
+  }
+  return true;
+}
+
+bool Flasher::erase(const std::vector<Segment> &segments,
+                    const bootloader::DeviceInfo &info, std::string &error) {
+  uint64_t flash_end = static_cast<uint64_t>(info.flash_base) + info.flash_size;
+  uint32_t page = info.page_size;
+
+  // Segments are sorted, so touched pages come out in order.
+  std::vector<std::pair<uint32_t, uint32_t>> ranges; // [start, end)
+  for (const Segment &segment : segments) {
+    if (segment.address < info.flash_base || segment.end() > flash_end) {
+      error = "image does not fit the device's flash";
+      return false;
+    }
+    uint32_t start =
+        segment.address - (segment.address - info.flash_base) % page;
+    uint32_t end = segment.end();
+    uint32_t tail = (end - info.flash_base) % page;
+    if (tail != 0) {
+      end += page - tail;
+    }
+    if (!ranges.empty() && ranges.back().second >= start) {
+      ranges.back().second = std::max(ranges.back().second, end);
+    } else {
+      ranges.emplace_back(start, end);
+    }
+  }
+
+  for (const auto &range : ranges) {
+    PacketWriter packet(bootloader::ERASE);
+    packet.u32(range.first).u32(range.second - range.first);
+    if (!command(std::move(packet), options_.erase_timeout, nullptr, error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Flasher::write(const std::vector<Segment> &segments,
+                    const bootloader::DeviceInfo &info,
+                    const Progress &progress, FlashStats &stats,
+                    std::string &error) {
+  size_t block_size = info.max_block;
+  if (options_.block_size != 0) {
+    block_size = std::min(block_size, options_.block_size);
+  }
+  size_t window = std::max<size_t>(1, options_.window);
+
+  std::vector<Block> blocks;
+  size_t total = 0;
+  for (const Segment &segment : segments) {
+    for (size_t offset = 0; offset < segment.size; offset += block_size) {
+      Block block;
+      block.address = segment.address + static_cast<uint32_t>(offset);
+      block.data = segment.data + offset;
+      block.size =
+          static_cast<uint16_t>(std::min(block_size, segment.size - offset));
+      blocks.push_back(block);
+    }
+    total += segment.size;
+  }
+
+  auto sendBlock = [&](size_t index) {
+    Block &block = blocks[index];
+    PacketWriter packet(bootloader::WRITE);
+    packet.u16(static_cast<uint16_t>(index)).u32(block.address);
+    packet.bytes(block.data, block.size);
+    block.sent = Clock::now();
+    block.tries++;
+    return send(packet, error);
+  };
+
+  size_t base = 0; // oldest unacknowledged block
+  size_t next = 0; // next block never sent
+  size_t done = 0; // bytes acknowledged
+  std::vector<size_t> nacked;
+  bool failed = false;
+  // Send time of the most recently sent block that has been acknowledged.
+  // The link delivers in order, so an unacknowledged block sent before it
+  // was lost and need not wait for its timeout.
+  Clock::time_point newest_acked = Clock::time_point::min();
+
+  // Sequence numbers are block indices mod 2^16; the window is far smaller,
+  // so a sequence maps back to exactly one block in flight.
+  auto sink = [&](const framing::FrameView &frame) {
+    PacketReader reader(frame.data, frame.size);
+    if (!reader.valid()) {
+      if (handle_) {
+        handle_->crc_errors.fetch_add(1, std::memory_order_relaxed);
+      }
+      return;
+    }
+    if (reader.opcode() != bootloader::ACK &&
+        reader.opcode() != bootloader::NAK) {
+      return;
+    }
+    uint16_t seq = reader.u16();
+    size_t index =
+        base + static_cast<uint16_t>(seq - static_cast<uint16_t>(base));
+    if (reader.truncated() || index >= next || blocks[index].acked) {
+      return; // stale or duplicate
+    }
+    if (reader.opcode() == bootloader::ACK) {
+      if (handle_) {
+        handle_->round_trips.record(Clock::now() - blocks[index].sent);
+      }
+      blocks[index].acked = true;
+      newest_acked = std::max(newest_acked, blocks[index].sent);
+      done += blocks[index].size;
+      stats.blocks++;
+      return;
+    }
+    uint8_t status = reader.u8();
+    stats.naks++;
+    if (status == bootloader::STATUS_OUT_OF_RANGE ||
+        status == bootloader::STATUS_NOT_ERASED) {
+      error = std::string("bootloader rejected block at ") +
+              std::to_string(blocks[index].address) + ": " +
+              bootloader::statusName(status);
+      failed = true;
+      return;
+    }
+    nacked.push_back(index);
+  };
+
+  auto retry = [&](size_t index) {
+    if (blocks[index].tries > options_.retries) {
+      error = "block at " + std::to_string(blocks[index].address) +
+              " failed after " + std::to_string(blocks[index].tries) +
+              " attempts";
+      return false;
+    }
+    stats.retransmits++;
+    return sendBlock(index);
+  };
+
+  size_t reported = 0;
+  while (base < blocks.size()) {
+    while (next < blocks.size() && next - base < window) {
+      if (!sendBlock(next++)) {
+        return false;
+      }
+    }
+
+    // Sleep until an ACK arrives or the oldest outstanding block expires.
+    Clock::time_point expiry = Clock::now() + options_.ack_timeout;
+    for (size_t i = base; i < next; i++) {
+      if (!blocks[i].acked) {
+        expiry = std::min(expiry, blocks[i].sent + options_.ack_timeout);
+      }
+    }
+    if (!receive(sink, remaining(expiry), error)) {
+      return false;
+    }
+    if (failed) {
+      return false;
+    }
+
+    for (size_t index : nacked) {
+      if (!blocks[index].acked && !retry(index)) {
+        return false;
+      }
+    }
+    nacked.clear();
+
+    Clock::time_point now = Clock::now();
+    for (size_t i = base; i < next; i++) {
+      if (blocks[i].acked) {
+        continue;
+      }
+      bool expired = blocks[i].sent + options_.ack_timeout <= now;
+      if (expired) {
+        stats.timeouts++;
+      }
+      if ((expired || blocks[i].sent < newest_acked) && !retry(i)) {
+        return false;
+      }
+    }
+
+    while (base < next && blocks[base].acked) {
+      base++;
+    }
+    if (progress && done != reported) {
+      reported = done;
+      progress(done, total);
+    }
+  }
+  stats.bytes += total;
+  return true;
+}
+
+bool Flasher::checksum(uint32_t address, uint32_t length, uint32_t &crc,
+                       std::string &error) {
+  PacketWriter packet(bootloader::VERIFY);
+  packet.u32(address).u32(length);
+  return command(std::move(packet), options_.verify_timeout, &crc, error);
+}
+
+bool Flasher::pageHashes(uint32_t address, uint32_t count,
+                         const bootloader::DeviceInfo &info,
+                         std::vector<uint32_t> &hashes, std::string &error) {
+  hashes.clear();
+  hashes.reserve(count);
+  std::vector<uint8_t> reply;
+  while (count > 0) {
+    uint16_t batch = static_cast<uint16_t>(
+        std::min<uint32_t>(count, bootloader::MAX_HASH_PAGES));
+    PacketWriter packet(bootloader::HASH);
+    packet.u32(address).u16(batch);
+    if (!transact(std::move(packet), bootloader::RESULT,
+                  options_.verify_timeout, reply, error)) {
+      return false;
+    }
+    PacketReader reader(reply.data(), reply.size());
+    uint8_t status = reader.u8();
+    if (status != bootloader::STATUS_OK) {
+      error = std::string("bootloader reports ") +
+              bootloader::statusName(status);
+      return false;
+    }
+    for (uint16_t i = 0; i < batch; i++) {
+      hashes.push_back(reader.u32());
+    }
+    if (reader.truncated()) {
+      error = "short reply from the bootloader";
+      return false;
+    }
+    address += batch * info.page_size;
+    count -= batch;
+  }
+  return true;
+}
+
+bool Flasher::boot(std::string &error) {
+  return command(PacketWriter(bootloader::BOOT), options_.ack_timeout, nullptr,
+                 error);
+}
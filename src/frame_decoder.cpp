@@ -0,0 +1,326 @@
+#include "../include/frame_decoder.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FRAMING_X86 1
+#endif
+
+namespace framing {
+
+namespace {
+
+const uint8_t SLIP_END = 0xC0;
+const uint8_t SLIP_ESC = 0xDB;
+const uint8_t SLIP_ESC_END = 0xDC;
+const uint8_t SLIP_ESC_ESC = 0xDD;
+
+using FindFn = const uint8_t *(*)(const uint8_t *, const uint8_t *, uint8_t);
+
+const uint8_t *findByteScalar(const uint8_t *p, const uint8_t *end,
+                              uint8_t value) {
+  while (p < end && *p != value) {
+    ++p;
+  }
+  return p;
+}
+
+#if defined(FRAMING_X86) && defined(__SSE2__)
+const uint8_t *findByteSse2(const uint8_t *p, const uint8_t *end,
+                            uint8_t value) {
+  const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+  while (end - p >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+    if (mask != 0) {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 16;
+  }
+  return findByteScalar(p, end, value);
+}
+
+__attribute__((target("avx2"))) const uint8_t *
+findByteAvx2(const uint8_t *p, const uint8_t *end, uint8_t value) {
+  const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+  while (end - p >= 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    unsigned mask = static_cast<unsigned>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return findByteSse2(p, end, value);
+}
+#endif
+
+bool supports(ScanLevel level) {
+  switch (level) {
+  case ScanLevel::SCALAR:
+    return true;
+#if defined(FRAMING_X86) && defined(__SSE2__)
+  case ScanLevel::SSE2:
+    return true;
+  case ScanLevel::AVX2:
+    return __builtin_cpu_supports("avx2");
+#else
+  case ScanLevel::SSE2:
+  case ScanLevel::AVX2:
+    return false;
+#endif
+  }
+  return false;
+}
+
+FindFn functionFor(ScanLevel level) {
+  switch (level) {
+#if defined(FRAMING_X86) && defined(__SSE2__)
+  case ScanLevel::SSE2:
+    return findByteSse2;
+  case ScanLevel::AVX2:
+    return findByteAvx2;
+#endif
+  default:
+    return findByteScalar;
+  }
+}
+
+ScanLevel detectScanLevel() {
+  if (supports(ScanLevel::AVX2)) {
+    return ScanLevel::AVX2;
+  }
+  if (supports(ScanLevel::SSE2)) {
+    return ScanLevel::SSE2;
+  }
+  return ScanLevel::SCALAR;
+}
+
+const ScanLevel best_level = detectScanLevel();
+ScanLevel active_level = best_level;
+FindFn active_find = functionFor(best_level);
+
+} // namespace
+
+bool parseFraming(std::string_view name, Framing &framing) {
+  for (Framing candidate :
+       {Framing::RAW, Framing::LINE, Framing::COBS, Framing::SLIP}) {
+    if (name == framingName(candidate)) {
+      framing = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *framingName(Framing framing) {
+  switch (framing) {
+  case Framing::RAW:
+    return "raw";
+  case Framing::LINE:
+    return "newline";
+  case Framing::COBS:
+    return "cobs";
+  case Framing::SLIP:
+    return "slip";
+  }
+  return "?";
+}
+
+ScanLevel bestScanLevel() { return best_level; }
+
+ScanLevel scanLevel() { return active_level; }
+
+bool setScanLevel(ScanLevel level) {
+  if (!supports(level)) {
+    return false;
+  }
+  active_level = level;
+  active_find = functionFor(level);
+  return true;
+}
+
+const char *scanLevelName(ScanLevel level) {
+  switch (level) {
+  case ScanLevel::SCALAR:
+    return "scalar";
+  case ScanLevel::SSE2:
+    return "sse2";
+  case ScanLevel::AVX2:
+    return "avx2";
+  }
+  return "?";
+}
+
+const uint8_t *findByte(const uint8_t *begin, const uint8_t *end,
+                        uint8_t value) {
+  return active_find(begin, end, value);
+}
+
+size_t cobsDecode(uint8_t *data, size_t len) {
+  // The output never overtakes the input, so decoding in place is safe.
+  size_t in = 0;
+  size_t out = 0;
+  while (in < len) {
+    uint8_t code = data[in++];
+    if (code == 0) {
+      return SIZE_MAX;
+    }
+    size_t run = code - 1u;
+    if (run > len - in) {
+      return SIZE_MAX;
+    }
+    std::memmove(data + out, data + in, run);
+    in += run;
+    out += run;
+    if (code != 0xFF && in < len) {
+      data[out++] = 0;
+    }
+  }
+  return out;
+}
+
+void cobsEncode(const uint8_t *data, size_t len, std::vector<uint8_t> &out) {
+  size_t code_at = out.size();
+  out.push_back(0); // placeholder for the first code byte
+  uint8_t code = 1;
+  for (size_t i = 0; i < len; i++) {
+    if (data[i] != 0) {
+      out.push_back(data[i]);
+      code++;
+    }
+    if (data[i] == 0 || code == 0xFF) {
+      out[code_at] = code;
+      code_at = out.size();
+      out.push_back(0);
+      code = 1;
+    }
+  }
+  out[code_at] = code;
+  out.push_back(0); // frame delimiter
+}
+
+size_t slipDecode(uint8_t *data, size_t len) {
+  const uint8_t *end = data + len;
+  const uint8_t *in = findByte(data, end, SLIP_ESC);
+  uint8_t *out = data + (in - data); // nothing moves before the first escape
+  while (in != end) {
+    if (++in == end) {
+      return SIZE_MAX;
+    }
+    if (*in == SLIP_ESC_END) {
+      *out++ = SLIP_END;
+    } else if (*in == SLIP_ESC_ESC) {
+      *out++ = SLIP_ESC;
+    } else {
+      return SIZE_MAX;
+    }
+    // Shift the plain run up to the next escape down in one go.
+    const uint8_t *run = ++in;
+    in = findByte(run, end, SLIP_ESC);
+    std::memmove(out, run, static_cast<size_t>(in - run));
+    out += in - run;
+  }
+  return static_cast<size_t>(out - data);
+}
+
+void slipEncode(const uint8_t *data, size_t len, std::vector<uint8_t> &out) {
+  out.push_back(SLIP_END);
+  for (size_t i = 0; i < len; i++) {
+    if (data[i] == SLIP_END) {
+      out.push_back(SLIP_ESC);
+      out.push_back(SLIP_ESC_END);
+    } else if (data[i] == SLIP_ESC) {
+      out.push_back(SLIP_ESC);
+      out.push_back(SLIP_ESC_ESC);
+    } else {
+      out.push_back(data[i]);
+    }
+  }
+  out.push_back(SLIP_END);
+}
+
+FrameDecoder::FrameDecoder(Framing framing, size_t max_frame)
+    : framing_(framing), max_frame_(max_frame) {
+  switch (framing) {
+  case Framing::COBS:
+    delimiter_ = 0x00;
+    break;
+  case Framing::SLIP:
+    delimiter_ = SLIP_END;
+    break;
+  default:
+    delimiter_ = '\n';
+    break;
+  }
+}
+
+void FrameDecoder::reset() {
+  partial_.clear();
+  discarding_ = false;
+}
+
+void FrameDecoder::keepPartial(const uint8_t *data, size_t len) {
+  if (discarding_) {
+    return;
+  }
+  if (partial_.size() + len > max_frame_) {
+    overruns_++;
+    partial_.clear();
+    discarding_ = true; // until the next delimiter
+    return;
+  }
+  partial_.insert(partial_.end(), data, data + len);
+}
+
+bool FrameDecoder::finishFrame(uint8_t *data, size_t len, FrameView &frame) {
+  if (discarding_) {
+    discarding_ = false; // the oversized frame ends here
+    return false;
+  }
+
+  uint8_t *start = data;
+  if (!partial_.empty()) {
+    if (partial_.size() + len > max_frame_) {
+      overruns_++;
+      return false;
+    }
+    partial_.insert(partial_.end(), data, data + len);
+    start = partial_.data();
+    len = partial_.size();
+  } else if (len > max_frame_) {
+    overruns_++;
+    return false;
+  }
+
+  switch (framing_) {
+  case Framing::LINE:
+    if (len > 0 && start[len - 1] == '\r') {
+      len--;
+    }
+    break;
+  case Framing::COBS:
+    len = cobsDecode(start, len);
+    break;
+  case Framing::SLIP:
+    len = slipDecode(start, len);
+    break;
+  case Framing::RAW:
+    break;
+  }
+
+  if (len == SIZE_MAX) {
+    errors_++;
+    return false;
+  }
+  if (len == 0 && framing_ != Framing::LINE) {
+    return false; // back-to-back delimiters
+  }
+  frames_++;
+  frame = FrameView{start, len};
+  return true;
+}
+
+} // namespace framing
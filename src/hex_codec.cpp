@@ -0,0 +1,200 @@
+#include "../include/hex_codec.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEX_CODEC_X86 1
+#endif
+
+namespace hex_codec {
+
+namespace {
+
+using DecodeFn = bool (*)(const uint8_t *, size_t, uint8_t *);
+
+// 0..15 for a hex digit, 0xFF for anything else.
+struct DigitTable {
+  uint8_t value[256];
+
+  constexpr DigitTable() : value() {
+    for (int c = 0; c < 256; c++) {
+      value[c] = 0xFF;
+    }
+    for (int c = '0'; c <= '9'; c++) {
+      value[c] = static_cast<uint8_t>(c - '0');
+    }
+    for (int c = 'a'; c <= 'f'; c++) {
+      value[c] = static_cast<uint8_t>(c - 'a' + 10);
+      value[c - 'a' + 'A'] = static_cast<uint8_t>(c - 'a' + 10);
+    }
+  }
+};
+
+constexpr DigitTable DIGITS;
+
+bool decodeScalar(const uint8_t *text, size_t bytes, uint8_t *out) {
+  uint8_t bad = 0;
+  for (size_t i = 0; i < bytes; i++) {
+    uint8_t hi = DIGITS.value[text[2 * i]];
+    uint8_t lo = DIGITS.value[text[2 * i + 1]];
+    bad |= static_cast<uint8_t>(hi | lo);
+    out[i] = static_cast<uint8_t>(hi << 4 | lo);
+  }
+  return (bad & 0xF0) == 0;
+}
+
+#if defined(HEX_CODEC_X86) && defined(__SSE2__)
+// Maps 16 characters to their digit values; valid gets a 0xFF lane for
+// every hex digit. ASCII bytes compare correctly as signed, and bytes of
+// 0x80 and up are negative, so they fail both range checks.
+inline __m128i digitsSse2(__m128i chars, __m128i &valid) {
+  __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+  __m128i is_digit =
+      _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                    _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+  __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+  __m128i alpha = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+  __m128i is_alpha =
+      _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                    _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+  valid = _mm_or_si128(is_digit, is_alpha);
+  return _mm_or_si128(_mm_and_si128(is_digit, digit),
+                      _mm_and_si128(is_alpha, alpha));
+}
+
+// Each 16-bit lane holds the high nibble in its low byte and the low
+// nibble in its high byte; folds them into one byte per lane.
+inline __m128i joinNibblesSse2(__m128i values) {
+  __m128i joined =
+      _mm_or_si128(_mm_slli_epi16(values, 4), _mm_srli_epi16(values, 8));
+  return _mm_and_si128(joined, _mm_set1_epi16(0x00FF));
+}
+
+bool decodeSse2(const uint8_t *text, size_t bytes, uint8_t *out) {
+  while (bytes >= 8) {
+    __m128i valid;
+    __m128i values = digitsSse2(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(text)), valid);
+    if (_mm_movemask_epi8(valid) != 0xFFFF) {
+      return false;
+    }
+    __m128i joined = joinNibblesSse2(values);
+    __m128i packed = _mm_packus_epi16(joined, joined);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out), packed);
+    text += 16;
+    out += 8;
+    bytes -= 8;
+  }
+  return decodeScalar(text, bytes, out);
+}
+
+__attribute__((target("avx2"))) bool decodeAvx2(const uint8_t *text,
+                                                size_t bytes, uint8_t *out) {
+  while (bytes >= 16) {
+    __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text));
+    __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    __m256i is_digit =
+        _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+    __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+    __m256i alpha = _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10));
+    __m256i is_alpha =
+        _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+    __m256i valid = _mm256_or_si256(is_digit, is_alpha);
+    if (static_cast<unsigned>(_mm256_movemask_epi8(valid)) != 0xFFFFFFFFu) {
+      return false;
+    }
+    __m256i values = _mm256_or_si256(_mm256_and_si256(is_digit, digit),
+                                     _mm256_and_si256(is_alpha, alpha));
+    // maddubs folds each byte pair into hi * 16 + lo in one step.
+    __m256i joined = _mm256_maddubs_epi16(values, _mm256_set1_epi16(0x0110));
+    // packus works per 128-bit lane; gather the two low quadwords.
+    __m256i packed = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(joined, joined), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                     _mm256_castsi256_si128(packed));
+    text += 32;
+    out += 16;
+    bytes -= 16;
+  }
+  return decodeSse2(text, bytes, out);
+}
+#endif
+
+bool supports(DecodeLevel level) {
+  switch (level) {
+  case DecodeLevel::SCALAR:
+    return true;
+#if defined(HEX_CODEC_X86) && defined(__SSE2__)
+  case DecodeLevel::SSE2:
+    return true;
+  case DecodeLevel::AVX2:
+    return __builtin_cpu_supports("avx2");
+#else
+  case DecodeLevel::SSE2:
+  case DecodeLevel::AVX2:
+    return false;
+#endif
+  }
+  return false;
+}
+
+DecodeFn functionFor(DecodeLevel level) {
+  switch (level) {
+#if defined(HEX_CODEC_X86) && defined(__SSE2__)
+  case DecodeLevel::SSE2:
+    return decodeSse2;
+  case DecodeLevel::AVX2:
+    return decodeAvx2;
+#endif
+  default:
+    return decodeScalar;
+  }
+}
+
+DecodeLevel detectDecodeLevel() {
+  if (supports(DecodeLevel::AVX2)) {
+    return DecodeLevel::AVX2;
+  }
+  if (supports(DecodeLevel::SSE2)) {
+    return DecodeLevel::SSE2;
+  }
+  return DecodeLevel::SCALAR;
+}
+
+const DecodeLevel best_level = detectDecodeLevel();
+DecodeLevel active_level = best_level;
+DecodeFn active_decode = functionFor(best_level);
+
+} // namespace
+
+DecodeLevel bestDecodeLevel() { return best_level; }
+
+DecodeLevel decodeLevel() { return active_level; }
+
+bool setDecodeLevel(DecodeLevel level) {
+  if (!supports(level)) {
+    return false;
+  }
+  active_level = level;
+  active_decode = functionFor(level);
+  return true;
+}
+
+const char *decodeLevelName(DecodeLevel level) {
+  switch (level) {
+  case DecodeLevel::SCALAR:
+    return "scalar";
+  case DecodeLevel::SSE2:
+    return "sse2";
+  case DecodeLevel::AVX2:
+    return "avx2";
+  }
+  return "?";
+}
+
+bool decode(const uint8_t *text, size_t bytes, uint8_t *out) {
+  return active_decode(text, bytes, out);
+}
+
+} // namespace hex_codec
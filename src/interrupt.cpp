@@ -0,0 +1,97 @@
+#include "../include/interrupt.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace interrupt {
+
+namespace {
+
+int signal_pipe[2] = {-1, -1};
+
+std::mutex mutex; // guards everything below
+CancellationToken *foreground = nullptr;
+IdleHandler idle_handler;
+
+void onSigint(int) {
+  int saved_errno = errno;
+  char byte = 0;
+  if (::write(signal_pipe[1], &byte, 1) < 0) {
+    // Pipe full: the watcher has plenty to do already
+  }
+  errno = saved_errno;
+}
+
+void watch() {
+  char byte;
+  while (true) {
+    ssize_t n = ::read(signal_pipe[0], &byte, 1);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return;
+    }
+    IdleHandler idle;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (foreground != nullptr) {
+        foreground->cancel();
+        continue;
+      }
+      idle = idle_handler;
+    }
+    // Outside the lock: the handler may start or end a Foreground scope.
+    if (idle) {
+      idle();
+    }
+  }
+}
+
+} // namespace
+
+bool install(IdleHandler idle) {
+  setIdleHandler(std::move(idle));
+  if (signal_pipe[0] >= 0) {
+    return true;
+  }
+  if (::pipe2(signal_pipe, O_CLOEXEC) != 0) {
+    return false;
+  }
+  ::fcntl(signal_pipe[1], F_SETFL, O_NONBLOCK);
+  std::thread(watch).detach();
+
+  struct sigaction action = {};
+  action.sa_handler = onSigint;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  return ::sigaction(SIGINT, &action, nullptr) == 0;
+}
+
+void setIdleHandler(IdleHandler idle) {
+  std::lock_guard<std::mutex> lock(mutex);
+  idle_handler = std::move(idle);
+}
+
+void terminate() {
+  ::signal(SIGINT, SIG_DFL);
+  ::raise(SIGINT);
+}
+
+Foreground::Foreground(CancellationToken &token) {
+  std::lock_guard<std::mutex> lock(mutex);
+  previous_ = foreground;
+  foreground = &token;
+}
+
+Foreground::~Foreground() {
+  std::lock_guard<std::mutex> lock(mutex);
+  foreground = previous_;
+}
+
+} // namespace interrupt
@@ -0,0 +1,244 @@
+#include "../include/job_manager.hpp"
+#include "../include/command_registry.hpp"
+#include "../include/icommand.hpp"
+#include "../include/logger.hpp"
+
+#include <exception>
+#include <iterator>
+
+extern Logger logger;
+
+const char *jobStateName(JobState state) {
+  switch (state) {
+  case JobState::QUEUED:
+    return "queued";
+  case JobState::RUNNING:
+    return "running";
+  case JobState::DONE:
+    return "done";
+  case JobState::FAILED:
+    return "failed";
+  case JobState::KILLED:
+    return "killed";
+  }
+  return "?";
+}
+
+JobManager::JobManager(CommandRegistry &registry, size_t workers)
+    : registry_(registry), executor_(workers) {}
+
+JobManager::~JobManager() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  size_t running = 0;
+  for (auto &entry : jobs_) {
+    Job &job = *entry.second;
+    if (job.info.state == JobState::RUNNING) {
+      running++;
+    }
+    if (job.info.state == JobState::QUEUED ||
+        job.info.state == JobState::RUNNING) {
+      cancelLocked(job);
+    }
+  }
+  // Cancelled jobs report themselves killed as they return; one that
+  // cannot be cancelled still has to finish.
+  if (running > 0) {
+    logger.info("Stopping ", running, " background job(s)...");
+  }
+  finished_cv_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+bool JobManager::takeBackgroundMarker(std::string &line) {
+  size_t last = line.find_last_not_of(" \t\r\n");
+  if (last == std::string::npos || line[last] != '&') {
+    return false;
+  }
+  line.erase(last);
+  size_t end = line.find_last_not_of(" \t");
+  line.erase(end == std::string::npos ? 0 : end + 1);
+  line.erase(0, line.find_first_not_of(" \t"));
+  return true;
+}
+
+bool JobManager::parseJobId(const std::string &text, int &id) {
+  size_t first = !text.empty() && text[0] == '%' ? 1 : 0;
+  if (first == text.size() || text.size() - first > 9 ||
+      text.find_first_not_of("0123456789", first) != std::string::npos) {
+    return false;
+  }
+  id = std::stoi(text.substr(first));
+  return id > 0;
+}
+
+int JobManager::start(std::vector<std::string> arguments,
+                      const std::string &line) {
+  auto job = std::make_shared<Job>();
+  job->arguments = std::move(arguments);
+  job->info.line = line;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job->info.id = next_id_++;
+    jobs_[job->info.id] = job;
+    unfinished_++;
+  }
+  executor_.submit([this, job] { run(job); });
+  return job->info.id;
+}
+
+void JobManager::run(const std::shared_ptr<Job> &job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (job->info.state != JobState::QUEUED) {
+      return; // killed before it started
+    }
+    job->info.state = JobState::RUNNING;
+    job->started = Clock::now();
+  }
+
+  Job *progress = job.get();
+  CommandContext context(job->token, [progress](uint64_t done,
+                                                uint64_t total) {
+    progress->total.store(total, std::memory_order_relaxed);
+    progress->done.store(done, std::memory_order_relaxed);
+  });
+  context.setJobId(job->info.id);
+  int result;
+  try {
+    result = registry_.executeCommand(job->arguments, context);
+  } catch (const std::exception &e) {
+    logger.fatal("Error in job [", job->info.id, "]: ", e.what());
+    result = COMMAND_ERROR;
+  }
+
+  double seconds =
+      std::chrono::duration<double>(Clock::now() - job->started).count();
+  // Live views such as `stats -i` end normally when cancelled; a job that
+  // was asked to stop was still killed.
+  bool killed = result == COMMAND_CANCELLED ||
+                (result == COMMAND_SUCCESS && job->token.cancelled());
+  bool ok = !killed && (result == COMMAND_SUCCESS ||
+                        result == COMMAND_EXIT_REQUESTED);
+  if (ok) {
+    logger.success("[", job->info.id, "] done (", seconds,
+                   " s): ", job->info.line);
+  } else if (killed) {
+    logger.warn("[", job->info.id, "] killed (", seconds,
+                " s): ", job->info.line);
+  } else {
+    logger.fatal("[", job->info.id, "] failed with ", result, " (", seconds,
+                 " s): ", job->info.line);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  job->info.state = ok       ? JobState::DONE
+                    : killed ? JobState::KILLED
+                             : JobState::FAILED;
+  job->info.result = result;
+  job->info.seconds = seconds;
+  all_succeeded_ = all_succeeded_ && ok;
+  unfinished_--;
+  finished_cv_.notify_all();
+}
+
+// Caller holds mutex_.
+JobInfo JobManager::snapshot(const Job &job) const {
+  JobInfo info = job.info;
+  info.done = job.done.load(std::memory_order_relaxed);
+  info.total = job.total.load(std::memory_order_relaxed);
+  if (info.state == JobState::RUNNING) {
+    info.seconds =
+        std::chrono::duration<double>(Clock::now() - job.started).count();
+  }
+  return info;
+}
+
+std::vector<JobInfo> JobManager::list() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<JobInfo> infos;
+  for (auto it = jobs_.begin(); it != jobs_.end();) {
+    infos.push_back(snapshot(*it->second));
+    JobState state = it->second->info.state;
+    if (state == JobState::QUEUED || state == JobState::RUNNING) {
+      ++it;
+    } else {
+      it = jobs_.erase(it);
+    }
+  }
+  return infos;
+}
+
+bool JobManager::wait(int id, int self, const CancellationToken &cancel,
+                      JobInfo &info) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = jobs_.end();
+  if (id == 0) {
+    for (auto newest = jobs_.rbegin(); newest != jobs_.rend(); ++newest) {
+      if (newest->first != self) {
+        it = std::prev(newest.base());
+        break;
+      }
+    }
+  } else if (id != self) {
+    it = jobs_.find(id);
+  }
+  if (it == jobs_.end()) {
+    return false;
+  }
+  std::shared_ptr<Job> job = it->second;
+  auto finished = [&job] {
+    return job->info.state != JobState::QUEUED &&
+           job->info.state != JobState::RUNNING;
+  };
+  while (!finished()) {
+    if (cancel.cancelled()) {
+      // Don't wait for the job to wind down: it may be another waiter,
+      // and a running job announces its own outcome.
+      cancelLocked(*job);
+      info = snapshot(*job);
+      if (finished()) {
+        jobs_.erase(job->info.id);
+      }
+      return true;
+    }
+    finished_cv_.wait_for(lock, CancellationToken::POLL);
+  }
+  info = snapshot(*job);
+  jobs_.erase(job->info.id);
+  return true;
+}
+
+bool JobManager::kill(int id, std::string &error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = jobs_.find(id);
+  if (it == jobs_.end()) {
+    error = "no job [" + std::to_string(id) + "]";
+    return false;
+  }
+  Job &job = *it->second;
+  if (job.info.state != JobState::QUEUED &&
+      job.info.state != JobState::RUNNING) {
+    error = "job [" + std::to_string(id) + "] has already finished";
+    return false;
+  }
+  cancelLocked(job);
+  return true;
+}
+
+// Caller holds mutex_.
+void JobManager::cancelLocked(Job &job) {
+  if (job.info.state == JobState::QUEUED) {
+    job.info.state = JobState::KILLED;
+    unfinished_--;
+    finished_cv_.notify_all();
+  } else {
+    job.token.cancel(); // run() records the outcome
+  }
+}
+
+bool JobManager::waitAll() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  finished_cv_.wait(lock, [this] { return unfinished_ == 0; });
+  bool ok = all_succeeded_;
+  all_succeeded_ = true;
+  return ok;
+}
@@ -0,0 +1,60 @@
+#include "../include/latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+uint64_t LatencyHistogram::bucketFloor(size_t bucket) {
+  size_t sub = size_t{1} << SUB_BITS;
+  if (bucket < 2 * sub) {
+    return bucket;
+  }
+  size_t shift = (bucket >> SUB_BITS) - 1;
+  uint64_t mantissa = sub + (bucket & (sub - 1));
+  return mantissa << shift;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+  Snapshot snap;
+  for (size_t i = 0; i < BUCKETS; i++) {
+    snap.counts[i] = counts_[i].load(std::memory_order_relaxed);
+    snap.total += snap.counts[i];
+  }
+  snap.max_ns = max_ns_.load(std::memory_order_relaxed);
+  return snap;
+}
+
+uint64_t LatencyHistogram::Snapshot::quantile(double q) const {
+  if (total == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(std::ceil(q * total));
+  rank = std::min(std::max<uint64_t>(rank, 1), total);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKETS; i++) {
+    seen += counts[i];
+    if (seen >= rank) {
+      uint64_t low = bucketFloor(i);
+      uint64_t high = i + 1 < BUCKETS ? bucketFloor(i + 1) : low;
+      return std::min(low + (high - low) / 2, std::max(max_ns, low));
+    }
+  }
+  return max_ns;
+}
+
+LatencyHistogram::Snapshot
+LatencyHistogram::Snapshot::since(const Snapshot &earlier) const {
+  Snapshot delta;
+  size_t top = 0;
+  for (size_t i = 0; i < BUCKETS; i++) {
+    // Buckets only grow; a racing snapshot never makes this negative.
+    delta.counts[i] = counts[i] - std::min(counts[i], earlier.counts[i]);
+    delta.total += delta.counts[i];
+    if (delta.counts[i] != 0) {
+      top = i;
+    }
+  }
+  // The exact maximum is only known overall; bound it by the top bucket.
+  uint64_t top_end = top + 1 < BUCKETS ? bucketFloor(top + 1) - 1 : max_ns;
+  delta.max_ns = delta.total == 0 ? 0 : std::min(max_ns, top_end);
+  return delta;
+}
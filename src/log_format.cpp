@@ -0,0 +1,155 @@
+#include "../include/log_format.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace log_fmt {
+
+namespace {
+
+const char DIGIT_PAIRS[] = "00010203040506070809"
+                           "10111213141516171819"
+                           "20212223242526272829"
+                           "30313233343536373839"
+                           "40414243444546474849"
+                           "50515253545556575859"
+                           "60616263646566676869"
+                           "70717273747576777879"
+                           "80818283848586878889"
+                           "90919293949596979899";
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+const size_t HEXDUMP_WIDTH = 16;
+
+// Writes value right-aligned ending at end; returns the first digit.
+char *formatUnsigned(uint64_t value, char *end) {
+  char *p = end;
+  while (value >= 100) {
+    unsigned pair = static_cast<unsigned>(value % 100) * 2;
+    value /= 100;
+    *--p = DIGIT_PAIRS[pair + 1];
+    *--p = DIGIT_PAIRS[pair];
+  }
+  if (value >= 10) {
+    unsigned pair = static_cast<unsigned>(value) * 2;
+    *--p = DIGIT_PAIRS[pair + 1];
+    *--p = DIGIT_PAIRS[pair];
+  } else {
+    *--p = static_cast<char>('0' + value);
+  }
+  return p;
+}
+
+thread_local FormatBuffer thread_buffer;
+thread_local bool thread_buffer_busy = false;
+
+} // namespace
+
+void FormatBuffer::append(const char *text) {
+  if (text == nullptr) {
+    data_.append("(null)");
+    return;
+  }
+  data_.append(text, std::strlen(text));
+}
+
+void FormatBuffer::appendUnsigned(uint64_t value) {
+  char digits[24];
+  char *end = digits + sizeof(digits);
+  char *start = formatUnsigned(value, end);
+  data_.append(start, static_cast<size_t>(end - start));
+}
+
+void FormatBuffer::appendSigned(int64_t value) {
+  if (value < 0) {
+    data_.push_back('-');
+    // Negate in unsigned space so INT64_MIN does not overflow.
+    appendUnsigned(0 - static_cast<uint64_t>(value));
+  } else {
+    appendUnsigned(static_cast<uint64_t>(value));
+  }
+}
+
+void FormatBuffer::appendDouble(double value) {
+  // Same rendering as an ostream with default flags (%g, 6 digits).
+  char text[32];
+  int len = std::snprintf(text, sizeof(text), "%g", value);
+  if (len > 0) {
+    data_.append(text, static_cast<size_t>(len));
+  }
+}
+
+void FormatBuffer::appendHex(uint64_t value, int width) {
+  char digits[16];
+  int count = 0;
+  do {
+    digits[count++] = HEX_DIGITS[value & 0xF];
+    value >>= 4;
+  } while (value != 0);
+
+  data_.append("0x", 2);
+  for (int i = count; i < width && i < 16; i++) {
+    data_.push_back('0');
+  }
+  while (count > 0) {
+    data_.push_back(digits[--count]);
+  }
+}
+
+void FormatBuffer::appendHexDump(const uint8_t *data, size_t len) {
+  for (size_t offset = 0; offset < len; offset += HEXDUMP_WIDTH) {
+    if (offset > 0) {
+      data_.push_back('\n');
+    }
+
+    // Offset column: 8 hex digits.
+    for (int shift = 28; shift >= 0; shift -= 4) {
+      data_.push_back(HEX_DIGITS[(offset >> shift) & 0xF]);
+    }
+    data_.append("  ", 2);
+
+    size_t line = len - offset < HEXDUMP_WIDTH ? len - offset : HEXDUMP_WIDTH;
+    for (size_t i = 0; i < HEXDUMP_WIDTH; i++) {
+      if (i < line) {
+        uint8_t byte = data[offset + i];
+        data_.push_back(HEX_DIGITS[byte >> 4]);
+        data_.push_back(HEX_DIGITS[byte & 0xF]);
+        data_.push_back(' ');
+      } else {
+        data_.append("   ", 3);
+      }
+      if (i == 7) {
+        data_.push_back(' ');
+      }
+    }
+
+    data_.append(" |", 2);
+    for (size_t i = 0; i < line; i++) {
+      uint8_t byte = data[offset + i];
+      data_.push_back((byte >= 0x20 && byte < 0x7F) ? static_cast<char>(byte)
+                                                    : '.');
+    }
+    data_.push_back('|');
+  }
+}
+
+BufferLease::BufferLease() {
+  owns_thread_buffer_ = !thread_buffer_busy;
+  if (owns_thread_buffer_) {
+    thread_buffer_busy = true;
+    buffer_ = &thread_buffer;
+  } else {
+    nested_.reset(new FormatBuffer());
+    buffer_ = nested_.get();
+  }
+  buffer_->clear();
+}
+
+BufferLease::~BufferLease() {
+  if (owns_thread_buffer_) {
+    thread_buffer_busy = false;
+  }
+}
+
+} // namespace log_fmt
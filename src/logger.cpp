@@ -1,59 +1,323 @@
 #include "../include/logger.hpp" // Include the header where declarations are
 #include "../include/theme.hpp"  // Need colors for implementation too
-#include <string>                // For std::string usage
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string> // For std::string usage
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Provide the implementation for non-template methods
 // Use ClassName:: to specify the method belongs to the Logger class
 Logger logger;
 
+namespace {
+
+const size_t BATCH_RESERVE = 64 * 1024;
+
+void writeAll(int fd, const char *data, size_t len) {
+  while (len > 0) {
+    ssize_t n = ::write(fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    data += n;
+    len -= static_cast<size_t>(n);
+  }
+}
+
+} // namespace
+
+std::string defaultLogDirectory() {
+  const char *home = std::getenv("HOME");
+  if (home == nullptr || *home == '\0') {
+    return "";
+  }
+  return std::string(home) + "/uconnux";
+}
+
 Logger::Logger(std::ostream &stream, LogLevel level, bool prefix)
     : output_stream(stream), min_level(level), show_prefix(prefix) {
-  // Constructor body (if needed, empty here)
+  writer = std::thread(&Logger::writerLoop, this);
 }
 
-void Logger::setMinLevel(LogLevel level) {
-  std::lock_guard<std::mutex> lock(log_mutex);
-  min_level = level;
+Logger::~Logger() {
+  {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    stopping = true;
+    writer_cv.notify_one();
+  }
+  if (writer.joinable()) {
+    writer.join();
+  }
+  disableFileSink();
 }
 
-void Logger::enablePrefix(bool enable) {
-  std::lock_guard<std::mutex> lock(log_mutex);
-  show_prefix = enable;
+void Logger::setMinLevel(LogLevel level) { min_level = level; }
+
+void Logger::enablePrefix(bool enable) { show_prefix = enable; }
+
+void Logger::enableColor(bool enable) { show_color = enable; }
+
+bool Logger::enableFileSink(const std::string &directory) {
+  if (directory.empty()) {
+    return false;
+  }
+  if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    return false;
+  }
+
+  std::string path = directory + "/uconnux.log";
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                  0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  size_t size = (::fstat(fd, &st) == 0) ? static_cast<size_t>(st.st_size) : 0;
+
+  std::lock_guard<std::mutex> lock(sink_mutex);
+  if (file_fd >= 0) {
+    ::close(file_fd);
+  }
+  file_fd = fd;
+  file_path = path;
+  file_size = size;
+  return true;
 }
 
+void Logger::disableFileSink() {
+  std::lock_guard<std::mutex> lock(sink_mutex);
+  if (file_fd >= 0) {
+    ::close(file_fd);
+    file_fd = -1;
+  }
+}
 
-std::string Logger::setColor(LogLevel level) const {
+void Logger::flush() {
+  size_t target = queue.claimed();
+  std::unique_lock<std::mutex> lock(writer_mutex);
+  writer_cv.notify_one();
+  flushed_cv.wait(lock, [this, target]() {
+    return written.load(std::memory_order_acquire) >= target || stopping;
+  });
+}
+
+void Logger::holdConsole(std::function<void()> notify) {
+  std::lock_guard<std::mutex> lock(console_mutex);
+  console_held = true;
+  console_notify = std::move(notify);
+}
+
+void Logger::takeHeldConsole(std::string &text) {
+  std::lock_guard<std::mutex> lock(console_mutex);
+  text.swap(held_console);
+  held_console.clear();
+}
+
+void Logger::releaseConsole() {
+  std::lock_guard<std::mutex> lock(console_mutex);
+  if (!held_console.empty()) {
+    output_stream.write(held_console.data(),
+                        static_cast<std::streamsize>(held_console.size()));
+    output_stream.flush();
+    held_console.clear();
+  }
+  console_held = false;
+  console_notify = nullptr;
+}
+
+void Logger::submit(LogLevel level, const char *text, size_t length) {
+  LogRecord *record;
+  size_t ticket;
+  while (!queue.tryClaim(&record, &ticket)) {
+    // Queue full: let the writer catch up rather than dropping lines.
+    writer_cv.notify_one();
+    std::this_thread::yield();
+  }
+
+  record->level = level;
+  record->time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+  record->length = static_cast<uint32_t>(length);
+  if (length <= LogRecord::INLINE_SIZE) {
+    std::memcpy(record->text, text, length);
+    record->overflow = nullptr;
+  } else {
+    record->overflow = new std::string(text, length);
+  }
+  queue.publish(ticket);
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (writer_sleeping.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    writer_cv.notify_one();
+  }
+}
+
+void Logger::writerLoop() {
+  std::string console;
+  std::string file;
+  console.reserve(BATCH_RESERVE);
+  file.reserve(BATCH_RESERVE);
+
+  time_t stamp_second = 0;
+  char stamp[32] = {0};
+
+  while (true) {
+    size_t batch = 0;
+    bool prefix = show_prefix.load(std::memory_order_relaxed);
+    bool color = show_color.load(std::memory_order_relaxed);
+    bool to_file;
+    {
+      std::lock_guard<std::mutex> lock(sink_mutex);
+      to_file = file_fd >= 0;
+    }
+
+    LogRecord *record;
+    while (batch < QUEUE_SIZE && (record = queue.front()) != nullptr) {
+      const char *text = record->overflow ? record->overflow->data()
+                                          : record->text;
+
+      if (color) {
+        console += setColor(record->level);
+      }
+      if (prefix) {
+        console += "▐ ";
+      }
+      console.append(text, record->length);
+      console += '\n';
+
+      if (to_file) {
+        time_t second = static_cast<time_t>(record->time_ns / 1000000000);
+        if (second != stamp_second) {
+          struct tm tm_buf;
+          localtime_r(&second, &tm_buf);
+          std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm_buf);
+          stamp_second = second;
+        }
+        char millis[8];
+        std::snprintf(millis, sizeof(millis), ".%03d ",
+                      static_cast<int>((record->time_ns / 1000000) % 1000));
+        file += stamp;
+        file += millis;
+        file += levelToString(record->level);
+        file += ' ';
+        file.append(text, record->length);
+        file += '\n';
+      }
+
+      delete record->overflow;
+      queue.pop();
+      batch++;
+    }
+
+    if (batch > 0) {
+      writeBatch(console, file);
+      std::lock_guard<std::mutex> lock(writer_mutex);
+      written.fetch_add(batch, std::memory_order_release);
+      flushed_cv.notify_all();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(writer_mutex);
+    if (stopping) {
+      break;
+    }
+    writer_sleeping = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (queue.front() == nullptr) {
+      writer_cv.wait(lock);
+    }
+    writer_sleeping = false;
+  }
+}
+
+void Logger::writeBatch(std::string &console, std::string &file) {
+  if (!console.empty()) {
+    std::lock_guard<std::mutex> lock(console_mutex);
+    if (console_held) {
+      held_console += console;
+      if (console_notify) {
+        console_notify();
+      }
+    } else {
+      output_stream.write(console.data(),
+                          static_cast<std::streamsize>(console.size()));
+      output_stream.flush();
+    }
+    console.clear();
+  }
+
+  if (!file.empty()) {
+    std::lock_guard<std::mutex> lock(sink_mutex);
+    if (file_fd >= 0) {
+      writeAll(file_fd, file.data(), file.size());
+      file_size += file.size();
+      if (file_size >= FILE_SINK_MAX_BYTES) {
+        rotateFileSink();
+      }
+    }
+    file.clear();
+  }
+}
+
+// Caller holds sink_mutex.
+void Logger::rotateFileSink() {
+  ::close(file_fd);
+  for (int i = FILE_SINK_BACKUPS - 1; i >= 1; i--) {
+    std::string from = file_path + "." + std::to_string(i);
+    std::string to = file_path + "." + std::to_string(i + 1);
+    ::rename(from.c_str(), to.c_str());
+  }
+  ::rename(file_path.c_str(), (file_path + ".1").c_str());
+
+  file_fd = ::open(file_path.c_str(),
+                   O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+  file_size = 0;
+}
+
+const char *Logger::setColor(LogLevel level) const {
   using namespace term_style;
   switch (level) {
   case LogLevel::INFO:
-    return std::string(THEME_INFO_LABEL);
+    return THEME_INFO_LABEL;
   case LogLevel::SUCCESS:
-    return std::string(THEME_SUCCESS);
+    return THEME_SUCCESS;
   case LogLevel::WARNING:
-    return std::string(THEME_WARNING);
+    return THEME_WARNING;
   case LogLevel::FATAL:
-    return std::string(THEME_ERROR);
+    return THEME_ERROR;
   case LogLevel::DEBUG:
-    return std::string(DIM);
+    return DIM;
   default:
-    return std::string(RESET);
+    return RESET;
   }
 }
 
-// Implementation of the private helper
-std::string Logger::levelToString(LogLevel level) const {
-  using namespace term_style;
+// Implementation of the private helper; plain labels for the file sink
+const char *Logger::levelToString(LogLevel level) const {
   switch (level) {
   case LogLevel::INFO:
-    return "[INFO] " + std::string(RESET);
+    return "[INFO]";
   case LogLevel::SUCCESS:
-    return "[SUCCESS] " + std::string(RESET);
+    return "[SUCCESS]";
   case LogLevel::WARNING:
-    return "[WARN] " + std::string(RESET);
+    return "[WARN]";
   case LogLevel::FATAL:
-    return "[FATAL]" + std::string(RESET);
+    return "[FATAL]";
   case LogLevel::DEBUG:
-    return "[DEBUG]" + std::string(RESET);
+    return "[DEBUG]";
   default:
     return "[?????]";
   }
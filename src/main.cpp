@@ -1,73 +1,239 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
-#include <map> // For completion iterator
+#include <memory>
 #include <readline/history.h>
 #include <readline/readline.h>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h> // For isatty
 #include <vector>
 
+#include <fcntl.h>
+#include <poll.h>
+
 // --- Your Core Includes ---
 #include "../include/args_parser.hpp" // Keeping for now, see notes
+#include "../include/batch_runner.hpp" // Headless -c/script/pipe mode
 #include "../include/logger.hpp"
 #include "../include/theme.hpp"
+#include "../include/trace.hpp"
 
 // --- Command System Includes ---
 #include "../include/command_registry.hpp" // Our new registry header
+#include "../include/completer.hpp"        // Tab completion
 #include "../include/icommand.hpp"         // Defines ICommand and status codes
+#include "../include/interrupt.hpp"        // Ctrl+C cancels the foreground
+#include "../include/job_manager.hpp"      // Background jobs (`cmd &`)
+#include "../include/port_manager.hpp"     // Owns every open serial port
 
 // --- Concrete Command Includes ---
 #include "../include/commands/add.hpp"   // Assuming path
+#include "../include/commands/bench.hpp"
+#include "../include/commands/broadcast.hpp"
+#include "../include/commands/capture.hpp"
+#include "../include/commands/cgrep.hpp"
 #include "../include/commands/clear.hpp" // Assuming path
+#include "../include/commands/close.hpp"
+#include "../include/commands/crc.hpp"
+#include "../include/commands/dflash.hpp"
 #include "../include/commands/exit.hpp"  // Assuming path
+#include "../include/commands/fg.hpp"
+#include "../include/commands/flash.hpp"
 #include "../include/commands/help.hpp"  // The new help command
+#include "../include/commands/hexinfo.hpp"
+#include "../include/commands/jobs.hpp"
+#include "../include/commands/kill.hpp"
+#include "../include/commands/open.hpp"
+#include "../include/commands/ports.hpp"
+#include "../include/commands/replay.hpp"
+#include "../include/commands/stats.hpp"
+#include "../include/commands/trace.hpp"
 
 // --- Logger Declaration ---
 extern Logger logger; // Assume defined elsewhere (e.g., logger.cpp or another
                       // source file)
 
 // --- Global Pointer for Readline Completion ---
-static CommandRegistry *g_command_registry_ptr = nullptr;
-
-// --- Completion Logic (Using Command Registry) ---
+static Completer *g_completer_ptr = nullptr;
 
-// Generator function using the command registry
-char *command_registry_generator(const char *text, int state) {
-  static std::map<std::string, ICommand *>::const_iterator it;
+// --- Completion Logic (Using Completer) ---
 
-  if (!g_command_registry_ptr)
+// Converts matches into readline's format: the longest common prefix first,
+// then every match, NULL-terminated. Readline frees all of it.
+char **toReadlineMatches(const std::vector<std::string> &matches) {
+  if (matches.empty()) {
     return nullptr;
-
-  if (state == 0) {
-    it = g_command_registry_ptr->getCommands().cbegin(); // Use cbegin()
   }
 
-  while (it != g_command_registry_ptr->getCommands().cend()) { // Use cend()
-    const std::string &command_name = it->first;
-    it++; // Advance for next call BEFORE returning
-
-    if (command_name.rfind(text, 0) == 0) { // Efficient prefix check
-      return strdup(command_name.c_str());  // Readline frees this
+  size_t common = matches[0].size();
+  for (const std::string &match : matches) {
+    size_t i = 0;
+    while (i < common && i < match.size() && match[i] == matches[0][i]) {
+      i++;
     }
+    common = i;
   }
-  return nullptr; // No more matches
+
+  // A single match replaces the word outright and is not listed again.
+  size_t listed = matches.size() == 1 ? 0 : matches.size();
+  char **result =
+      static_cast<char **>(std::malloc((listed + 2) * sizeof(char *)));
+  result[0] = strndup(matches[0].c_str(), common);
+  for (size_t i = 0; i < listed; i++) {
+    result[i + 1] = strdup(matches[i].c_str());
+  }
+  result[listed + 1] = nullptr;
+  return result;
 }
 
-// Main completion function (Unchanged from previous correct version)
-char **command_completion(const char *text, int start, [[maybe_unused]]int end) {
+// Main completion function
+char **command_completion([[maybe_unused]] const char *text, int start,
+                          int end) {
   rl_attempted_completion_over = 1;
-  if (start == 0) {
-    return rl_completion_matches(text, command_registry_generator);
+  if (!g_completer_ptr) {
+    return nullptr;
+  }
+
+  std::vector<std::string> matches;
+  std::string_view line(rl_line_buffer, static_cast<size_t>(end));
+  if (!g_completer_ptr->complete(line, static_cast<size_t>(start), matches)) {
+    rl_attempted_completion_over = 0; // Let readline complete file names
+    return nullptr;
+  }
+  return toReadlineMatches(matches);
+}
+
+// --- Line Input ---
+
+// Set by the readline callback once a line is complete (nullptr on EOF).
+static char *g_input_line = nullptr;
+static bool g_input_done = false;
+// Set by the interrupt watcher for a Ctrl+C at the prompt.
+static std::atomic<bool> g_prompt_interrupted{false};
+
+static void onInputLine(char *line) {
+  g_input_line = line;
+  g_input_done = true;
+  rl_callback_handler_remove(); // the prompt is redrawn for the next line
+}
+
+/**
+ * @brief readline() that keeps log output from garbling the prompt.
+ *
+ * While the user edits, the logger parks console output and writes a byte
+ * into the wake pipe; the parked lines are printed above the prompt, which
+ * is then redrawn with the text typed so far. Ctrl+C discards the line.
+ * Returns nullptr on EOF.
+ */
+static char *readInputLine(const std::string &prompt, const int wake[2]) {
+  int wake_fd = wake[0];
+  int notify_fd = wake[1];
+  logger.holdConsole([notify_fd]() {
+    char byte = 0;
+    if (::write(notify_fd, &byte, 1) < 0) {
+      // Pipe full: a wake-up is already pending
+    }
+  });
+  g_input_line = nullptr;
+  g_input_done = false;
+  rl_callback_handler_install(prompt.c_str(), onInputLine);
+
+  std::string held;
+  while (!g_input_done) {
+    struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      rl_callback_handler_remove();
+      break;
+    }
+    if (fds[1].revents & POLLIN) {
+      char drain[64];
+      while (::read(wake_fd, drain, sizeof(drain)) > 0) {
+      }
+      if (g_prompt_interrupted.exchange(false)) {
+        rl_replace_line("", 0);
+        rl_point = 0;
+        std::cout << "^C" << std::endl;
+        rl_on_new_line();
+        rl_redisplay();
+      }
+      logger.takeHeldConsole(held);
+      if (!held.empty()) {
+        rl_clear_visible_line();
+        std::cout.write(held.data(), static_cast<std::streamsize>(held.size()));
+        std::cout.flush();
+        rl_on_new_line();
+        rl_redisplay();
+      }
+    }
+    if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+      rl_callback_read_char();
+    }
   }
-  return nullptr;
+
+  logger.releaseConsole();
+  return g_input_line;
 }
 
 // --- Main Application ---
 
-int main() {
+int main(int argc, char **argv) {
+  // --- Process Arguments ---
+  BatchOptions batch_options;
+  std::string usage_error;
+  if (!parseBatchOptions(std::vector<std::string>(argv, argv + argc),
+                         batch_options, usage_error)) {
+    std::cerr << argv[0] << ": " << usage_error << std::endl;
+    printUsage(argv[0]);
+    return EXIT_USAGE;
+  }
+  if (batch_options.show_help) {
+    printUsage(argv[0]);
+    return EXIT_OK;
+  }
+
+  // Headless when told what to run or when stdin is not a terminal.
+  const bool headless = !batch_options.commands.empty() ||
+                        !batch_options.script_path.empty() ||
+                        !isatty(STDIN_FILENO);
+  if (headless && !isatty(STDOUT_FILENO)) {
+    // Plain lines for scripts parsing our output
+    logger.enableColor(false);
+    logger.enablePrefix(false);
+  }
+
+  trace::nameThread("main");
+
+  // --- Log File Sink ---
+  // Mirrors all output into $HOME/uconnux/uconnux.log (Makefile's LOG_DIR).
+  logger.enableFileSink(defaultLogDirectory());
+
+  // --- Serial I/O Engine ---
+  // Declared before the registry so the port commands never outlive it.
+  std::unique_ptr<PortManager> ports;
+  try {
+    ports.reset(new PortManager());
+  } catch (const std::exception &e) {
+    logger.fatal("Failed to start the serial I/O engine: ", e.what());
+    logger.flush();
+    return 1;
+  }
+
   // --- Instantiate and Register Commands ---
   CommandRegistry registry;
-  g_command_registry_ptr = &registry; // Set global pointer for completion
+
+  // --- Background Jobs ---
+  // Declared after the registry so no job outlives the commands it runs.
+  // Jobs mostly wait on ports, so run more of them than there are cores.
+  std::unique_ptr<JobManager> jobs(new JobManager(
+      registry, std::max(4u, std::thread::hardware_concurrency())));
 
   try {
     // Register commands - AddCommand/ClearCommand might need specific setup
@@ -77,20 +243,73 @@ int main() {
                                               // or similar
     registry.registerCommand<AddCommand>(); // Assumes AddCommand parses its own
                                             // args
+    registry.registerCommand<OpenCommand>(*ports);
+    registry.registerCommand<CloseCommand>(*ports);
+    registry.registerCommand<PortsCommand>(*ports);
+    registry.registerCommand<CrcCommand>();
+    registry.registerCommand<FlashCommand>(*ports);
+    registry.registerCommand<DflashCommand>(*ports);
+    registry.registerCommand<HexinfoCommand>();
+    registry.registerCommand<BroadcastCommand>(registry, *ports);
+    registry.registerCommand<StatsCommand>(*ports);
+    registry.registerCommand<TraceCommand>();
+    registry.registerCommand<BenchCommand>(registry);
+    registry.registerCommand<CaptureCommand>(*ports);
+    registry.registerCommand<ReplayCommand>(*ports);
+    registry.registerCommand<CgrepCommand>();
+    registry.registerCommand<JobsCommand>(*jobs);
+    registry.registerCommand<FgCommand>(*jobs);
+    registry.registerCommand<KillCommand>(*jobs);
 
     // IMPORTANT: Register HelpCommand, passing the registry itself
     registry.registerCommand<HelpCommand>(registry);
 
   } catch (const std::exception &e) {
     logger.fatal("Failed to register commands during startup: ", e.what());
+    logger.flush();
     return 1;
   }
   // --- End Command Registration ---
 
+  if (headless) {
+    interrupt::install(interrupt::terminate); // best effort
+    int exit_code = runBatch(registry, *jobs, batch_options);
+    jobs.reset(); // cancels jobs left running by `exit`
+    logger.flush();
+    return exit_code;
+  }
+
   // --- Readline Initialization ---
+  Completer completer(registry, *ports);
+  g_completer_ptr = &completer; // Set global pointer for completion
   rl_attempted_completion_function = command_completion;
   // --------------------------------
 
+  // Wakes the input loop when background output is waiting.
+  int wake_pipe[2];
+  if (::pipe2(wake_pipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+    logger.fatal("Failed to create the prompt wake-up pipe: ",
+                 std::strerror(errno));
+    logger.flush();
+    return 1;
+  }
+
+  // Ctrl+C cancels the running command; at the prompt it drops the line.
+  // Readline must not catch it itself.
+  rl_catch_signals = 0;
+  int notify_fd = wake_pipe[1];
+  bool interruptible = interrupt::install([notify_fd]() {
+    g_prompt_interrupted = true;
+    char byte = 0;
+    if (::write(notify_fd, &byte, 1) < 0) {
+      // Pipe full: a wake-up is already pending
+    }
+  });
+  if (!interruptible) {
+    logger.warn("Cannot catch Ctrl+C; it will end the session.");
+  }
+
+  logger.flush(); // Registration warnings go above the banner
   printIntro();
 
   char *line_c_str = nullptr;
@@ -100,8 +319,7 @@ int main() {
       line_c_str = nullptr;
     }
 
-    line_c_str = readline(
-        getPromptString().c_str()); // Use your existing prompt function
+    line_c_str = readInputLine(getPromptString(), wake_pipe);
 
     if (line_c_str == nullptr) { // EOF (Ctrl+D)
       std::cout << std::endl;
@@ -118,18 +336,29 @@ int main() {
       add_history(line_c_str);
     }
 
+    bool background = JobManager::takeBackgroundMarker(line);
     if (line.empty()) {
       continue;
     }
 
     try {
-      std::vector<std::string> arguments =
-          parseCommandLine(line); // Use your existing parser
+      std::vector<std::string> arguments = registry.parseLine(line);
       if (arguments.empty()) {
         continue;
       }
 
-      int result = registry.executeCommand(arguments);
+      if (background) {
+        logger.info("[", jobs->start(std::move(arguments), line), "] ", line);
+        logger.flush();
+        continue;
+      }
+
+      CommandContext context;
+      int result;
+      {
+        interrupt::Foreground foreground(context.token());
+        result = registry.executeCommand(arguments, context);
+      }
 
       if (COMMAND_EXIT_REQUESTED == result) {
         break; // Exit the loop
@@ -140,13 +369,21 @@ int main() {
     } catch (...) {
       logger.fatal("Unknown exception in main loop.");
     }
+
+    // The logger writes asynchronously; drain it before the next prompt.
+    logger.flush();
   }
 
   if (line_c_str) {
     free(line_c_str);
   }
 
-  g_command_registry_ptr = nullptr; // Clear global pointer
+  g_completer_ptr = nullptr; // Clear global pointer
+  // Waits for running jobs; Ctrl+C meanwhile quits without waiting.
+  interrupt::setIdleHandler(interrupt::terminate);
+  jobs.reset();
+  ::close(wake_pipe[0]);
+  ::close(wake_pipe[1]);
 
   logger.success("See you later! ⚡");
   return 0;
@@ -0,0 +1,138 @@
+#include "../include/page_delta.hpp"
+#include "../include/crc.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace page_delta {
+
+namespace {
+
+// Below this many pages per thread, spawning costs more than it saves.
+const size_t MIN_PAGES_PER_THREAD = 32;
+
+uint64_t segmentEnd(const Segment &segment) {
+  return static_cast<uint64_t>(segment.address) + segment.size;
+}
+
+// First segment that ends after address; segments are sorted.
+std::vector<Segment>::const_iterator
+firstEndingAfter(const std::vector<Segment> &segments, uint64_t address) {
+  return std::partition_point(
+      segments.begin(), segments.end(),
+      [&](const Segment &segment) { return segmentEnd(segment) <= address; });
+}
+
+void feedErased(crc::Crc &crc, uint64_t len) {
+  static const std::vector<uint8_t> erased(256, 0xFF);
+  while (len > 0) {
+    size_t chunk = static_cast<size_t>(std::min<uint64_t>(len, erased.size()));
+    crc.update(erased.data(), chunk);
+    len -= chunk;
+  }
+}
+
+uint32_t hashPage(const std::vector<Segment> &segments, uint32_t address,
+                  uint32_t page_size) {
+  crc::Crc crc(crc::Algorithm::CRC32);
+  uint64_t cursor = address;
+  uint64_t end = cursor + page_size;
+  for (auto it = firstEndingAfter(segments, cursor);
+       it != segments.end() && it->address < end; ++it) {
+    uint64_t from = std::max<uint64_t>(cursor, it->address);
+    uint64_t to = std::min(end, segmentEnd(*it));
+    feedErased(crc, from - cursor);
+    crc.update(it->data + (from - it->address), to - from);
+    cursor = to;
+  }
+  feedErased(crc, end - cursor);
+  return crc.value();
+}
+
+} // namespace
+
+bool touchedPages(const std::vector<Segment> &segments,
+                  const bootloader::DeviceInfo &info,
+                  std::vector<uint32_t> &pages, std::string &error) {
+  pages.clear();
+  uint64_t flash_end = static_cast<uint64_t>(info.flash_base) + info.flash_size;
+  for (const Segment &segment : segments) {
+    if (segment.size == 0) {
+      continue;
+    }
+    if (segment.address < info.flash_base || segmentEnd(segment) > flash_end) {
+      error = "image does not fit the device's flash";
+      return false;
+    }
+    uint32_t offset = segment.address - info.flash_base;
+    uint32_t last = offset + static_cast<uint32_t>(segment.size - 1);
+    uint32_t page = offset / info.page_size * info.page_size;
+    // Neighbouring segments may share a page.
+    if (!pages.empty() && pages.back() >= info.flash_base + page) {
+      page += info.page_size;
+    }
+    for (; page <= last; page += info.page_size) {
+      pages.push_back(info.flash_base + page);
+    }
+  }
+  return true;
+}
+
+std::vector<PageRun> runs(const std::vector<uint32_t> &pages,
+                          uint32_t page_size) {
+  std::vector<PageRun> result;
+  for (uint32_t page : pages) {
+    if (!result.empty() &&
+        result.back().address + result.back().count * page_size == page) {
+      result.back().count++;
+    } else {
+      result.push_back(PageRun{page, 1});
+    }
+  }
+  return result;
+}
+
+std::vector<uint32_t> hashPages(const std::vector<Segment> &segments,
+                                const std::vector<uint32_t> &pages,
+                                uint32_t page_size, unsigned threads) {
+  std::vector<uint32_t> hashes(pages.size());
+  auto work = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      hashes[i] = hashPage(segments, pages[i], page_size);
+    }
+  };
+
+  size_t workers = std::min<size_t>(std::max(1u, threads),
+                                    pages.size() / MIN_PAGES_PER_THREAD + 1);
+  size_t slice = (pages.size() + workers - 1) / workers;
+  std::vector<std::thread> pool;
+  for (size_t begin = slice; begin < pages.size(); begin += slice) {
+    pool.emplace_back(work, begin, std::min(pages.size(), begin + slice));
+  }
+  work(0, std::min(pages.size(), slice));
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+  return hashes;
+}
+
+std::vector<Segment> clip(const std::vector<Segment> &segments,
+                          const std::vector<uint32_t> &pages,
+                          uint32_t page_size) {
+  std::vector<Segment> result;
+  for (const PageRun &run : runs(pages, page_size)) {
+    uint64_t start = run.address;
+    uint64_t end = start + static_cast<uint64_t>(run.count) * page_size;
+    for (auto it = firstEndingAfter(segments, start);
+         it != segments.end() && it->address < end; ++it) {
+      uint64_t from = std::max<uint64_t>(start, it->address);
+      uint64_t to = std::min(end, segmentEnd(*it));
+      result.push_back(Segment{static_cast<uint32_t>(from),
+                               it->data + (from - it->address),
+                               static_cast<size_t>(to - from)});
+    }
+  }
+  return result;
+}
+
+} // namespace page_delta
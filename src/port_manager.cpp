@@ -0,0 +1,600 @@
+#include "../include/port_manager.hpp"
+#include "../include/logger.hpp"
+#include "../include/serial_port.hpp"
+#include "../include/trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+extern Logger logger;
+
+namespace {
+
+const int MAX_EVENTS = 64;
+const size_t READ_CHUNK = 64 * 1024;
+// Reads per readiness event before yielding to the other ports.
+const int MAX_READS_PER_EVENT = 16;
+
+uint64_t steadyNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+std::string baseName(const std::string &path) {
+  size_t slash = path.find_last_of('/');
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+/** Port class **/
+Port::Port(std::string name, std::string path, int fd, int baud)
+    : name(std::move(name)), path(std::move(path)), fd(fd), baud(baud) {}
+
+Port::~Port() {
+  ::close(fd);
+  if (pty_slave_fd >= 0) {
+    ::close(pty_slave_fd);
+  }
+}
+
+/** PortManager class **/
+PortManager::PortManager() {
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    throw std::runtime_error(std::string("epoll_create1: ") +
+                             std::strerror(errno));
+  }
+
+  wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wake_fd < 0) {
+    ::close(epoll_fd);
+    throw std::runtime_error(std::string("eventfd: ") + std::strerror(errno));
+  }
+
+  struct epoll_event ev;
+  std::memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = nullptr; // nullptr marks the wake descriptor
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+
+  io_thread = std::thread(&PortManager::run, this);
+}
+
+PortManager::~PortManager() {
+  stopping = true;
+  wake();
+  if (io_thread.joinable()) {
+    io_thread.join();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(ports_mutex);
+    ports.clear();
+  }
+  ::close(wake_fd);
+  ::close(epoll_fd);
+}
+
+void PortManager::wake() {
+  uint64_t one = 1;
+  ssize_t ignored = ::write(wake_fd, &one, sizeof(one));
+  (void)ignored;
+}
+
+void PortManager::runOnIoThread(std::function<void()> op) {
+  if (stopping || std::this_thread::get_id() == io_thread.get_id()) {
+    op();
+    return;
+  }
+
+  std::promise<void> done;
+  std::future<void> result = done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(ops_mutex);
+    pending_ops.emplace_back([&op, &done]() {
+      op();
+      done.set_value();
+    });
+  }
+  wake();
+  result.wait();
+}
+
+bool PortManager::addPort(std::shared_ptr<Port> port, std::string &error) {
+  std::lock_guard<std::mutex> lock(ports_mutex);
+  if (ports.count(port->name)) {
+    error = "a port named '" + port->name + "' is already open";
+    return false;
+  }
+
+  struct epoll_event ev;
+  std::memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLRDHUP;
+  ev.data.ptr = port.get();
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, port->fd, &ev) != 0) {
+    error = std::string("epoll_ctl: ") + std::strerror(errno);
+    return false;
+  }
+
+  ports[port->name] = std::move(port);
+  return true;
+}
+
+// Runs on the I/O thread only.
+void PortManager::removePort(Port *port) {
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, port->fd, nullptr);
+  port->closed = true;
+  {
+    // Wake any reader or writer parked on this port before it goes away.
+    std::lock_guard<std::mutex> wait_lock(port->wait_mutex);
+    port->rx_cv.notify_all();
+    port->tx_cv.notify_all();
+  }
+  std::lock_guard<std::mutex> lock(ports_mutex);
+  // A racing close may already have removed this port and a new one been
+  // opened under its name; leave that one alone.
+  auto it = ports.find(port->name);
+  if (it != ports.end() && it->second.get() == port) {
+    ports.erase(it);
+  }
+}
+
+bool PortManager::open(const std::string &path, int baud, std::string &name,
+                       std::string &error) {
+  name = baseName(path);
+  if (find(name)) {
+    error = "a port named '" + name + "' is already open";
+    return false;
+  }
+
+  int fd = serial::openDevice(path, baud, error);
+  if (fd < 0) {
+    return false;
+  }
+  return addPort(std::make_shared<Port>(name, path, fd, baud), error);
+}
+
+bool PortManager::openPty(std::string &name, std::string &slave_path,
+                          std::string &error) {
+  int master_fd, slave_fd;
+  if (!serial::openPty(master_fd, slave_fd, slave_path, error)) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(ports_mutex);
+    name = "pty" + std::to_string(next_pty_id++);
+  }
+  auto port = std::make_shared<Port>(name, slave_path, master_fd,
+                                     serial::DEFAULT_BAUD);
+  port->pty_slave_fd = slave_fd;
+  return addPort(std::move(port), error);
+}
+
+bool PortManager::adopt(int fd, const std::string &name,
+                        const std::string &path, int baud,
+                        std::string &error) {
+  return addPort(std::make_shared<Port>(name, path, fd, baud), error);
+}
+
+std::shared_ptr<Port> PortManager::find(const std::string &name_or_path) const {
+  std::lock_guard<std::mutex> lock(ports_mutex);
+  auto it = ports.find(name_or_path);
+  if (it != ports.end()) {
+    return it->second;
+  }
+  for (const auto &pair : ports) {
+    if (pair.second->path == name_or_path) {
+      return pair.second;
+    }
+  }
+  return nullptr;
+}
+
+bool PortManager::close(const std::string &name_or_path) {
+  std::shared_ptr<Port> port = find(name_or_path);
+  if (!port) {
+    return false;
+  }
+  runOnIoThread([this, &port]() { removePort(port.get()); });
+  return true;
+}
+
+size_t PortManager::closeAll() {
+  std::vector<std::shared_ptr<Port>> victims;
+  {
+    std::lock_guard<std::mutex> lock(ports_mutex);
+    for (const auto &pair : ports) {
+      victims.push_back(pair.second);
+    }
+  }
+  runOnIoThread([this, &victims]() {
+    for (const auto &port : victims) {
+      removePort(port.get());
+    }
+  });
+  return victims.size();
+}
+
+std::vector<PortInfo> PortManager::list() const {
+  std::vector<std::shared_ptr<Port>> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(ports_mutex);
+    for (const auto &pair : ports) {
+      snapshot.push_back(pair.second);
+    }
+  }
+
+  std::vector<PortInfo> infos;
+  infos.reserve(snapshot.size());
+  for (const auto &port : snapshot) {
+    PortInfo info;
+    info.name = port->name;
+    info.path = port->path;
+    info.baud = port->baud;
+    info.is_pty = port->pty_slave_fd >= 0;
+    info.rx_bytes = port->rx_bytes.load(std::memory_order_relaxed);
+    info.tx_bytes = port->tx_bytes.load(std::memory_order_relaxed);
+    info.rx_dropped = port->rx_dropped.load(std::memory_order_relaxed);
+    info.rx_buffered = port->rx_ring.size();
+    info.tx_pending = port->tx_ring.size();
+    info.framing = port->framing.load(std::memory_order_relaxed);
+    info.frame_errors = port->frame_errors.load(std::memory_order_relaxed);
+    info.rx_frames = port->rx_frames.load(std::memory_order_relaxed);
+    info.tx_writes = port->tx_writes.load(std::memory_order_relaxed);
+    info.crc_errors = port->crc_errors.load(std::memory_order_relaxed);
+    info.rx_peak = port->rx_peak.load(std::memory_order_relaxed);
+    info.opened = port->opened;
+    infos.push_back(info);
+  }
+  return infos;
+}
+
+constexpr std::chrono::milliseconds PortManager::DEFAULT_WRITE_TIMEOUT;
+
+long PortManager::write(const std::string &name, const void *data, size_t len,
+                        std::chrono::milliseconds timeout) {
+  trace::Span span("port", "PortManager::write", name);
+  std::shared_ptr<Port> port = find(name);
+  if (!port) {
+    return -1;
+  }
+
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  size_t written = 0;
+
+  std::lock_guard<std::mutex> writer_lock(port->writer_mutex);
+  while (written < len && !port->closed) {
+    size_t n = port->tx_ring.write(bytes + written, len - written);
+    if (n > 0) {
+      written += n;
+      scheduleTx(port);
+      continue;
+    }
+
+    // Ring full: park until the I/O thread drains some of it.
+    std::unique_lock<std::mutex> lock(port->wait_mutex);
+    port->tx_waiting = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool ready = port->tx_cv.wait_until(lock, deadline, [&port]() {
+      return port->tx_ring.size() < Port::TX_RING_SIZE || port->closed;
+    });
+    port->tx_waiting = false;
+    if (!ready) {
+      break;
+    }
+  }
+  if (written > 0) {
+    port->tx_writes.fetch_add(1, std::memory_order_relaxed);
+  }
+  span.setBytes(static_cast<long>(written));
+  return static_cast<long>(written);
+}
+
+long PortManager::read(const std::string &name, void *data, size_t len,
+                       std::chrono::milliseconds timeout) {
+  trace::Span span("port", "PortManager::read", name);
+  std::shared_ptr<Port> port = find(name);
+  if (!port) {
+    return -1;
+  }
+
+  uint8_t *out = static_cast<uint8_t *>(data);
+  std::lock_guard<std::mutex> reader_lock(port->reader_mutex);
+  size_t count = port->rx_ring.read(out, len);
+  if (count == 0 && timeout.count() > 0) {
+    waitReadable(*port, std::chrono::steady_clock::now() + timeout);
+    count = port->rx_ring.read(out, len);
+  }
+  span.setBytes(static_cast<long>(count));
+  return static_cast<long>(count);
+}
+
+bool PortManager::setFraming(const std::string &name, framing::Framing mode) {
+  std::shared_ptr<Port> port = find(name);
+  if (!port) {
+    return false;
+  }
+  std::lock_guard<std::mutex> reader_lock(port->reader_mutex);
+  port->decoder = framing::FrameDecoder(mode);
+  port->framing = mode;
+  port->frame_errors = 0;
+  return true;
+}
+
+long PortManager::readFrames(const std::string &name, const FrameSink &sink,
+                             std::chrono::milliseconds timeout) {
+  trace::Span span("port", "PortManager::readFrames", name);
+  std::shared_ptr<Port> port = find(name);
+  if (!port) {
+    return -1;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  std::lock_guard<std::mutex> reader_lock(port->reader_mutex);
+  framing::FrameDecoder &decoder = port->decoder;
+  uint64_t first = decoder.frames();
+
+  while (true) {
+    uint8_t *ptr;
+    size_t span;
+    while ((span = port->rx_ring.readSpan(&ptr)) > 0) {
+      decoder.feed(ptr, span, sink);
+      port->rx_ring.commitRead(span);
+    }
+    port->frame_errors.store(decoder.errors() + decoder.overruns(),
+                             std::memory_order_relaxed);
+
+    // Bytes of an unfinished frame may already be in; wait for the rest.
+    if (decoder.frames() != first ||
+        std::chrono::steady_clock::now() >= deadline ||
+        !waitReadable(*port, deadline)) {
+      break;
+    }
+  }
+  uint64_t delivered = decoder.frames() - first;
+  port->rx_frames.fetch_add(delivered, std::memory_order_relaxed);
+  return static_cast<long>(delivered);
+}
+
+void PortManager::setCapture(std::shared_ptr<capture::Writer> writer) {
+  runOnIoThread([this, &writer]() { capture = std::move(writer); });
+}
+
+// Parks a reader until RX bytes arrive. Caller holds reader_mutex.
+// Returns false on timeout or when the port goes away.
+bool PortManager::waitReadable(Port &port,
+                               std::chrono::steady_clock::time_point deadline) {
+  std::unique_lock<std::mutex> lock(port.wait_mutex);
+  port.rx_waiting = true;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  bool ready = port.rx_cv.wait_until(lock, deadline, [this, &port]() {
+    return !port.rx_ring.empty() || port.closed || stopping;
+  });
+  port.rx_waiting = false;
+  return ready && !port.rx_ring.empty();
+}
+
+// Called by writers after publishing bytes into tx_ring.
+void PortManager::scheduleTx(const std::shared_ptr<Port> &port) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (port->tx_scheduled.exchange(true)) {
+    return; // the I/O thread already has a pending kick for this port
+  }
+  {
+    std::lock_guard<std::mutex> lock(ops_mutex);
+    tx_ready.push_back(port);
+  }
+  wake();
+}
+
+// Runs on the I/O thread only: moves TX ring contents into the tty.
+void PortManager::drainTx(Port &port) {
+  trace::Span span("io", "tx", port.name);
+  size_t drained = 0;
+  bool blocked = false;
+
+  while (true) {
+    const uint8_t *ptr;
+    size_t span = port.tx_ring.readSpan(&ptr);
+    if (span == 0) {
+      break;
+    }
+    ssize_t n = ::write(port.fd, ptr, span);
+    if (n > 0) {
+      if (capture) {
+        capture->append(port.name, capture::TX, ptr, static_cast<size_t>(n),
+                        steadyNs());
+      }
+      port.tx_ring.commitRead(static_cast<size_t>(n));
+      drained += static_cast<size_t>(n);
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      blocked = true;
+      break;
+    } else {
+      throw std::runtime_error(std::strerror(errno));
+    }
+  }
+
+  setTxArmed(port, blocked);
+  span.setBytes(static_cast<long>(drained));
+
+  if (drained > 0) {
+    port.tx_bytes.fetch_add(drained, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (port.tx_waiting.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(port.wait_mutex);
+      port.tx_cv.notify_all();
+    }
+  }
+}
+
+// Runs on the I/O thread only.
+void PortManager::setTxArmed(Port &port, bool armed) {
+  if (port.tx_armed == armed) {
+    return;
+  }
+  struct epoll_event ev;
+  std::memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLRDHUP;
+  if (armed) {
+    ev.events |= EPOLLOUT;
+  }
+  ev.data.ptr = &port;
+  epoll_ctl(epoll_fd, EPOLL_CTL_MOD, port.fd, &ev);
+  port.tx_armed = armed;
+}
+
+void PortManager::handleWritable(Port *port) { drainTx(*port); }
+
+void PortManager::handleReadable(Port *port) {
+  trace::Span span("io", "rx", port->name);
+  size_t received = 0;
+
+  for (int i = 0; i < MAX_READS_PER_EVENT; i++) {
+    uint8_t *ptr;
+    size_t span = port->rx_ring.writeSpan(&ptr);
+    bool overrun = (span == 0);
+    if (overrun) {
+      // Consumer is not keeping up: keep the tty drained, count the loss.
+      static uint8_t scratch[READ_CHUNK];
+      ptr = scratch;
+      span = sizeof(scratch);
+    }
+
+    // Read straight into ring storage; no intermediate copy.
+    ssize_t n = ::read(port->fd, ptr, span);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (n <= 0) {
+      throw std::runtime_error(n == 0 ? std::string("hangup")
+                                      : std::strerror(errno));
+    }
+
+    port->rx_bytes.fetch_add(static_cast<uint64_t>(n),
+                             std::memory_order_relaxed);
+    // Captured even when the ring overflowed and the bytes are dropped.
+    if (capture) {
+      capture->append(port->name, capture::RX, ptr, static_cast<size_t>(n),
+                      steadyNs());
+    }
+    if (overrun) {
+      port->rx_dropped.fetch_add(static_cast<uint64_t>(n),
+                                 std::memory_order_relaxed);
+    } else {
+      port->rx_ring.commitWrite(static_cast<size_t>(n));
+      received += static_cast<size_t>(n);
+    }
+  }
+
+  span.setBytes(static_cast<long>(received));
+  if (received > 0) {
+    size_t depth = port->rx_ring.size();
+    if (depth > port->rx_peak.load(std::memory_order_relaxed)) {
+      port->rx_peak.store(depth, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (port->rx_waiting.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(port->wait_mutex);
+      port->rx_cv.notify_all();
+    }
+  }
+}
+
+void PortManager::run() {
+  struct epoll_event events[MAX_EVENTS];
+  trace::nameThread("io");
+
+  while (!stopping) {
+    int count = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      logger.fatal("epoll_wait failed: ", std::strerror(errno));
+      return;
+    }
+
+    bool woken = false;
+    std::vector<Port *> dead;
+
+    for (int i = 0; i < count; i++) {
+      Port *port = static_cast<Port *>(events[i].data.ptr);
+      if (port == nullptr) {
+        uint64_t value;
+        ssize_t ignored = ::read(wake_fd, &value, sizeof(value));
+        (void)ignored;
+        woken = true;
+        continue;
+      }
+
+      try {
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
+          handleReadable(port);
+        }
+        if (events[i].events & EPOLLOUT) {
+          handleWritable(port);
+        }
+      } catch (const std::exception &e) {
+        logger.warn("Port '", port->name, "' disconnected (", e.what(), ").");
+        dead.push_back(port);
+      }
+    }
+
+    // Ports are only destroyed after the whole batch has been dispatched,
+    // so no event above can refer to a freed Port.
+    for (Port *port : dead) {
+      removePort(port);
+    }
+
+    if (woken) {
+      std::vector<std::function<void()>> ops;
+      std::vector<std::shared_ptr<Port>> kicked;
+      {
+        std::lock_guard<std::mutex> lock(ops_mutex);
+        ops.swap(pending_ops);
+        kicked.swap(tx_ready);
+      }
+
+      for (const auto &port : kicked) {
+        // Clear the flag before draining so bytes published after this
+        // point schedule a fresh kick instead of being stranded.
+        port->tx_scheduled = false;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (port->closed) {
+          continue;
+        }
+        try {
+          drainTx(*port);
+        } catch (const std::exception &e) {
+          logger.warn("Port '", port->name, "' write failed (", e.what(),
+                      ").");
+          removePort(port.get());
+        }
+      }
+
+      for (auto &op : ops) {
+        op();
+      }
+    }
+  }
+}
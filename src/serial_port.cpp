@@ -0,0 +1,141 @@
+#include "../include/serial_port.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace serial {
+
+namespace {
+
+struct BaudEntry {
+  int rate;
+  speed_t speed;
+};
+
+const BaudEntry baud_table[] = {
+    {1200, B1200},       {2400, B2400},       {4800, B4800},
+    {9600, B9600},       {19200, B19200},     {38400, B38400},
+    {57600, B57600},     {115200, B115200},   {230400, B230400},
+    {460800, B460800},   {500000, B500000},   {576000, B576000},
+    {921600, B921600},   {1000000, B1000000}, {1152000, B1152000},
+    {1500000, B1500000}, {2000000, B2000000}, {2500000, B2500000},
+    {3000000, B3000000}, {3500000, B3500000}, {4000000, B4000000},
+};
+
+bool lookupSpeed(int baud, speed_t &speed) {
+  for (const BaudEntry &entry : baud_table) {
+    if (entry.rate == baud) {
+      speed = entry.speed;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string errnoString(const char *what) {
+  return std::string(what) + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+bool isSupportedBaud(int baud) {
+  speed_t speed;
+  return lookupSpeed(baud, speed);
+}
+
+std::vector<int> supportedBauds() {
+  std::vector<int> rates;
+  for (const BaudEntry &entry : baud_table) {
+    rates.push_back(entry.rate);
+  }
+  return rates;
+}
+
+bool configure(int fd, int baud, std::string &error) {
+  speed_t speed;
+  if (!lookupSpeed(baud, speed)) {
+    error = "unsupported baud rate " + std::to_string(baud);
+    return false;
+  }
+
+  struct termios tio;
+  if (tcgetattr(fd, &tio) != 0) {
+    error = errnoString("tcgetattr");
+    return false;
+  }
+
+  cfmakeraw(&tio);
+  tio.c_cflag |= (CLOCAL | CREAD);
+  tio.c_cflag &= ~CRTSCTS;
+  // The fd is non-blocking either way. With VMIN=1 a drained tty reports
+  // EAGAIN; VMIN=0 would make read() return 0, which reads as a hangup.
+  tio.c_cc[VMIN] = 1;
+  tio.c_cc[VTIME] = 0;
+  cfsetispeed(&tio, speed);
+  cfsetospeed(&tio, speed);
+
+  if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+    error = errnoString("tcsetattr");
+    return false;
+  }
+  tcflush(fd, TCIOFLUSH);
+  return true;
+}
+
+int openDevice(const std::string &path, int baud, std::string &error) {
+  int fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    error = errnoString(path.c_str());
+    return -1;
+  }
+
+  if (!isatty(fd)) {
+    error = path + " is not a tty";
+    ::close(fd);
+    return -1;
+  }
+
+  if (ioctl(fd, TIOCEXCL) != 0) {
+    error = errnoString("TIOCEXCL");
+    ::close(fd);
+    return -1;
+  }
+
+  if (!configure(fd, baud, error)) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool openPty(int &master_fd, int &slave_fd, std::string &slave_path,
+             std::string &error) {
+  char name[64];
+  if (openpty(&master_fd, &slave_fd, name, nullptr, nullptr) != 0) {
+    error = errnoString("openpty");
+    return false;
+  }
+
+  struct termios tio;
+  for (int fd : {master_fd, slave_fd}) {
+    if (tcgetattr(fd, &tio) == 0) {
+      cfmakeraw(&tio);
+      tcsetattr(fd, TCSANOW, &tio);
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  fcntl(master_fd, F_SETFL, fcntl(master_fd, F_GETFL) | O_NONBLOCK);
+
+  slave_path = name;
+  return true;
+}
+
+} // namespace serial
@@ -0,0 +1,48 @@
+#include "../include/table_format.hpp"
+
+#include <cstdio>
+
+namespace table_fmt {
+
+std::string scaled(double value, const char *unit) {
+  const char *prefixes[] = {"", "k", "M", "G", "T"};
+  size_t prefix = 0;
+  while (value >= 1000 && prefix + 1 < sizeof(prefixes) / sizeof(*prefixes)) {
+    value /= 1000;
+    prefix++;
+  }
+  char text[32];
+  std::snprintf(text, sizeof(text), prefix == 0 ? "%.0f%s%s" : "%.1f%s%s",
+                value, prefixes[prefix], unit);
+  return text;
+}
+
+std::string duration(uint64_t ns) {
+  char text[32];
+  if (ns < 1000) {
+    std::snprintf(text, sizeof(text), "%llu ns",
+                  static_cast<unsigned long long>(ns));
+  } else if (ns < 1000000) {
+    std::snprintf(text, sizeof(text), "%.1f us", ns / 1e3);
+  } else if (ns < 1000000000) {
+    std::snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+  } else {
+    std::snprintf(text, sizeof(text), "%.2f s", ns / 1e9);
+  }
+  return text;
+}
+
+std::string row(const std::vector<std::string> &cells,
+                const std::vector<size_t> &widths) {
+  std::string line = " ";
+  for (size_t i = 0; i < cells.size(); i++) {
+    line += ' ';
+    line += cells[i];
+    if (i + 1 < cells.size() && cells[i].length() < widths[i]) {
+      line.append(widths[i] - cells[i].length(), ' ');
+    }
+  }
+  return line;
+}
+
+} // namespace table_fmt
@@ -0,0 +1,241 @@
+#include "../include/trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+namespace trace {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+struct Event {
+  const char *category;
+  const char *name;
+  uint64_t begin_ns;
+  uint64_t end_ns;
+  long bytes;
+  char detail[Span::DETAIL_SIZE];
+};
+
+// One thread's spans. Only the owning thread appends; the mutex is there
+// for start() and stop(), so it is never contended while tracing.
+struct Buffer {
+  std::mutex mutex;
+  uint32_t tid = 0;
+  std::string name;
+  std::vector<Event> events;
+  size_t dropped = 0;
+};
+
+std::mutex registry_mutex;
+// A buffer outlives its thread so that spans recorded by a short-lived
+// thread are still written; start() forgets the orphans.
+std::vector<std::shared_ptr<Buffer>> buffers;
+uint32_t next_tid = 1;
+uint64_t origin_ns = 0; // when start() was called
+
+thread_local std::shared_ptr<Buffer> local_buffer;
+
+uint64_t nowNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+Buffer &localBuffer() {
+  if (!local_buffer) {
+    local_buffer = std::make_shared<Buffer>();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    local_buffer->tid = next_tid++;
+    buffers.push_back(local_buffer);
+  }
+  return *local_buffer;
+}
+
+void appendJsonString(std::string &out, const char *text) {
+  out += '"';
+  for (const char *p = text; *p != '\0'; p++) {
+    unsigned char c = static_cast<unsigned char>(*p);
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += static_cast<char>(c);
+    } else if (c < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out += escaped;
+    } else {
+      out += static_cast<char>(c);
+    }
+  }
+  out += '"';
+}
+
+// Trace timestamps are microseconds; keep nanosecond precision.
+void appendMicros(std::string &out, uint64_t ns) {
+  char text[32];
+  std::snprintf(text, sizeof(text), "%llu.%03u",
+                static_cast<unsigned long long>(ns / 1000),
+                static_cast<unsigned>(ns % 1000));
+  out += text;
+}
+
+} // namespace
+
+void start() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                               [](const std::shared_ptr<Buffer> &buffer) {
+                                 return buffer.use_count() == 1;
+                               }),
+                buffers.end());
+  for (const std::shared_ptr<Buffer> &buffer : buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    buffer->events.clear();
+    buffer->dropped = 0;
+  }
+  origin_ns = nowNs();
+  g_enabled.store(true, std::memory_order_release);
+}
+
+bool stop(const std::string &path, size_t &events, size_t &dropped,
+          std::string &error) {
+  events = 0;
+  dropped = 0;
+  // Opened first so a bad path leaves the recording intact for a retry.
+  std::FILE *file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    error = std::strerror(errno);
+    return false;
+  }
+  g_enabled.store(false, std::memory_order_release);
+
+  std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  std::string pid = std::to_string(getpid());
+  bool first = true;
+  auto open = [&](const char *phase, uint32_t tid) {
+    json += first ? "\n" : ",\n";
+    first = false;
+    json += "{\"ph\":\"";
+    json += phase;
+    json += "\",\"pid\":" + pid + ",\"tid\":" + std::to_string(tid);
+  };
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (const std::shared_ptr<Buffer> &buffer : buffers) {
+    std::vector<Event> taken;
+    std::string name;
+    {
+      std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+      taken.swap(buffer->events);
+      name = buffer->name;
+      dropped += buffer->dropped;
+      buffer->dropped = 0;
+    }
+    if (taken.empty()) {
+      continue;
+    }
+    if (name.empty()) {
+      name = "thread " + std::to_string(buffer->tid);
+    }
+    open("M", buffer->tid);
+    json += ",\"name\":\"thread_name\",\"args\":{\"name\":";
+    appendJsonString(json, name.c_str());
+    json += "}}";
+
+    for (const Event &event : taken) {
+      if (event.begin_ns < origin_ns) {
+        continue; // begun during an earlier trace
+      }
+      open("X", buffer->tid);
+      json += ",\"cat\":";
+      appendJsonString(json, event.category);
+      json += ",\"name\":";
+      appendJsonString(json, event.name);
+      json += ",\"ts\":";
+      appendMicros(json, event.begin_ns - origin_ns);
+      json += ",\"dur\":";
+      appendMicros(json, event.end_ns - event.begin_ns);
+      if (event.detail[0] != '\0' || event.bytes >= 0) {
+        json += ",\"args\":{";
+        if (event.detail[0] != '\0') {
+          json += "\"detail\":";
+          appendJsonString(json, event.detail);
+        }
+        if (event.bytes >= 0) {
+          json += event.detail[0] != '\0' ? ",\"bytes\":" : "\"bytes\":";
+          json += std::to_string(event.bytes);
+        }
+        json += '}';
+      }
+      json += '}';
+      events++;
+    }
+  }
+  json += "\n]}\n";
+
+  bool written = std::fwrite(json.data(), 1, json.size(), file) ==
+                 json.size();
+  int write_errno = errno;
+  if (std::fclose(file) != 0 && written) {
+    written = false;
+    write_errno = errno;
+  }
+  if (!written) {
+    error = std::strerror(write_errno);
+    return false;
+  }
+  return true;
+}
+
+void nameThread(std::string name) {
+  Buffer &buffer = localBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.name = std::move(name);
+}
+
+void Span::begin(const char *category, const char *name,
+                 std::string_view detail) {
+  category_ = category;
+  name_ = name;
+  size_t length = std::min(detail.size(), DETAIL_SIZE - 1);
+  if (length > 0) {
+    std::memcpy(detail_, detail.data(), length);
+  }
+  detail_[length] = '\0';
+  begin_ns_ = nowNs();
+}
+
+void Span::end() {
+  uint64_t end_ns = nowNs();
+  if (!enabled()) {
+    return; // stopped meanwhile
+  }
+  Buffer &buffer = localBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.events.size() >= MAX_EVENTS_PER_THREAD) {
+    buffer.dropped++;
+    return;
+  }
+  if (buffer.events.capacity() == 0) {
+    buffer.events.reserve(4096);
+  }
+  Event event;
+  event.category = category_;
+  event.name = name_;
+  event.begin_ns = begin_ns_;
+  event.end_ns = end_ns;
+  event.bytes = bytes_;
+  std::memcpy(event.detail, detail_, sizeof(event.detail));
+  buffer.events.push_back(event);
+}
+
+} // namespace trace
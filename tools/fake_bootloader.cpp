@@ -0,0 +1,357 @@
+// A simulated bootloader for trying `flash` and `dflash` without hardware.
+//
+// Creates a pty (or opens the given tty) and answers the bootloader protocol
+// from bootloader_protocol.hpp against an in-memory flash that starts out
+// erased. Faults can be injected to exercise the flasher's retransmit path:
+//
+//   build/tools/fake_bootloader --drop 0.02 --corrupt 0.01 --latency 2ms
+//   fake bootloader on /dev/pts/7
+//
+//   uconnux> open /dev/pts/7          (registered as port '7')
+//   uconnux> flash 7 firmware.bin
+//   uconnux> dflash 7 firmware-v2.bin
+//
+// The flash contents live as long as the process, so successive runs see
+// what the previous one wrote.
+//
+// Options:
+//   -a, --base <addr>      flash base address (default 0x08000000)
+//   -s, --size <bytes>     flash size (default 1 MiB)
+//   -p, --page <bytes>     erase page size (default 2048)
+//   -b, --block <bytes>    largest WRITE payload accepted (default 1024)
+//   -l, --latency <time>   delay before each reply, e.g. 2ms (default 0)
+//   -d, --drop <p>         probability of ignoring a request
+//   -c, --corrupt <p>      probability of corrupting a request
+//   -r, --seed <n>         random seed for the fault injection
+
+#include "../include/args_opt.hpp"
+#include "../include/bootloader_protocol.hpp"
+#include "../include/crc.hpp"
+#include "../include/frame_decoder.hpp"
+#include "../include/serial_port.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using namespace bootloader;
+using opt_parser::ArgumentOptions;
+using opt_parser::ValueType;
+using Clock = std::chrono::steady_clock;
+
+constexpr opt_parser::OptionTable OPTIONS({
+    {'a', "base", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+    {'s', "size", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+    {'p', "page", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+    {'b', "block", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+    {'l', "latency", ArgumentOptions::REQ_ARG, ValueType::DURATION},
+    {'d', "drop", ArgumentOptions::REQ_ARG, ValueType::STRING},
+    {'c', "corrupt", ArgumentOptions::REQ_ARG, ValueType::STRING},
+    {'r', "seed", ArgumentOptions::REQ_ARG, ValueType::INTEGER},
+});
+
+struct Reply {
+  Clock::time_point due;
+  std::vector<uint8_t> wire;
+};
+
+class Device {
+public:
+  Device(DeviceInfo info, Clock::duration latency)
+      : info_(info), latency_(latency), flash_(info.flash_size, 0xFF) {}
+
+  std::deque<Reply> &replies() { return replies_; }
+
+  void handle(const uint8_t *data, size_t len) {
+    PacketReader reader(data, len);
+    if (!reader.valid()) {
+      // Best effort: NAK a damaged WRITE with the sequence as received so
+      // the host resends it without waiting for its timeout.
+      if (len >= 3 && data[0] == WRITE) {
+        PacketWriter nak(NAK);
+        nak.u16(static_cast<uint16_t>(data[1] | data[2] << 8));
+        nak.u8(STATUS_BAD_PACKET);
+        queue(nak);
+      }
+      bad_packets++;
+      return;
+    }
+
+    switch (reader.opcode()) {
+    case HELLO: {
+      PacketWriter info(INFO);
+      info.u32(info_.flash_base).u32(info_.flash_size).u32(info_.page_size);
+      info.u16(info_.max_block);
+      queue(info);
+      break;
+    }
+    case ERASE:
+      handleErase(reader);
+      break;
+    case WRITE:
+      handleWrite(reader);
+      break;
+    case VERIFY: {
+      uint32_t address = reader.u32();
+      uint32_t length = reader.u32();
+      uint8_t *target = locate(address, length);
+      PacketWriter result(RESULT);
+      if (reader.truncated() || target == nullptr) {
+        result.u8(STATUS_OUT_OF_RANGE);
+      } else {
+        result.u8(STATUS_OK);
+        result.u32(crc::compute(crc::Algorithm::CRC32, target, length));
+      }
+      queue(result);
+      break;
+    }
+    case HASH:
+      handleHash(reader);
+      break;
+    case BOOT:
+      std::fprintf(stderr,
+                   "boot: %zu writes, %zu duplicates, %zu bad packets\n",
+                   writes, duplicates, bad_packets);
+      queue(PacketWriter(RESULT).u8(STATUS_OK));
+      break;
+    default:
+      queue(PacketWriter(RESULT).u8(STATUS_UNKNOWN));
+      break;
+    }
+  }
+
+  size_t writes = 0;
+  size_t duplicates = 0;
+  size_t bad_packets = 0;
+
+private:
+  DeviceInfo info_;
+  Clock::duration latency_;
+  std::vector<uint8_t> flash_;
+  std::deque<Reply> replies_;
+
+  void queue(PacketWriter &packet) {
+    Reply reply;
+    reply.due = Clock::now() + latency_;
+    packet.finish(reply.wire);
+    replies_.push_back(std::move(reply));
+  }
+  void queue(PacketWriter &&packet) { queue(packet); }
+
+  uint8_t *locate(uint32_t address, uint32_t length) {
+    if (address < info_.flash_base ||
+        static_cast<uint64_t>(address - info_.flash_base) + length >
+            info_.flash_size) {
+      return nullptr;
+    }
+    return flash_.data() + (address - info_.flash_base);
+  }
+
+  void handleErase(PacketReader &reader) {
+    uint32_t address = reader.u32();
+    uint32_t length = reader.u32();
+    uint8_t *target = locate(address, length);
+    uint8_t status = STATUS_OK;
+    if (reader.truncated() || target == nullptr) {
+      status = STATUS_OUT_OF_RANGE;
+    } else if ((address - info_.flash_base) % info_.page_size != 0 ||
+               length % info_.page_size != 0) {
+      status = STATUS_UNALIGNED;
+    } else {
+      std::memset(target, 0xFF, length);
+      std::fprintf(stderr, "erase 0x%08x +%u\n", address, length);
+    }
+    queue(PacketWriter(RESULT).u8(status));
+  }
+
+  void handleHash(PacketReader &reader) {
+    uint32_t address = reader.u32();
+    uint16_t count = reader.u16();
+    uint8_t *target = locate(address, count * info_.page_size);
+    PacketWriter result(RESULT);
+    if (reader.truncated() || count > MAX_HASH_PAGES) {
+      result.u8(STATUS_BAD_PACKET);
+    } else if (target == nullptr) {
+      result.u8(STATUS_OUT_OF_RANGE);
+    } else if ((address - info_.flash_base) % info_.page_size != 0) {
+      result.u8(STATUS_UNALIGNED);
+    } else {
+      result.u8(STATUS_OK);
+      for (uint16_t i = 0; i < count; i++) {
+        result.u32(crc::compute(crc::Algorithm::CRC32,
+                                target + i * info_.page_size,
+                                info_.page_size));
+      }
+    }
+    queue(result);
+  }
+
+  void handleWrite(PacketReader &reader) {
+    uint16_t seq = reader.u16();
+    uint32_t address = reader.u32();
+    size_t length;
+    const uint8_t *data = reader.rest(length);
+    uint8_t *target = locate(address, static_cast<uint32_t>(length));
+
+    uint8_t status = STATUS_OK;
+    if (reader.truncated() || length > info_.max_block) {
+      status = STATUS_BAD_PACKET;
+    } else if (target == nullptr) {
+      status = STATUS_OUT_OF_RANGE;
+    } else if (std::equal(data, data + length, target)) {
+      duplicates++; // a retransmit of a block that already landed
+    } else if (std::any_of(target, target + length,
+                           [](uint8_t b) { return b != 0xFF; })) {
+      status = STATUS_NOT_ERASED;
+    } else {
+      std::memcpy(target, data, length);
+      writes++;
+    }
+
+    if (status == STATUS_OK) {
+      queue(PacketWriter(ACK).u16(seq));
+    } else {
+      queue(PacketWriter(NAK).u16(seq).u8(status));
+    }
+  }
+};
+
+bool writeAll(int fd, const std::vector<uint8_t> &wire) {
+  size_t offset = 0;
+  while (offset < wire.size()) {
+    ssize_t n = ::write(fd, wire.data() + offset, wire.size() - offset);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+      pollfd pfd{fd, POLLOUT, 0};
+      ::poll(&pfd, 1, 100);
+      continue;
+    }
+    if (n < 0) {
+      return false;
+    }
+    offset += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+double probability(const opt_parser::ParsedOptions &options, char letter) {
+  std::string text(options.str(letter, "0"));
+  return std::strtod(text.c_str(), nullptr);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::vector<std::string> args(argv, argv + argc);
+  opt_parser::ParsedOptions options = OPTIONS.parse(args);
+  if (!options.ok() || args.size() > options.firstPositional() + 1) {
+    std::fprintf(stderr, "%s\nusage: %s [options] [device]\n",
+                 options.errorMessage().c_str(), argv[0]);
+    return 2;
+  }
+
+  DeviceInfo info;
+  info.flash_base = static_cast<uint32_t>(options.integer('a', 0x08000000));
+  info.flash_size = static_cast<uint32_t>(options.integer('s', 1 << 20));
+  info.page_size = static_cast<uint32_t>(options.integer('p', 2048));
+  info.max_block = static_cast<uint16_t>(options.integer('b', 1024));
+  if (info.page_size == 0 || info.flash_size % info.page_size != 0 ||
+      info.max_block == 0) {
+    std::fprintf(stderr, "flash size must be a multiple of a non-zero page\n");
+    return 2;
+  }
+  auto latency = options.duration('l', std::chrono::microseconds(0));
+  double drop = probability(options, 'd');
+  double corrupt = probability(options, 'c');
+  std::mt19937 rng(static_cast<uint32_t>(options.integer('r', 1)));
+  std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+  int fd = -1;
+  int slave_fd = -1;
+  std::string error;
+  if (options.firstPositional() < args.size()) {
+    fd = serial::openDevice(args[options.firstPositional()],
+                            serial::DEFAULT_BAUD, error);
+    if (fd < 0) {
+      std::fprintf(stderr, "cannot open device: %s\n", error.c_str());
+      return 1;
+    }
+  } else {
+    std::string slave_path;
+    if (!serial::openPty(fd, slave_fd, slave_path, error)) {
+      std::fprintf(stderr, "cannot create pty: %s\n", error.c_str());
+      return 1;
+    }
+    std::printf("fake bootloader on %s\n", slave_path.c_str());
+    std::fflush(stdout);
+  }
+
+  Device device(info, latency);
+  framing::FrameDecoder decoder(framing::Framing::COBS, 2 * 65536);
+  std::vector<uint8_t> buffer(64 * 1024);
+
+  while (true) {
+    std::deque<Reply> &replies = device.replies();
+    int timeout = -1;
+    if (!replies.empty()) {
+      auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+          replies.front().due - Clock::now());
+      timeout = static_cast<int>(std::max<long>(0, wait.count()));
+    }
+
+    pollfd pfd{fd, POLLIN, 0};
+    int ready = ::poll(&pfd, 1, timeout);
+    if (ready < 0 && errno != EINTR) {
+      std::perror("poll");
+      return 1;
+    }
+    if (ready > 0 && (pfd.revents & POLLIN)) {
+      ssize_t n = ::read(fd, buffer.data(), buffer.size());
+      if (n < 0 && errno != EAGAIN && errno != EINTR) {
+        std::perror("read");
+        return 1;
+      }
+      if (n > 0) {
+        decoder.feed(buffer.data(), static_cast<size_t>(n),
+                     [&](const framing::FrameView &frame) {
+                       if (chance(rng) < drop) {
+                         return;
+                       }
+                       uint8_t *bytes = const_cast<uint8_t *>(frame.data);
+                       if (frame.size > 0 && chance(rng) < corrupt) {
+                         bytes[rng() % frame.size] ^= 0x5A;
+                       }
+                       device.handle(bytes, frame.size);
+                     });
+      }
+    } else if (ready > 0 && (pfd.revents & (POLLHUP | POLLERR))) {
+      // Nobody on the other end yet; do not spin.
+      ::usleep(10000);
+    }
+
+    Clock::time_point now = Clock::now();
+    while (!replies.empty() && replies.front().due <= now) {
+      if (!writeAll(fd, replies.front().wire)) {
+        std::perror("write");
+        return 1;
+      }
+      replies.pop_front();
+    }
+  }
+
+  if (slave_fd >= 0) {
+    ::close(slave_fd);
+  }
+  ::close(fd);
+  return 0;
+}